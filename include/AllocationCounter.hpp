@@ -0,0 +1,25 @@
+#pragma once
+
+#include <cstddef>
+
+/**
+ * Heap allocation counting.
+ *
+ * AllocationCounter.cpp replaces the global operator new with a malloc-based
+ * one that, on threads that turned counting on, also bumps a thread-local
+ * counter, so a hot path can be checked for allocations by reading the
+ * counter before and after it. Counting is off by default; then every
+ * allocation costs one thread-local test more than with the default
+ * operator new.
+ */
+
+/**
+ * @brief Starts or stops counting the calling thread's allocations.
+ */
+void countThreadAllocations(bool enabled);
+
+/**
+ * @brief Number of operator new calls the calling thread made while
+ * counting.
+ */
+size_t threadAllocationCount();
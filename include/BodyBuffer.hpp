@@ -0,0 +1,62 @@
+#pragma once
+
+#include <vector>
+#include <cstddef>
+#include "Point.hpp"
+
+/**
+ * Ring buffer of body cells, head first.
+ *
+ * Unlike a std::deque, the cells live in one power-of-two array that is only reallocated when the snake grows longer
+ * than it has ever been, and clear() keeps the storage, so a snake that is
+ * reset and replayed game after game stops allocating altogether.
+ */
+class BodyBuffer {
+public:
+    BodyBuffer() : cells(64), start(0), count(0) {}
+
+    size_t size() const { return count; }
+    bool empty() const { return count == 0; }
+
+    Point& operator[](size_t index) { return cells[(start + index) & (cells.size() - 1)]; }
+    const Point& operator[](size_t index) const { return cells[(start + index) & (cells.size() - 1)]; }
+
+    Point& front() { return (*this)[0]; }
+    const Point& front() const { return (*this)[0]; }
+    Point& back() { return (*this)[count - 1]; }
+    const Point& back() const { return (*this)[count - 1]; }
+
+    void clear() {
+        start = 0;
+        count = 0;
+    }
+
+    void push_front(Point p) {
+        if (count == cells.size()) grow();
+        start = (start - 1) & (cells.size() - 1);
+        cells[start] = p;
+        count++;
+    }
+
+    void push_back(Point p) {
+        if (count == cells.size()) grow();
+        cells[(start + count) & (cells.size() - 1)] = p;
+        count++;
+    }
+
+    void pop_back() { count--; }
+
+private:
+    std::vector<Point> cells;
+    size_t start;
+    size_t count;
+
+    void grow() {
+        std::vector<Point> larger(cells.size() * 2);
+        for (size_t i = 0; i < count; ++i) {
+            larger[i] = (*this)[i];
+        }
+        cells.swap(larger);
+        start = 0;
+    }
+};
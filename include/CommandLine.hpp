@@ -0,0 +1,57 @@
+#pragma once
+
+#include "Sweep.hpp"
+#include "Headless.hpp"
+#include "OptimizerBenchmark.hpp"
+#include "KernelBenchmark.hpp"
+#include "DiffTest.hpp"
+#include "Trainer.hpp"
+
+enum class RunMode {
+    Interactive,
+    Headless,
+    Sweep,
+    TailLog,
+    Benchmark,
+    AllocationCheck,
+    ScreeningComparison,
+    TrajectorySummary,
+    SparseBenchmark,
+    LayerBenchmark,
+    ScalingReport,
+    PrecisionComparison,
+    DiffTest,
+    ExportCheck
+};
+
+/**
+ * @brief Everything that can be set from the command line.
+ */
+struct CommandLine {
+    RunMode mode = RunMode::Interactive;
+    TrainerOptions trainer;
+    HeadlessOptions headless;
+    SweepOptions sweep;
+    BenchmarkOptions benchmark;
+    SparseBenchmarkOptions sparseBenchmark;
+    LayerBenchmarkOptions layerBenchmark;
+    // Chrome trace written on exit, empty for none
+    std::string tracePath;
+    // Unix socket the live metrics are served on, empty for none
+    std::string metricsSocket;
+    DiffTestOptions diffTest;
+    // generation log printed by --tail-log
+    std::string tailLogPath;
+    // where --check-export writes its headers
+    std::string exportCheckDir;
+    // trajectory file summarized by --read-trajectories
+    std::string trajectoryPath;
+};
+
+/**
+ * @brief Parses argv into a CommandLine.
+ * @return false (after printing the problem and the usage) on bad input.
+ */
+bool parseCommandLine(int argc, char* argv[], CommandLine& commandLine);
+
+void printUsage(const char* program);
@@ -0,0 +1,81 @@
+#pragma once
+
+#include <vector>
+#include <string>
+#include <cstddef>
+#include <cstdint>
+
+/**
+ * @brief Settings of the differential test.
+ */
+struct DiffTestOptions {
+    // full topologies to test, inputs (11 or 24) first and OUTPUT_NODES last
+    std::vector<std::vector<size_t>> topologies = { {11, 8, 3}, {24, 8, 3}, {11, 16, 8, 3}, {24, 64, 64, 3} };
+    // policies of each kind (random, pruned, evolved) per topology
+    size_t policies = 200;
+    // games the lockstep engine plays per policy
+    size_t episodes = 4;
+    uint64_t seed = 1;
+    size_t threads = 0;
+};
+
+/**
+ * Plays the same seeded games on a reference simulator and on every
+ * engine the trainer actually uses, checks the optimized parts of the
+ * simulation against plain implementations, and reports every difference.
+ *
+ * The reference shares no code with the engines: the game rules and both
+ * sensor layouts written out plainly on a deque of cells, and a network
+ * evaluated straight from the genes, one dot product per neuron (see
+ * ReferenceGame and ReferenceNetwork in DiffTest.cpp). It steps until
+ * starvation or the step budget. Against it:
+ *
+ * - EvalContext::evaluate without loop detection: identical fitness, steps
+ *   and score.
+ * - EvalContext::evaluate with loop detection (and evaluate_brain_fitness,
+ *   which uses it): identical fitness and score, and the steps played plus
+ *   the steps saved equal the reference's steps.
+ * - EvalContext::evaluateEpisodes: the episodes' sensors batched through
+ *   feedForwardBatch, identical to the mean of the reference games.
+ * - EvalContext::evaluate on the policy grown by a neuron or a layer (see
+ *   Morphism.hpp): identical fitness, steps and score.
+ * - the snakesim C ABI, given the reference's actions: identical
+ *   observations, scores and deaths at every step of the game.
+ *
+ * Policies come in three kinds per topology: random genes, random genes
+ * with 95% zeros (so the sparse layer kernel runs), and the rows of a
+ * population trained with the GA as the test goes.
+ *
+ * Besides the games it checks:
+ *
+ * - OccupancyGrid::distanceTo, the bitmap ray cast behind the ray sensors,
+ *   against a walk over the cells, on random boards in all 8 directions.
+ * - feedForwardBatch against feedForward row by row, bit for bit, on random
+ *   genes and on genes with 95% zeros, with sensor-like inputs (half zeros)
+ *   and batches of several sizes.
+ * - every layer on the sparse kernel (density 1) against every layer dense
+ *   (density 0), bit for bit.
+ * - every AddNeuron and InsertLayer a topology allows (see Morphism.hpp):
+ *   the grown network gives the outputs of the original, bit for bit.
+ * - narrow GeneStore rows: every finite fp16 and bfloat16 value comes back
+ *   unchanged, and random doubles come back rounded to the nearest value,
+ *   ties to even.
+ * - rows spanning several chunks written through TrajectoryWriter into a
+ *   temporary file and read back with TrajectoryReader, field for field.
+ *
+ * The policies, the training run, the game seeds and everything else random
+ * derive from options.seed, so a failure repeats exactly with the same
+ * options.
+ */
+int runDiffTest(const DiffTestOptions& options);
+
+/**
+ * @brief First half of the export check: writes, into dir, one policy
+ * header (see exportPolicyHeader) per tested topology and activation pair, the
+ * outputs NeuralNetwork::feedForward gives for all 2^11 binary sensor
+ * states of each, and check.cpp, which includes every header and compares
+ * its forward() with those outputs bit for bit. 'make difftest' compiles and
+ * runs check.cpp, which fails on any difference.
+ * @return Process exit code.
+ */
+int runExportCheck(const std::string& dir);
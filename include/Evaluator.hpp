@@ -0,0 +1,195 @@
+#pragma once
+
+#include <vector>
+#include <memory>
+#include <cstddef>
+#include <climits>
+#include "Snake.hpp"
+#include "Food.hpp"
+#include "World.hpp"
+#include "NeuralNetwork.hpp"
+#include "Zobrist.hpp"
+#include "Trajectory.hpp"
+
+// a game ends once more than this many steps pass without food
+const int STARVATION_STEPS = 150;
+
+/**
+ * @brief How a game that was cut short by loop detection is scored.
+ */
+enum class LoopScoring {
+    // count the steps the game would have run until starvation or the step
+    // budget, so fitness is exactly what it was without loop detection
+    CreditRemaining,
+    // count only the steps actually played, which penalizes looping
+    StopCounting
+};
+
+/**
+ * @brief How the fitness of several episodes becomes one fitness.
+ */
+enum class EpisodeAggregate {
+    Mean,
+    Min,
+    // the aggregateQuantile-th smallest fitness (nearest rank)
+    Quantile
+};
+
+/**
+ * @brief Settings shared by every game played during evaluation.
+ */
+struct EvalConfig {
+    int maxSteps = 2500;
+    int width = 800;
+    int height = 600;
+    // end a game as soon as the world state repeats since the last food or reset
+    bool detectLoops = true;
+    LoopScoring loopScoring = LoopScoring::CreditRemaining;
+    NetworkActivations activations;
+    // games per individual and generation; with more than one, every
+    // individual plays the same food seeds (common random numbers)
+    int episodes = 1;
+    EpisodeAggregate aggregate = EpisodeAggregate::Mean;
+    double aggregateQuantile = 0.25;
+    // layers with at most this share of nonzero weights use the sparse
+    // kernel (see NeuralNetwork::setSparseDensity)
+    double sparseDensity = SPARSE_DENSITY;
+};
+
+/**
+ * @brief Outcome of one evaluation game.
+ */
+struct GameResult {
+    double fitness;
+    int steps;
+    int score;
+    // steps not simulated because the game was ended as a loop
+    int stepsSaved;
+    // the game was still running when it hit the step limit passed to
+    // evaluate(), so fitness only covers the steps played
+    bool truncated;
+};
+
+/**
+ * Everything one evaluation game needs, allocated once and reused.
+ *
+ * Each worker keeps its own context, which holds one world per episode (see
+ * EvalConfig::episodes). The episodes of a brain run in lockstep: every step
+ * the sensors of all running games go through the network as one batch, so
+ * each weight row is loaded once per step instead of once per game.
+ *
+ * Between games the worlds are reset in place, the body buffers and the
+ * visited-state sets keep their storage, and the network is only rebuilt
+ * when the topology changes (its activations come from the config); the
+ * genes are copied in from a read-only view of the population's row. After
+ * the first game on a context, evaluate() does not touch the heap.
+ */
+class EvalContext {
+public:
+    explicit EvalContext(const EvalConfig& config);
+
+    EvalContext(const EvalContext&) = delete;
+    EvalContext& operator=(const EvalContext&) = delete;
+
+    /**
+     * @brief Plays one headless game with the given genes and scores it.
+     * @param topology Layer sizes of the network the genes belong to.
+     * @param genes Gene row of the individual.
+     * @param geneCount Length of the gene row.
+     * @param seed Seed of the food positions; the same genes and seed always
+     * play the same game.
+     * @param stepLimit Stops the game after this many steps. A cut game is
+     * an exact prefix of the full one: it is scored as if config.maxSteps
+     * applied and flagged as truncated.
+     */
+    GameResult evaluate(const std::vector<size_t>& topology, const double* genes, size_t geneCount, uint64_t seed,
+                        int stepLimit = INT_MAX);
+
+    /**
+     * @brief Plays config.episodes games in lockstep and aggregates them.
+     * @param seeds One food seed per episode.
+     * @return The aggregated fitness; steps and saved steps summed over the
+     * episodes, the best episode's score, and truncated if any game was cut.
+     */
+    GameResult evaluateEpisodes(const std::vector<size_t>& topology, const double* genes, size_t geneCount,
+                                const uint64_t* seeds, int stepLimit = INT_MAX);
+
+    size_t getEpisodeCount() const { return episodes.size(); }
+
+    /**
+     * @brief Room for one gene row of count doubles, owned by this context,
+     * for widening genes that are stored narrow (see GeneStore). Only grows.
+     */
+    double* geneScratch(size_t count) {
+        if (wideGenes.size() < count) wideGenes.resize(count);
+        return wideGenes.data();
+    }
+
+    /**
+     * @brief Records the sampled games of this context into one ring of
+     * writer, or stops recording if writer is null.
+     */
+    void recordTrajectories(TrajectoryWriter* writer, size_t producer);
+
+    /**
+     * @brief Generation and individual stored with the recorded steps of the
+     * following games.
+     */
+    void setGameTag(uint32_t generation, uint32_t individual) {
+        tagGeneration = generation;
+        tagIndividual = individual;
+    }
+
+private:
+    /**
+     * @brief One game and its bookkeeping.
+     */
+    struct Episode {
+        Snake snake;
+        Food food;
+        World world;
+        VisitedStates visited;
+        uint64_t epoch;
+        int steps;
+        int scoreAtLastFood;
+        int stepsSinceLastFood;
+        int stepsSaved;
+        bool ended;
+        bool recording;
+        uint16_t index;
+        // steps + 1000 per food after the last recorded step
+        double lastFitness;
+
+        Episode(const EvalConfig& config, uint16_t index);
+        GameResult result(const EvalConfig& config);
+    };
+
+    EvalConfig config;
+    std::vector<std::unique_ptr<Episode>> episodes;
+    std::unique_ptr<NeuralNetwork> brain;
+    // running episodes of the current step, their stacked sensors and fitnesses
+    std::vector<Episode*> running;
+    std::vector<double> batchInputs;
+    std::vector<double> episodeFitness;
+    std::vector<double> wideGenes;
+    TrajectoryWriter* trajectoryWriter = nullptr;
+    TrajectoryRing* trajectoryRing = nullptr;
+    uint32_t tagGeneration = 0;
+    uint32_t tagIndividual = 0;
+
+    void play(const std::vector<size_t>& topology, const double* genes, size_t geneCount,
+              const uint64_t* seeds, size_t count, int stepLimit);
+};
+
+/**
+ * @brief Plays one headless game with the given brain on a temporary
+ * EvalContext and scores it. Convenient for one-off games; training loops
+ * keep a context per worker instead.
+ * @param topology Layer sizes of the network the genes belong to.
+ * @param genes Gene row of the individual.
+ * @param config Board size, step budget and loop handling.
+ * @param seed Seed of the food positions.
+ * @return Fitness (steps survived + 1000 per food) plus raw step and food counts.
+ */
+GameResult evaluate_brain_fitness(const std::vector<size_t>& topology, const std::vector<double>& genes, const EvalConfig& config,
+                                  uint64_t seed = 0);
@@ -0,0 +1,51 @@
+#pragma once
+
+#include <vector>
+#include "Optimizer.hpp"
+
+/**
+ * OpenAI-style evolution strategy (Salimans et al. 2017).
+ *
+ * Row 0 is the search mean; the other rows are antithetic pairs
+ * mean + sigma * eps and mean - sigma * eps. Fitness is replaced by centered
+ * ranks, and the resulting gradient estimate drives an Adam step on the mean.
+ * Each eps is regenerated from its counter-based stream when the gradient is
+ * formed, so no noise is stored between generations.
+ */
+class EvolutionStrategy : public Optimizer {
+public:
+    EvolutionStrategy();
+
+    const char* getName() const override { return "es"; }
+    void reset(GeneStore& genes, size_t popSize, size_t geneCount, uint64_t seed, ThreadPool& pool) override;
+    void evolve(const GeneStore& genes, const double* fitness, const FitnessStats& stats,
+                size_t generation, GeneStore& next, ThreadPool& pool) override;
+    void morph(GeneStore& genes, size_t geneCount, size_t generation, ThreadPool& pool) override;
+    void setMutation(double rate, double strength) override;
+
+private:
+    size_t popSize;
+    size_t geneCount;
+    uint64_t seed;
+    double sigma;
+    double learningRate;
+
+    std::vector<double> mean;
+    // Adam moments
+    std::vector<double> adamM;
+    std::vector<double> adamV;
+    size_t adamStep;
+
+    // centered rank of every row, row 0 (the mean itself) always 0
+    std::vector<double> shaped;
+    std::vector<size_t> order;
+
+    void shapeFitness(const double* fitness);
+    // one row per worker for candidates that are stored narrow
+    std::vector<double> scratch;
+
+    // sizes the state for geneCount genes, starts the search at row 0 and
+    // writes the candidates of `generation` over the rows
+    void restart(GeneStore& genes, size_t geneCount, size_t generation, ThreadPool& pool);
+    void writeCandidates(GeneStore& rows, size_t generation, ThreadPool& pool);
+};
@@ -0,0 +1,21 @@
+#pragma once
+
+#include <string>
+#include "NeuralNetwork.hpp"
+
+/**
+ * @brief Writes a network as a self-contained C++ inference header.
+ *
+ * The header holds the topology and weights as constexpr arrays and an
+ * unrolled, allocation-free forward pass that does not depend on
+ * NeuralNetwork, <functional> or SDL. Every neuron sums its terms in the same
+ * order as NeuralNetwork::feedForward, so as long as the consumer compiles
+ * without floating-point contraction (-ffp-contract=off, no -ffast-math) the
+ * outputs match bit for bit.
+ *
+ * @param brain The network to export.
+ * @param path File to write.
+ * @param name Namespace of the generated code, must be a valid identifier.
+ * @return false if the file could not be written.
+ */
+bool exportPolicyHeader(const NeuralNetwork& brain, const std::string& path, const std::string& name = "snake_policy");
@@ -2,6 +2,7 @@
 #pragma once
 
 #include <SDL2/SDL.h>
+#include <cstdint>
 
 #include "Point.hpp"
 
@@ -31,4 +32,15 @@ public:
      * @param max_y Max bound in Y direction
      */
     void move_randomly(int max_x, int max_y);
+
+    /**
+     * @brief Restarts the food's random stream, so the same seed gives the
+     * same sequence of positions. Every food starts on its own unseeded
+     * stream, which is safe to use from many threads at once.
+     */
+    void seed(uint64_t seed);
+
+private:
+    uint64_t rng_key;
+    uint64_t rng_counter;
 };
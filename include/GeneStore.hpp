@@ -0,0 +1,79 @@
+#pragma once
+
+#include <vector>
+#include <string>
+#include <cstddef>
+#include <cstdint>
+#include "Numa.hpp"
+
+/**
+ * @brief How a population's genes are held in memory.
+ */
+enum class GenePrecision {
+    Double,
+    // IEEE half: 11 significant bits, finite up to 65504
+    Float16,
+    // bfloat16: the top half of a float, 8 significant bits
+    BFloat16
+};
+
+/**
+ * @brief Short name used on the command line and in reports: double, fp16, bf16.
+ */
+const char* genePrecisionName(GenePrecision precision);
+
+/**
+ * @brief Parses a name printed by genePrecisionName.
+ * @return false if the name is unknown.
+ */
+bool parseGenePrecision(const std::string& name, GenePrecision& precision);
+
+/**
+ * One contiguous block of gene rows, stored as double or narrowed to 16 bits.
+ *
+ * Readers and writers always see doubles: read() widens a narrow row into
+ * caller-owned scratch, and a row is written by filling the buffer from
+ * writeBuffer() and handing it to commit(), which rounds it to nearest even
+ * (saturating at the largest finite value). For double rows both hand out
+ * the row itself, so nothing is copied. Values that came out of a narrow row
+ * round-trip exactly, so an elite copied through a double buffer is
+ * unchanged.
+ *
+ * The block is allocated untouched (see FirstTouchAllocator).
+ */
+class GeneStore {
+public:
+    GeneStore();
+
+    void allocate(size_t rows, size_t geneCount, GenePrecision precision);
+    void swap(GeneStore& other);
+
+    size_t getRows() const { return rows; }
+    size_t getGeneCount() const { return geneCount; }
+    GenePrecision getPrecision() const { return precision; }
+    size_t getRowBytes() const;
+
+    /**
+     * @brief The genes of one row as doubles.
+     * @param scratch geneCount doubles, filled unless the row is stored as double.
+     */
+    const double* read(size_t row, double* scratch) const;
+
+    /**
+     * @brief Where to build a new version of row: the row itself for double
+     * storage, otherwise scratch. Finish with commit(row, buffer).
+     */
+    double* writeBuffer(size_t row, double* scratch);
+
+    /**
+     * @brief Stores geneCount doubles into row.
+     */
+    void commit(size_t row, const double* values);
+
+private:
+    size_t rows;
+    size_t geneCount;
+    GenePrecision precision;
+    std::vector<double, FirstTouchAllocator<double>> wide;
+    std::vector<uint16_t, FirstTouchAllocator<uint16_t>> narrow;
+};
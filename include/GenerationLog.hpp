@@ -0,0 +1,137 @@
+#pragma once
+
+#include <cstdint>
+#include <cstddef>
+#include <string>
+#include <vector>
+
+/**
+ * Append-only binary log with one fixed-size record per generation.
+ *
+ * Layout: a 4 KiB header page followed by GenerationRecords back to back.
+ * The writer maps only the header and the chunk it is filling, and the
+ * reader maps the file read-only, so memory use stays flat no matter how
+ * many generations are logged. The header's record count is published with
+ * release ordering after each record is written, so another process can map
+ * the same file and tail it while training runs.
+ */
+
+/**
+ * @brief Statistics of one generation, 128 bytes on disk.
+ */
+struct GenerationRecord {
+    uint64_t generation;
+    uint64_t evaluations;
+    uint64_t steps;
+    uint64_t championHash;
+    double best;
+    double average;
+    double median;
+    double p10;
+    double p25;
+    double p75;
+    double p90;
+    double worst;
+    double evalSeconds;
+    double evolveSeconds;
+    // steps skipped by loop detection
+    uint64_t stepsSaved;
+    // individuals given full games after screening
+    uint64_t promoted;
+};
+
+static_assert(sizeof(GenerationRecord) == 128, "GenerationRecord is an on-disk format");
+
+struct GenerationLogHeader {
+    char magic[8];
+    uint32_t version;
+    uint32_t recordSize;
+    uint64_t count;
+    uint32_t layers;
+    uint32_t topology[16];
+    // set when the writer closes the log, so tailing tools know to stop
+    uint32_t finished;
+    char padding[4096 - 96];
+};
+
+static_assert(sizeof(GenerationLogHeader) == 4096, "the header fills exactly one page");
+
+class GenerationLogWriter {
+public:
+    GenerationLogWriter();
+    ~GenerationLogWriter();
+
+    GenerationLogWriter(const GenerationLogWriter&) = delete;
+    GenerationLogWriter& operator=(const GenerationLogWriter&) = delete;
+
+    /**
+     * @brief Creates (or truncates) the log file.
+     * @return false if the file could not be created or mapped.
+     */
+    bool open(const std::string& path, const std::vector<size_t>& topology);
+    void close();
+    bool isOpen() const { return fd >= 0; }
+
+    void append(const GenerationRecord& record);
+
+    /**
+     * @brief Schedules the written pages for write-back (msync MS_ASYNC).
+     */
+    void flush();
+
+private:
+    // records per mapped chunk (1 MiB)
+    static const size_t CHUNK_RECORDS = 8192;
+    static const size_t FLUSH_EVERY = 64;
+
+    int fd;
+    GenerationLogHeader* header;
+    GenerationRecord* chunk;
+    uint64_t chunkStart;
+    uint64_t count;
+
+    bool mapChunk(uint64_t first);
+};
+
+class GenerationLogReader {
+public:
+    GenerationLogReader();
+    ~GenerationLogReader();
+
+    GenerationLogReader(const GenerationLogReader&) = delete;
+    GenerationLogReader& operator=(const GenerationLogReader&) = delete;
+
+    bool open(const std::string& path);
+    void close();
+    bool isOpen() const { return fd >= 0; }
+
+    /**
+     * @brief Picks up records appended since the last call, remapping if
+     * the file grew.
+     * @return The number of complete records available.
+     */
+    size_t refresh();
+
+    size_t size() const { return count; }
+    bool isFinished() const;
+    const GenerationRecord& operator[](size_t index) const { return records[index]; }
+
+private:
+    int fd;
+    const char* map;
+    size_t mappedBytes;
+    const GenerationRecord* records;
+    size_t count;
+};
+
+/**
+ * @brief 64-bit hash of a gene row, to tell champions apart in the log.
+ */
+uint64_t hashGenes(const double* genes, size_t count);
+
+/**
+ * @brief Prints the records of a log as they are appended, until the writer
+ * closes it.
+ * @return Process exit code.
+ */
+int tailGenerationLog(const std::string& path);
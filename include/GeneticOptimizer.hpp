@@ -0,0 +1,37 @@
+#pragma once
+
+#include <vector>
+#include "Optimizer.hpp"
+
+/**
+ * The original genetic algorithm: elitism, tournament selection, uniform
+ * crossover and Bernoulli-gated Gaussian mutation clamped to [-1, 1],
+ * optionally followed by magnitude pruning. A pruned gene stays zero until a
+ * mutation pushes it back over the threshold.
+ */
+class GeneticOptimizer : public Optimizer {
+public:
+    GeneticOptimizer();
+
+    const char* getName() const override { return "ga"; }
+    void reset(GeneStore& genes, size_t popSize, size_t geneCount, uint64_t seed, ThreadPool& pool) override;
+    void evolve(const GeneStore& genes, const double* fitness, const FitnessStats& stats,
+                size_t generation, GeneStore& next, ThreadPool& pool) override;
+    void morph(GeneStore& genes, size_t geneCount, size_t generation, ThreadPool& pool) override;
+    void setMutation(double rate, double strength) override;
+    void setPruning(double threshold) override { pruneThreshold = threshold; }
+
+private:
+    size_t popSize;
+    size_t geneCount;
+    uint64_t seed;
+    double mutationRate;
+    double mutationStrength;
+    double pruneThreshold;
+    // three rows per worker (two parents, one child) for narrow storage
+    std::vector<double> scratch;
+
+    size_t selectParent(const double* fitness, uint64_t key, uint64_t& counter) const;
+    void crossover(const double* parentA, const double* parentB, double* child, uint64_t key) const;
+    void mutate(double* child, uint64_t key) const;
+};
@@ -0,0 +1,73 @@
+#pragma once
+
+#include <string>
+#include <vector>
+#include <cstddef>
+#include "Evaluator.hpp"
+#include "Optimizer.hpp"
+#include "TrainingRun.hpp"
+#include "World.hpp"
+
+/**
+ * @brief Settings of a single training run without a window.
+ */
+struct HeadlessOptions {
+    size_t inputNodes = INPUT_NODES;
+    std::vector<size_t> hiddenLayers = { 8 };
+    size_t populationSize = 500;
+    size_t generations = 100;
+    size_t threads = 0;
+    // pin workers to CPUs and shard loops by NUMA node (see ThreadPool)
+    bool pinThreads = false;
+    OptimizerType optimizer = OptimizerType::Genetic;
+    // storage of the population's genes; narrow rows are widened per worker
+    GenePrecision precision = GenePrecision::Double;
+    // GA magnitude pruning threshold (see Optimizer::setPruning), 0 for none
+    double pruneThreshold = 0.0;
+    EvalConfig eval;
+    ScreeningConfig screening;
+    // training runs per setting in the screening comparison
+    size_t repeats = 3;
+    // generation log (see GenerationLog.hpp), empty for none
+    std::string logPath;
+    // trajectory dataset (see Trajectory.hpp), empty for none
+    std::string trajectoryPath;
+    TrajectoryOptions trajectory;
+};
+
+/**
+ * @brief Trains one population for a fixed number of generations and prints
+ * a line per generation. Also the workload the PGO build is trained on.
+ * @return Process exit code.
+ */
+int runHeadless(const HeadlessOptions& options);
+
+/**
+ * @brief Plays games on one warmed-up EvalContext and counts the heap
+ * allocations they make; anything but zero is reported as a failure.
+ * @return Process exit code.
+ */
+int runAllocationCheck(const HeadlessOptions& options);
+
+/**
+ * @brief Trains with and without screening for the same number of generations
+ * and compares the steps simulated with the champions' fitness on held-out
+ * games.
+ * @return Process exit code.
+ */
+int runScreeningComparison(const HeadlessOptions& options);
+
+/**
+ * @brief Trains with genes stored as double, fp16 and bf16 and compares the
+ * memory per individual with the champions' fitness on held-out games.
+ * @return Process exit code.
+ */
+int runPrecisionComparison(const HeadlessOptions& options);
+
+/**
+ * @brief Trains for the same number of generations on 1, 2, 4, ... workers
+ * up to every allowed CPU and prints the simulation throughput and parallel
+ * efficiency of each, with the node count and cross-node steals.
+ * @return Process exit code.
+ */
+int runScalingReport(const HeadlessOptions& options);
@@ -0,0 +1,47 @@
+#pragma once
+
+#include <vector>
+#include <string>
+#include <cstddef>
+
+/**
+ * @brief Settings of the sparse-versus-dense layer benchmark.
+ */
+struct SparseBenchmarkOptions {
+    // square hidden layers (width inputs, width neurons) to time
+    std::vector<size_t> widths = { 8, 32, 128, 512 };
+    // shares of nonzero weights to time at every width
+    std::vector<double> densities = { 1.0, 0.7, 0.5, 0.4, 0.3, 0.2, 0.1, 0.05, 0.02 };
+    std::string outputPath = "sparse.csv";
+};
+
+/**
+ * @brief Times denseLayer against sparseLayer on randomly pruned layers and
+ * prints, per width, the highest density at which the sparse kernel wins.
+ * Also times an input layer fed binary sensors with few of them active, the
+ * case the dense kernel's zero skipping is for.
+ * @return Process exit code; 1 if the kernels disagree.
+ */
+int runSparseBenchmark(const SparseBenchmarkOptions& options);
+
+/**
+ * @brief Settings of the blocked-layer benchmark.
+ */
+struct LayerBenchmarkOptions {
+    // square hidden layers (width inputs, width neurons) to time
+    std::vector<size_t> widths = { 8, 16, 32, 64, 128, 256, 512, 1024 };
+    // input vectors per call; 1 times denseLayer, more denseLayerBatch
+    std::vector<size_t> batches = { 1, 8 };
+    // share of the layer inputs that are zero, as behind a ReLU layer
+    double zeroShare = 0.5;
+    std::string outputPath = "layers.csv";
+};
+
+/**
+ * @brief Times the blocked kernels (denseLayer for one input vector,
+ * denseLayerBatch on packed weights for several) against a plain reference
+ * that computes each neuron's dot product with its weight row in turn, and
+ * a whole 11-W-W-3 network per width.
+ * @return Process exit code; 1 if a kernel disagrees with the reference.
+ */
+int runLayerBenchmark(const LayerBenchmarkOptions& options);
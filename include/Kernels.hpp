@@ -0,0 +1,103 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+/**
+ * Numeric hot loops, compiled once per ISA level.
+ *
+ * Functions marked SNAKE_DISPATCH are built as SSE4.2, AVX2, AVX-512 and
+ * baseline clones; the loader picks the best one for the running CPU through
+ * CPUID (GCC/Clang target_clones on x86-64 Linux), so one binary runs at full
+ * speed on every machine. The makefile builds with -ffp-contract=off, so all
+ * clones produce bit-identical results.
+ *
+ * Define SNAKE_NO_DISPATCH to build only the baseline version.
+ */
+#if defined(__x86_64__) && defined(__linux__) && defined(__GNUC__) && !defined(SNAKE_NO_DISPATCH)
+#define SNAKE_DISPATCH __attribute__((target_clones("avx512f", "avx2", "sse4.2", "default")))
+#else
+#define SNAKE_DISPATCH
+#endif
+
+/**
+ * @brief Neurons per panel: the kernels keep the sums of this many neurons
+ * in registers while they stream the weights.
+ */
+const size_t PANEL_WIDTH = 16;
+
+/**
+ * @brief Inputs per block of a packed weight matrix.
+ */
+const size_t PANEL_INPUTS = 256;
+
+/**
+ * @brief Index of the weight from input p to neuron n in a packed layer, the
+ * layout denseLayerBatch reads.
+ *
+ * The inputs are cut into blocks of PANEL_INPUTS and, within a block, the
+ * neurons into panels of PANEL_WIDTH (the last block and panel may be
+ * smaller). Blocks follow each other, panels follow each other within a
+ * block, and each panel is input-major, so one block of one panel is a
+ * contiguous tile that stays in L1 while the whole batch goes through it. A
+ * layer of at most PANEL_WIDTH neurons is plain input-major
+ * (weights[p * neurons + n]).
+ */
+inline size_t packedWeightIndex(size_t p, size_t n, size_t inputs, size_t neurons) {
+    size_t block = p - p % PANEL_INPUTS;
+    size_t rows = inputs - block < PANEL_INPUTS ? inputs - block : PANEL_INPUTS;
+    size_t first = n - n % PANEL_WIDTH;
+    size_t width = neurons - first < PANEL_WIDTH ? neurons - first : PANEL_WIDTH;
+    return block * neurons + first * rows + (p - block) * width + (n - first);
+}
+
+/**
+ * @brief One fully connected layer without activation:
+ * output[n] = biases[n] + sum over p of input[p] * weights[p * neurons + n].
+ *
+ * Weights are stored input-major, so skipping an input skips a whole
+ * contiguous row: inputs that are zero are skipped, which makes binary
+ * sensors and ReLU outputs only cost their active entries, also in memory
+ * traffic once a layer outgrows the caches. The kernel gathers the nonzero
+ * inputs a few at a time and adds their rows to one panel of neurons after
+ * another, with the panel's sums in registers. Each neuron still accumulates
+ * its terms in input order, and skipped terms are exact zeros, so the sums
+ * compare equal to the full ones.
+ */
+void denseLayer(const double* weights, const double* biases, const double* input,
+                double* output, size_t inputs, size_t neurons);
+
+/**
+ * @brief denseLayer for `batch` input vectors at once, on weights packed as
+ * in packedWeightIndex. Inputs and outputs are row-major
+ * (input[b * inputs + p], output[b * neurons + n]). A block of one panel is
+ * applied to the whole batch, a few rows at a time with their sums in
+ * registers, before the next is loaded, and every neuron sums its terms in
+ * the same order as denseLayer, so results compare equal.
+ */
+void denseLayerBatch(const double* weights, const double* biases, const double* input,
+                     double* output, size_t inputs, size_t neurons, size_t batch);
+
+/**
+ * @brief One layer in compressed sparse row form, without activation:
+ * output[n] = biases[n] + sum over k in [rowStart[n], rowStart[n + 1]) of
+ * input[columns[k]] * values[k].
+ *
+ * Rows are neurons and columns ascend within a row, so every neuron adds its
+ * nonzero terms in the same order as denseLayer and the sums compare equal.
+ */
+void sparseLayer(const double* values, const uint32_t* columns, const uint32_t* rowStart,
+                 const double* biases, const double* input, double* output, size_t neurons);
+
+/**
+ * @brief sparseLayer for `batch` row-major input vectors at once; each row's
+ * entries are applied to the whole batch before moving on.
+ */
+void sparseLayerBatch(const double* values, const uint32_t* columns, const uint32_t* rowStart,
+                      const double* biases, const double* input, double* output,
+                      size_t inputs, size_t neurons, size_t batch);
+
+/**
+ * @brief Name of the widest ISA level the dispatched kernels use on this CPU.
+ */
+const char* cpuDispatchLevel();
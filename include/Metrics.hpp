@@ -0,0 +1,111 @@
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <cstddef>
+#include <string>
+#include <thread>
+
+/**
+ * Live training metrics, served in Prometheus text format on a Unix socket.
+ *
+ * The hot paths (TrainingRun, ThreadPool) write plain atomics with relaxed
+ * ordering and never take a lock; the server thread reads them when a
+ * client connects, so scraping never blocks training. Nothing is recorded
+ * until a MetricsServer starts, apart from the per-generation gauges, which
+ * cost one store each. A ThreadPool only publishes into the metrics it was
+ * handed (see ThreadPool::setMetrics), so pools outside training, like the
+ * simulation library's, do not touch them.
+ *
+ *   curl --unix-socket /tmp/snake.sock http://localhost/metrics
+ */
+
+/**
+ * @brief Upper bounds in seconds of the evaluation latency buckets; a last
+ * +Inf bucket catches the rest.
+ */
+const double EVAL_LATENCY_BUCKETS[] = { 1e-5, 3e-5, 1e-4, 3e-4, 1e-3, 3e-3, 1e-2, 3e-2, 0.1, 0.3, 1.0 };
+const size_t EVAL_LATENCY_BUCKET_COUNT = sizeof(EVAL_LATENCY_BUCKETS) / sizeof(EVAL_LATENCY_BUCKETS[0]);
+
+struct TrainingMetrics {
+    // workers of every pool share these slots by worker index
+    static const size_t MAX_WORKERS = 256;
+
+    // set while a server runs; gates the clock reads on the hot paths
+    std::atomic<bool> enabled{false};
+
+    // per generation, from TrainingRun::step
+    std::atomic<uint64_t> generation{0};
+    std::atomic<uint64_t> generations{0};
+    std::atomic<uint64_t> evaluations{0};
+    std::atomic<uint64_t> steps{0};
+    std::atomic<uint64_t> stepsSaved{0};
+    std::atomic<double> bestFitness{0.0};
+    std::atomic<double> averageFitness{0.0};
+    std::atomic<int> bestScore{0};
+    std::atomic<double> stepsPerSecond{0.0};
+    std::atomic<double> generationSeconds{0.0};
+
+    // per game, from TrainingRun::play: non-cumulative bucket counts
+    std::atomic<uint64_t> latencyBuckets[EVAL_LATENCY_BUCKET_COUNT + 1] = {};
+    std::atomic<uint64_t> latencyNanoseconds{0};
+
+    // from the ThreadPool
+    std::atomic<uint64_t> queuedItems{0};
+    std::atomic<uint64_t> workers{0};
+    std::atomic<uint64_t> busyNanoseconds[MAX_WORKERS] = {};
+
+    /**
+     * @brief Counts one evaluation that took the given time.
+     */
+    void recordEvaluation(uint64_t nanoseconds);
+};
+
+TrainingMetrics& trainingMetrics();
+
+/**
+ * @brief Monotonic nanoseconds for the metrics clocks.
+ */
+inline uint64_t metricsClock() {
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+/**
+ * @brief Background thread answering every connection on a Unix socket with
+ * the current metrics. Requests are read and ignored; the reply is an
+ * HTTP/1.0 response, which curl and Prometheus (through a socket proxy)
+ * both accept.
+ */
+class MetricsServer {
+public:
+    MetricsServer();
+    ~MetricsServer();
+
+    MetricsServer(const MetricsServer&) = delete;
+    MetricsServer& operator=(const MetricsServer&) = delete;
+
+    /**
+     * @brief Binds path (replacing a stale socket file) and starts serving.
+     * @return false if the socket could not be created.
+     */
+    bool start(const std::string& path);
+
+    /**
+     * @brief Stops the thread and removes the socket file.
+     */
+    void stop();
+
+private:
+    std::string path;
+    int listener;
+    std::thread thread;
+    std::atomic<bool> stopping;
+    // busy time and clock at the previous scrape, for utilization
+    uint64_t lastBusy;
+    uint64_t lastScrape;
+
+    void run();
+    std::string render();
+};
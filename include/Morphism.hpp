@@ -0,0 +1,58 @@
+#pragma once
+
+#include <vector>
+#include <cstddef>
+#include <cstdint>
+
+/**
+ * Function-preserving edits of a network's topology (network morphisms, as
+ * in Net2Net), applied to flat gene rows in the layout of
+ * NeuralNetwork::setGenes: per layer the biases, then the weights
+ * neuron-major.
+ *
+ * - AddNeuron appends a neuron to a hidden layer with random incoming
+ *   weights and bias and zero outgoing weights. The next layer adds its
+ *   contribution last, as x * 0, so every output is bit-for-bit unchanged.
+ * - RemoveNeuron drops a hidden neuron with its incoming and outgoing
+ *   weights. This changes the function unless the neuron contributed
+ *   nothing; pick the neuron with neuronContribution.
+ * - InsertLayer adds a hidden layer as wide as the layer before it with
+ *   identity weights and zero biases. Since the inputs and ReLU outputs are
+ *   never negative, this is exact for ReLU and identity hidden layers; with
+ *   sigmoid or tanh it is only a near-identity start.
+ */
+enum class MorphKind {
+    AddNeuron,
+    RemoveNeuron,
+    InsertLayer
+};
+
+struct Morph {
+    MorphKind kind;
+    // index into the topology: the hidden layer to grow or shrink, or the
+    // position the new layer takes (1 inserts right after the inputs)
+    size_t layer;
+    // the neuron RemoveNeuron drops
+    size_t neuron = 0;
+};
+
+/**
+ * @brief Topology after applying morph to topology.
+ * @throws std::invalid_argument if the morph does not fit the topology.
+ */
+std::vector<size_t> morphedTopology(const std::vector<size_t>& topology, const Morph& morph);
+
+/**
+ * @brief Writes the morphed copy of one gene row into out, which holds
+ * NeuralNetwork::geneCountFor(morphedTopology(topology, morph)) genes.
+ * @param key Stream of the random incoming weights of an added neuron.
+ */
+void applyMorph(const std::vector<size_t>& topology, const Morph& morph, const double* genes, double* out,
+                uint64_t key);
+
+/**
+ * @brief How much a hidden neuron can move the next layer: the sum of its
+ * absolute outgoing weights times its largest possible activation scale,
+ * |bias| plus the sum of its absolute incoming weights.
+ */
+double neuronContribution(const std::vector<size_t>& topology, size_t layer, size_t neuron, const double* genes);
@@ -1,15 +1,17 @@
 #pragma once
 
 #include <vector>
-#include <functional> 
 #include <string>
 #include <random>     
+#include <cstdint>
+#include "Activation.hpp"
 
-enum class ActivationType {
-    SIGMOID,
-    RELU,
-    TANH
-};
+/**
+ * @brief Default weight density at or below which a layer switches to the
+ * sparse kernel. From --benchmark-sparse: the compressed rows only win
+ * around 10-20% density for layers of 32 neurons and more.
+ */
+const double SPARSE_DENSITY = 0.1;
 
 class NeuralNetwork {
 public:
@@ -17,10 +19,16 @@ public:
      * @brief Creates a new neural network.
      * @param topology A vector of unsigned integers defining the number 
      * of neurons in each layer. (e.g., {5, 8, 3})
-     * @param funcType The activation function to use (e.g., RELU)
+     * @param funcType The activation function of every layer (e.g., RELU)
      */
     NeuralNetwork(const std::vector<size_t>& topology, ActivationType funcType);
 
+    /**
+     * @brief Creates a new neural network with separate hidden and output
+     * activations.
+     */
+    NeuralNetwork(const std::vector<size_t>& topology, const NetworkActivations& activations);
+
     /**
      * @brief Performs the feed-forward calculation.
      * @param inputs A vector of inputs matching the size of the first layer.
@@ -28,6 +36,23 @@ public:
      */
     std::vector<double> feedForward(const std::vector<double>& inputs);
 
+    /**
+     * @brief Allocation-free feed-forward through the network's own scratch
+     * buffers.
+     * @param inputs topology[0] input values.
+     * @return The output layer, valid until the next call.
+     */
+    const double* feedForward(const double* inputs);
+
+    /**
+     * @brief Feed-forward for several input vectors at once, bit-identical
+     * to calling feedForward on each.
+     * @param inputs batch rows of topology[0] values, back to back.
+     * @return batch rows of topology.back() outputs, valid until the next
+     * call. The scratch buffers only grow when a larger batch comes in.
+     */
+    const double* feedForwardBatch(const double* inputs, size_t batch);
+
     /**
      * @brief Gets all weights and biases as a single "gene" vector.
      */
@@ -38,27 +63,85 @@ public:
      */
     void setGenes(const std::vector<double>& genes);
 
+    /**
+     * @brief Sets all weights and biases from a raw gene row.
+     * @param genes Pointer to the first gene.
+     * @param count Number of genes in the row.
+     */
+    void setGenes(const double* genes, size_t count);
+
+    /**
+     * @brief Number of genes (weights and biases) a network of this topology has.
+     */
+    static size_t geneCountFor(const std::vector<size_t>& topology);
+
+    const std::vector<size_t>& getTopology() const { return topology; }
+
+    /**
+     * @brief Activation of each weight layer, the output layer last.
+     */
+    const std::vector<ActivationType>& getActivations() const { return activations; }
+
+    /**
+     * @brief Layers whose share of nonzero weights is at most density run
+     * through the sparse kernel from then on; 0 keeps every layer dense.
+     */
+    void setSparseDensity(double density);
+
+    /**
+     * @brief Share of nonzero weights over all layers (biases not counted).
+     */
+    double getWeightDensity() const;
+
+    /**
+     * @brief Number of layers currently using the sparse kernel.
+     */
+    size_t getSparseLayerCount() const;
+
 private:
     /**
-     * @brief A simple struct to represent a layer.
+     * @brief A simple struct to represent a layer. Weights are stored
+     * input-major (weights[p * neurons + n]) for the denseLayer kernel; the
+     * gene order stays neuron-major.
+     *
+     * setGenes also fills a compressed sparse row copy of the nonzero
+     * weights (neuron-major, inputs ascending, like the genes). The arrays
+     * are sized for a fully dense layer up front, so refilling them never
+     * allocates. The first batched feed-forward after the genes change
+     * packs another copy for denseLayerBatch (see packedWeightIndex).
      */
     struct Layer {
-        std::vector<std::vector<double>> weights;
+        std::vector<double> weights;
+        std::vector<double> packed;
         std::vector<double> biases;
+        size_t inputs;
+        size_t neurons;
+        std::vector<double> sparseValues;
+        std::vector<uint32_t> sparseColumns;
+        std::vector<uint32_t> rowStart;
+        size_t nonzero;
+        bool sparse;
     };
 
     std::vector<size_t> topology;
     std::vector<Layer> layers; 
-    std::function<double(double)> activation; 
+    std::vector<ActivationType> activations;
+    double sparseDensity = SPARSE_DENSITY;
+    // the packed copies match the weights
+    bool packedCurrent = false;
+
+    // ping-pong buffers for the layer outputs, as wide as the widest layer
+    // times the largest batch seen so far
+    std::vector<double> scratchA;
+    std::vector<double> scratchB;
+    size_t scratchBatch = 1;
 
-    static std::mt19937 randomEngine;
+    // one engine per thread, since workers may build networks concurrently
+    static thread_local std::mt19937 randomEngine;
 
     // Helpers
-    void setActivation(ActivationType funcType);
+    void buildLayers();
+    void chooseLayerFormats();
+    void packLayers();
     static double getRandomDouble();
-
-    // Activation functions
-    static double sigmoid(double x) { return 1.0 / (1.0 + std::exp(-x)); }
-    static double relu(double x) { return std::max(0.0, x); }
-    static double tanh(double x) { return std::tanh(x); }
 };
\ No newline at end of file
@@ -0,0 +1,66 @@
+#pragma once
+
+#include <vector>
+#include <string>
+#include <cstddef>
+#include <memory>
+#include <utility>
+
+/**
+ * @brief The NUMA nodes of this machine and the CPUs of each that the
+ * process may run on. Read from /sys/devices/system/node; anywhere that is
+ * missing (a single-node kernel, another OS) it is one node holding every
+ * allowed CPU.
+ */
+struct NumaTopology {
+    // allowed CPU ids per node, nodes without any left out
+    std::vector<std::vector<int>> nodeCpus;
+
+    size_t nodeCount() const { return nodeCpus.size(); }
+    size_t cpuCount() const;
+
+    static NumaTopology detect();
+
+    /**
+     * @brief A topology with every allowed CPU on one node.
+     */
+    static NumaTopology singleNode();
+
+    /**
+     * @brief E.g. "2 nodes (0-15, 16-31)".
+     */
+    std::string describe() const;
+};
+
+/**
+ * @brief Restricts the calling thread to one CPU.
+ * @return false if the kernel refused (the thread keeps floating).
+ */
+bool pinCurrentThread(int cpu);
+
+/**
+ * Allocator whose construct() default-initializes, so a vector of doubles
+ * resized by one thread leaves its pages untouched. Under Linux's
+ * first-touch policy each page then lands on the node of the worker that
+ * writes it first, instead of on the node of the thread that allocated.
+ */
+template <typename T>
+struct FirstTouchAllocator : std::allocator<T> {
+    template <typename U>
+    struct rebind {
+        using other = FirstTouchAllocator<U>;
+    };
+
+    FirstTouchAllocator() = default;
+    template <typename U>
+    FirstTouchAllocator(const FirstTouchAllocator<U>&) {}
+
+    template <typename U>
+    void construct(U* pointer) {
+        ::new ((void*)pointer) U;
+    }
+    template <typename U, typename... Args>
+    void construct(U* pointer, Args&&... args) {
+        ::new ((void*)pointer) U(std::forward<Args>(args)...);
+    }
+};
@@ -0,0 +1,43 @@
+#pragma once
+
+#include <cstdint>
+#include "Point.hpp"
+
+/**
+ * Occupancy bitmaps of a grid of up to 64x64 cells.
+ *
+ * Each row, column, diagonal and anti-diagonal is one 64-bit word, so the
+ * nearest occupied cell along any of the 8 compass directions is a single
+ * masked bit scan. A per-cell count lets two body parts share a cell (as
+ * they do right after the snake grows). Cells outside the grid are ignored.
+ */
+class OccupancyGrid {
+public:
+    static const int MAX_SIZE = 64;
+
+    OccupancyGrid();
+
+    void clear();
+    void add(Point p);
+    void remove(Point p);
+    bool occupied(Point p) const;
+
+    /**
+     * @brief Steps from `from` to the nearest occupied cell in direction
+     * (dx, dy), each of which is -1, 0 or 1; 0 if there is none. The start
+     * cell itself is not looked at.
+     */
+    int distanceTo(Point from, int dx, int dy) const;
+
+private:
+    uint64_t rows[MAX_SIZE];          // bit x of rows[y]
+    uint64_t cols[MAX_SIZE];          // bit y of cols[x]
+    uint64_t diagonals[2 * MAX_SIZE]; // bit x of diagonals[x - y + MAX_SIZE - 1]
+    uint64_t antiDiagonals[2 * MAX_SIZE]; // bit x of antiDiagonals[x + y]
+    uint8_t counts[MAX_SIZE * MAX_SIZE];
+
+    static bool inside(Point p) {
+        return p.x >= 0 && p.x < MAX_SIZE && p.y >= 0 && p.y < MAX_SIZE;
+    }
+    void setBits(Point p, bool value);
+};
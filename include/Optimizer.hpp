@@ -0,0 +1,92 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include "ThreadPool.hpp"
+#include "GeneStore.hpp"
+
+/**
+ * @brief Best, average and argmax of one generation's fitness.
+ */
+struct FitnessStats {
+    double best;
+    double average;
+    size_t bestIndex;
+};
+
+enum class OptimizerType {
+    Genetic,
+    EvolutionStrategy,
+    SeparableCMAES
+};
+
+/**
+ * The search strategy behind a Population.
+ *
+ * The Population owns the candidate gene rows and their fitness, and the
+ * TrainingRun evaluates them on the pool; an optimizer only decides which
+ * candidates to try next. Every optimizer puts its current best guess (the
+ * elite for the GA, the search mean for the strategies) in row 0, which is
+ * what the trainer visualizes and exports.
+ *
+ * The rows may be stored narrower than double (see GeneStore), so optimizers
+ * read and write them through worker-local scratch rows that they size in
+ * reset() from the pool.
+ */
+class Optimizer {
+public:
+    virtual ~Optimizer() {}
+
+    virtual const char* getName() const = 0;
+
+    /**
+     * @brief Starts a new run. `genes` holds popSize rows of uniform random
+     * genes in [-1, 1], which the optimizer may rewrite as its first
+     * generation of candidates.
+     */
+    virtual void reset(GeneStore& genes, size_t popSize, size_t geneCount, uint64_t seed, ThreadPool& pool) = 0;
+
+    /**
+     * @brief Writes the candidates of generation `generation + 1` into `next`
+     * from the evaluated rows of generation `generation`.
+     */
+    virtual void evolve(const GeneStore& genes, const double* fitness, const FitnessStats& stats,
+                        size_t generation, GeneStore& next, ThreadPool& pool) = 0;
+
+    /**
+     * @brief Continues the run after the topology changed (see
+     * Population::morph). `genes` holds the morphed rows of generation
+     * `generation`, now geneCount genes long, which have not been evaluated
+     * yet; row 0 is the morphed best guess.
+     */
+    virtual void morph(GeneStore& genes, size_t geneCount, size_t generation, ThreadPool& pool) = 0;
+
+    /**
+     * @brief The GA's per-gene mutation probability and noise deviation; the
+     * evolution strategies take `strength` as their step size and ignore
+     * `rate`.
+     */
+    virtual void setMutation(double rate, double strength) = 0;
+
+    /**
+     * @brief Magnitude pruning: genes of a new candidate with an absolute
+     * value below threshold are set to zero, 0 for none. Only the GA prunes;
+     * a zeroed search mean would stall the strategies.
+     */
+    virtual void setPruning(double threshold) { (void)threshold; }
+};
+
+std::unique_ptr<Optimizer> createOptimizer(OptimizerType type);
+
+/**
+ * @brief Short name used on the command line and in reports: ga, es, cmaes.
+ */
+const char* optimizerName(OptimizerType type);
+
+/**
+ * @brief Parses a name printed by optimizerName.
+ * @return false if the name is unknown.
+ */
+bool parseOptimizerType(const std::string& name, OptimizerType& type);
@@ -0,0 +1,36 @@
+#pragma once
+
+#include <vector>
+#include <string>
+#include <cstddef>
+#include "Optimizer.hpp"
+#include "World.hpp"
+
+/**
+ * @brief Settings of the optimizer comparison.
+ */
+struct BenchmarkOptions {
+    std::vector<OptimizerType> optimizers = {
+        OptimizerType::Genetic, OptimizerType::EvolutionStrategy, OptimizerType::SeparableCMAES
+    };
+    size_t inputNodes = INPUT_NODES;
+    std::vector<size_t> hiddenLayers = { 8 };
+    size_t populationSize = 500;
+    // a run succeeds once any candidate eats this much food in one game
+    int targetScore = 10;
+    // a run gives up after this many game evaluations
+    size_t maxEvaluations = 1000000;
+    // independent runs per optimizer, each with its own seed
+    size_t repeats = 3;
+    size_t threads = 0;
+    std::string outputPath = "optimizers.csv";
+};
+
+/**
+ * @brief Trains every optimizer `repeats` times, concurrently on one shared
+ * pool, and reports how many game evaluations each needed to reach the
+ * target score. Evaluations, not seconds, are the cost being compared,
+ * since simulation dominates the run time.
+ * @return Process exit code.
+ */
+int runOptimizerBenchmark(const BenchmarkOptions& options);
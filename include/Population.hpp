@@ -1,36 +1,128 @@
 #pragma once
 
 #include <vector>
+#include <memory>
+#include <cstdint>
 #include "NeuralNetwork.hpp"
+#include "Optimizer.hpp"
+#include "ThreadPool.hpp"
+#include "Morphism.hpp"
 
 class Population {
 public:
-    Population(size_t popSize, const std::vector<size_t>& topology);
+    /**
+     * @param seed Seed of the initial genes and the optimizer's streams; the
+     * same seed breeds the same generations. 0 draws a random one.
+     * @throws std::invalid_argument if popSize is 0.
+     */
+    Population(size_t popSize, const std::vector<size_t>& topology, ThreadPool& pool,
+               OptimizerType optimizerType = OptimizerType::Genetic,
+               const NetworkActivations& activations = NetworkActivations(),
+               GenePrecision precision = GenePrecision::Double, uint64_t seed = 0);
 
     void update();
     void evolve();
 
-    void reset(size_t popSize, const std::vector<size_t>& newTopology);
+    /**
+     * @brief Starts over with fresh random genes, from newSeed, or from a
+     * random seed if it is 0.
+     * @throws std::invalid_argument if popSize is 0.
+     */
+    void reset(size_t popSize, const std::vector<size_t>& newTopology, uint64_t newSeed = 0);
+
+    /**
+     * @brief Applies morph to every individual and carries on training
+     * with the new topology: the generation, seed and optimizer stay, and
+     * the morphed rows become the current, not yet evaluated, generation.
+     */
+    void morph(const Morph& morph);
+
+    /**
+     * @brief The neuron of a hidden layer with the lowest
+     * neuronContribution summed over the population, the one to remove
+     * with MorphKind::RemoveNeuron.
+     */
+    size_t findWeakestNeuron(size_t layer) const;
+
+    const std::vector<size_t>& getTopology() const { return topology; }
+
+    /**
+     * @brief Builds a network from the genes of one individual.
+     */
+    NeuralNetwork getBrain(size_t index) const;
+
+    /**
+     * @brief Returns a copy of the gene row of one individual.
+     */
+    std::vector<double> getGenes(size_t index) const;
+
+    /**
+     * @brief Read-only view of the gene row of one individual, valid until
+     * the next evolve() or reset().
+     * @param scratch geneCount doubles the row is widened into when genes
+     * are stored narrow; unused for double storage.
+     */
+    const double* getGeneRow(size_t index, double* scratch) const { return genes.read(index, scratch); }
 
-    NeuralNetwork& getBrain(size_t index);
     void setFitness(size_t index, double score);
-    
+
     double getBestFitness() const { return bestFitness; }
     double getAverageFitness() const;
+
+    /**
+     * @brief Reduces the current fitness values in parallel on the pool.
+     */
+    FitnessStats summarize() const;
     size_t getGeneration() const { return generation; }
-    size_t size() const { return population.size(); }
+    size_t size() const { return popSize; }
+    size_t getGeneCount() const { return geneCount; }
+
+    /**
+     * @brief Sets the per-gene mutation probability and the standard
+     * deviation of the Gaussian added to mutated genes (see
+     * Optimizer::setMutation for the evolution strategies).
+     */
+    void setMutation(double rate, double strength);
+    double getMutationRate() const { return mutationRate; }
+
+    /**
+     * @brief Zeroes genes of new candidates below threshold in magnitude
+     * (see Optimizer::setPruning), 0 for none.
+     */
+    void setPruning(double threshold) { optimizer->setPruning(threshold); }
+
+    OptimizerType getOptimizerType() const { return optimizerType; }
+    GenePrecision getPrecision() const { return precision; }
+
+    /**
+     * @brief Memory held per individual: its gene row in both generation
+     * buffers plus its fitness.
+     */
+    size_t getBytesPerIndividual() const { return 2 * genes.getRowBytes() + sizeof(double); }
 
 private:
-    std::vector<NeuralNetwork> population;
+    // One row of geneCount genes per individual, laid out back to back. The
+    // pages are first written by the pool worker that owns the rows, so they
+    // sit on that worker's NUMA node
+    GeneStore genes;
+    // Back buffer the next generation is bred into, swapped with genes
+    GeneStore offspring;
     std::vector<double> fitness;
-    
+
+    ThreadPool& pool;
+    OptimizerType optimizerType;
+    std::unique_ptr<Optimizer> optimizer;
+    NetworkActivations activations;
+    GenePrecision precision;
+
     // Topology is no longer const because we might change it on reset
-    std::vector<size_t> topology; 
-    
+    std::vector<size_t> topology;
+
+    size_t popSize;
+    size_t geneCount;
     size_t generation;
     double bestFitness;
-
-    NeuralNetwork& selectParent();
-    NeuralNetwork crossover(NeuralNetwork& parentA, NeuralNetwork& parentB);
-    void mutate(NeuralNetwork& brain);
-};
\ No newline at end of file
+    double mutationRate;
+    double mutationStrength;
+    uint64_t seed;
+};
@@ -0,0 +1,81 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+/**
+ * Counter-based random numbers.
+ *
+ * Every random word is a pure function of a (key, counter) pair, so a block
+ * of values has no serial dependency between lanes and the fill loops below
+ * compile to straight SIMD code. Independent streams only need distinct keys.
+ */
+
+/**
+ * @brief SplitMix64 finalizer, a cheap full-avalanche 64-bit mix.
+ */
+inline uint64_t mixBits(uint64_t x) {
+    x ^= x >> 30;
+    x *= 0xBF58476D1CE4E5B9ull;
+    x ^= x >> 27;
+    x *= 0x94D049BB133111EBull;
+    x ^= x >> 31;
+    return x;
+}
+
+/**
+ * @brief Returns the random word at position `counter` of stream `key`.
+ */
+inline uint64_t counterRandom(uint64_t key, uint64_t counter) {
+    return mixBits(key + counter * 0x9E3779B97F4A7C15ull);
+}
+
+/**
+ * @brief Derives the key of an independent stream from a seed and two ids
+ * (e.g. generation and individual index).
+ */
+inline uint64_t streamKey(uint64_t seed, uint64_t a, uint64_t b) {
+    return mixBits(mixBits(seed ^ mixBits(a + 0x632BE59BD9B4E019ull)) ^ b);
+}
+
+/**
+ * @brief Maps a random word to an index in [0, n) (Lemire's multiply-shift).
+ */
+inline size_t randomIndex(uint64_t word, size_t n) {
+    return (size_t)(((unsigned __int128)word * n) >> 64);
+}
+
+/**
+ * @brief Number of genes covered by one word of crossover mask bits.
+ */
+const size_t RANDOM_BLOCK = 64;
+
+/**
+ * @brief Fills `out` with uniform doubles in [lo, hi).
+ */
+void fillUniform(uint64_t key, uint64_t counter, double* out, size_t count, double lo, double hi);
+
+/**
+ * @brief Fills `masks` with one all-ones or all-zeros 64-bit lane per gene,
+ * each set with probability 1/2. One random word feeds RANDOM_BLOCK lanes.
+ */
+void fillCoinMasks(uint64_t key, uint64_t counter, uint64_t* masks, size_t count);
+
+/**
+ * @brief Fills `noise` with Bernoulli(rate)-gated Gaussian noise of standard
+ * deviation `strength`; lanes that do not mutate hold exactly 0.0.
+ *
+ * The Gaussian is the Irwin-Hall sum of four 12-bit uniforms rescaled to unit
+ * variance. Its tails stop at about 3.5 sigma, which is irrelevant here since
+ * mutated genes are clamped to [-1, 1] anyway.
+ */
+void fillMutationNoise(uint64_t key, uint64_t counter, double* noise, size_t count,
+                       double rate, double strength);
+
+/**
+ * @brief Fills `out` with Gaussian noise of standard deviation `sigma`: the
+ * Irwin-Hall sum of four 16-bit uniforms, so the tails stop at about 3.5
+ * sigma. Used by the evolution strategies, which regenerate a candidate's
+ * noise from its stream instead of storing it.
+ */
+void fillGaussian(uint64_t key, uint64_t counter, double* out, size_t count, double sigma);
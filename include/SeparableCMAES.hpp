@@ -0,0 +1,65 @@
+#pragma once
+
+#include <vector>
+#include "Optimizer.hpp"
+
+/**
+ * Separable CMA-ES (Ros & Hansen 2008): CMA-ES restricted to a diagonal
+ * covariance, so sampling and updates cost O(n) per candidate instead of
+ * O(n^2) and the method scales to the larger topologies.
+ *
+ * Row 0 is the search mean; rows 1..popSize-1 are the lambda samples
+ * mean + sigma * sqrt(C) * z. Like the ES, each z is regenerated from its
+ * counter-based stream during the update instead of being stored.
+ */
+class SeparableCMAES : public Optimizer {
+public:
+    SeparableCMAES();
+
+    const char* getName() const override { return "cmaes"; }
+    void reset(GeneStore& genes, size_t popSize, size_t geneCount, uint64_t seed, ThreadPool& pool) override;
+    void evolve(const GeneStore& genes, const double* fitness, const FitnessStats& stats,
+                size_t generation, GeneStore& next, ThreadPool& pool) override;
+    void morph(GeneStore& genes, size_t geneCount, size_t generation, ThreadPool& pool) override;
+    void setMutation(double rate, double strength) override;
+
+private:
+    size_t popSize;
+    size_t geneCount;
+    uint64_t seed;
+    double initialSigma;
+
+    // strategy parameters, fixed for a given lambda and n
+    size_t lambda;
+    size_t mu;
+    std::vector<double> weights;
+    double muEff;
+    double cSigma;
+    double dSigma;
+    double cC;
+    double c1;
+    double cMu;
+    double chiN;
+
+    // state
+    double sigma;
+    std::vector<double> mean;
+    std::vector<double> pathSigma;
+    std::vector<double> pathC;
+    std::vector<double> variance;
+    std::vector<double> deviation;
+    size_t updates;
+
+    std::vector<size_t> order;
+    // weighted recombination of the selected z and y, and the rank-mu term
+    std::vector<double> zMean;
+    std::vector<double> rankMu;
+
+    // one row per worker for candidates that are stored narrow
+    std::vector<double> scratch;
+
+    // sizes the state for geneCount genes, starts the search at row 0 and
+    // writes the candidates of `generation` over the rows
+    void restart(GeneStore& genes, size_t geneCount, size_t generation, ThreadPool& pool);
+    void writeCandidates(GeneStore& rows, size_t generation, ThreadPool& pool);
+};
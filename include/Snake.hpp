@@ -1,8 +1,10 @@
 #pragma once
 
 #include <SDL2/SDL.h>
-#include <deque>
+#include <cstdint>
+#include "BodyBuffer.hpp"
 #include "Point.hpp"
+#include "Occupancy.hpp"
 
 enum Direction {
     UP,
@@ -14,14 +16,28 @@ enum Direction {
 class Snake {
 public:
     Snake();
+    void reset();
     void update();
     void draw(SDL_Renderer *renderer);
-    std::deque<Point> body;
+    BodyBuffer body;
     Direction direction;
     bool hit_itself();
     void grow();
     bool is_point_on_body(Point p, bool skip_tail);
 
+    /**
+     * Cells covered by the body, kept in sync by reset(), update() and grow().
+     * Code that edits `body` directly must keep it in sync as well.
+     */
+    OccupancyGrid occupancy;
+
+    /**
+     * Zobrist hash of the body segments (see Zobrist.hpp), kept in sync the
+     * same way as `occupancy`.
+     */
+    uint64_t body_hash;
+
 private:
     void draw_body_part(SDL_Renderer *renderer, Point part);
+    uint64_t segment_key(size_t index) const;
 };
\ No newline at end of file
@@ -0,0 +1,36 @@
+#pragma once
+
+#include <vector>
+#include <string>
+#include <cstddef>
+#include "World.hpp"
+
+/**
+ * @brief The hyperparameter grid and stopping rules of a sweep.
+ */
+struct SweepOptions {
+    // each entry lists the hidden layer sizes of one topology, empty for none
+    std::vector<std::vector<size_t>> hiddenLayers = { {8} };
+    std::vector<size_t> populationSizes = { 500 };
+    std::vector<double> mutationRates = { 0.05 };
+    // standard deviations of the mutation noise
+    std::vector<double> mutationStrengths = { 0.2 };
+    size_t inputNodes = INPUT_NODES;
+    size_t generations = 200;
+    // mean champion scores whose first appearance is timed; the champion
+    // (row 0 after each generation) replays the same held-out games every time
+    std::vector<int> scoreThresholds = { 5, 10, 20 };
+    // a run is stopped once its best fitness so far falls below pruneRatio of
+    // the leading run's at the same generation, but never before pruneAfter
+    size_t pruneAfter = 30;
+    double pruneRatio = 0.5;
+    size_t threads = 0;
+    std::string outputPath = "sweep.csv";
+};
+
+/**
+ * @brief Trains every combination of the grid concurrently on one shared
+ * worker pool and writes a CSV table of the results.
+ * @return Process exit code.
+ */
+int runSweep(const SweepOptions& options);
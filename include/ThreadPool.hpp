@@ -0,0 +1,117 @@
+#pragma once
+
+#include <vector>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <functional>
+#include <exception>
+#include "Numa.hpp"
+
+struct TrainingMetrics;
+
+/**
+ * A fixed set of worker threads that run chunked parallel loops.
+ *
+ * Several threads may call parallelFor at the same time; the open jobs are
+ * served round-robin one chunk at a time, so concurrent callers share the
+ * workers fairly instead of queueing behind each other.
+ *
+ * With pinned workers on a machine with several NUMA nodes, the workers are
+ * spread over the nodes and every loop is cut into one contiguous shard per
+ * node, sized by the node's worker count. Workers take chunks from their own
+ * node's shard and only steal (from the back of another shard) once theirs
+ * is empty. Shards depend only on the loop's count, so a loop over the
+ * population touches each row from the same node every time, which is the
+ * node that first wrote it (see FirstTouchAllocator). On one node, or
+ * unpinned, there is a single shard and nothing changes.
+ */
+class ThreadPool {
+public:
+    /**
+     * @brief Body of a parallel loop, called with a half-open index range
+     * and the index of the worker running it (in [0, size())).
+     */
+    using Task = std::function<void(size_t begin, size_t end, size_t worker)>;
+
+    /**
+     * @brief Starts the workers.
+     * @param threadCount Number of workers, 0 for one per allowed CPU.
+     * @param pinWorkers Pin each worker to one CPU of the detected topology.
+     */
+    explicit ThreadPool(size_t threadCount = 0, bool pinWorkers = false);
+
+    /**
+     * @brief Starts workers pinned onto the given topology.
+     */
+    ThreadPool(size_t threadCount, const NumaTopology& topology);
+    ~ThreadPool();
+
+    ThreadPool(const ThreadPool&) = delete;
+    ThreadPool& operator=(const ThreadPool&) = delete;
+
+    /**
+     * @brief Runs task over [0, count) and blocks until every chunk is done.
+     * Must not be called from inside a task.
+     * @param count Number of indices.
+     * @param grain Indices per chunk, 0 to pick one from the pool size.
+     * @param task The loop body.
+     */
+    void parallelFor(size_t count, size_t grain, const Task& task);
+
+    size_t size() const { return workers.size(); }
+
+    /**
+     * @brief Number of shards loops are cut into, 1 unless pinned on
+     * several nodes.
+     */
+    size_t getNodeCount() const { return nodeWorkers.size(); }
+
+    /**
+     * @brief Chunks a worker took from another node's shard so far.
+     */
+    size_t getStolenChunks();
+
+    /**
+     * @brief Publishes the worker count, queue depth and busy time into
+     * sink from now on; nullptr (the default) records nothing. A TrainingRun
+     * points its pool at trainingMetrics().
+     */
+    void setMetrics(TrainingMetrics* sink);
+
+    // shards are fixed-size arrays so parallelFor never allocates; with
+    // more nodes than this, node n shares shard n % MAX_NODES
+    static const size_t MAX_NODES = 16;
+
+private:
+    struct Job {
+        const Task* task;
+        size_t count;
+        size_t grain;
+        // unclaimed part of each node's shard
+        size_t next[MAX_NODES];
+        size_t end[MAX_NODES];
+        size_t unclaimed;
+        size_t done;
+        std::exception_ptr error;
+        std::condition_variable finished;
+    };
+
+    std::vector<std::thread> workers;
+    // shard of each worker, and workers per shard
+    std::vector<size_t> workerNode;
+    std::vector<size_t> nodeWorkers;
+    std::mutex mutex;
+    std::condition_variable wakeup;
+    // jobs that still have unclaimed chunks
+    std::vector<Job*> openJobs;
+    size_t nextJob;
+    size_t stolenChunks;
+    // unclaimed indices over all open jobs, published as the queue depth
+    size_t queued;
+    bool stopping;
+    TrainingMetrics* metrics;
+
+    void start(size_t threadCount, const NumaTopology* topology);
+    void workerLoop(size_t worker, int cpu);
+};
@@ -0,0 +1,62 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+
+/**
+ * Scoped trace zones for per-thread timelines.
+ *
+ * Build with `make TRACE=1` (defines SNAKE_TRACING) to compile the zones in.
+ * Every thread records into its own fixed-size ring buffer that only it
+ * writes, so recording takes no locks; when full, the oldest events are
+ * overwritten. writeTrace dumps all buffers as Chrome trace JSON, which
+ * chrome://tracing and ui.perfetto.dev can open.
+ *
+ * Without SNAKE_TRACING, TRACE_ZONE expands to nothing and costs nothing.
+ */
+
+#ifdef SNAKE_TRACING
+
+#define SNAKE_TRACE_CONCAT_(a, b) a##b
+#define SNAKE_TRACE_CONCAT(a, b) SNAKE_TRACE_CONCAT_(a, b)
+
+/**
+ * @brief Records the enclosing scope as a zone. `name` must be a string literal.
+ */
+#define TRACE_ZONE(name) TraceZone SNAKE_TRACE_CONCAT(traceZone_, __LINE__)(name)
+
+class TraceZone {
+public:
+    explicit TraceZone(const char* name);
+    ~TraceZone();
+
+    TraceZone(const TraceZone&) = delete;
+    TraceZone& operator=(const TraceZone&) = delete;
+
+private:
+    const char* name;
+    uint64_t start;
+};
+
+#else
+
+#define TRACE_ZONE(name) ((void)0)
+
+#endif
+
+/**
+ * @brief Whether the zones were compiled in.
+ */
+bool traceCompiledIn();
+
+/**
+ * @brief Names the calling thread in the trace (no-op without SNAKE_TRACING).
+ */
+void setTraceThreadName(const std::string& name);
+
+/**
+ * @brief Writes every thread's buffered zones as Chrome trace JSON. Call it
+ * once the traced threads are idle.
+ * @return false if tracing is compiled out or the file could not be written.
+ */
+bool writeTrace(const std::string& path);
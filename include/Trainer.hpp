@@ -2,11 +2,37 @@
 
 #include <vector>
 #include <memory>
-#include <future>
+#include <string>
 #include "Game.hpp" 
-#include "Population.hpp"
+#include "GenerationLog.hpp"
+#include "ThreadPool.hpp"
+#include "TrainingRun.hpp"
 #include "World.hpp"
 
+/**
+ * @brief Settings of the interactive trainer that can come from the command line.
+ */
+struct TrainerOptions {
+    // size of the input layer, which also picks the sensor layout (see World.hpp)
+    size_t inputNodes = INPUT_NODES;
+    // widths of the hidden layers the first run starts with, e.g. { 256, 256 }
+    std::vector<size_t> hiddenLayers = { 8 };
+    // every training run writes its generation log into this directory
+    std::string logDir = "logs";
+    OptimizerType optimizer = OptimizerType::Genetic;
+    bool detectLoops = true;
+    LoopScoring loopScoring = LoopScoring::CreditRemaining;
+    NetworkActivations activations;
+    int episodes = 1;
+    EpisodeAggregate aggregate = EpisodeAggregate::Mean;
+    double aggregateQuantile = 0.25;
+    ScreeningConfig screening;
+    double pruneThreshold = 0.0;
+    double sparseDensity = SPARSE_DENSITY;
+    bool pinThreads = false;
+    GenePrecision precision = GenePrecision::Double;
+};
+
 enum class TrainerState {
     Menu,
     Training,
@@ -15,7 +41,7 @@ enum class TrainerState {
 
 class Trainer {
 public:
-    Trainer();
+    explicit Trainer(const TrainerOptions& options = TrainerOptions());
     ~Trainer(); 
     void run();
 
@@ -28,8 +54,16 @@ private:
     void stopVisualization();
     void runTrainingStep();
     void runVisualizationStep();
+    void advanceVisualization();
+    void changeVisualizationSpeed(int delta);
     
     void resetTraining();
+    void growNetwork();
+    void shrinkNetwork();
+    void insertHiddenLayer();
+    void morphTraining(const Morph& morph);
+    void exportChampion();
+    void openRunLog();
 
     void renderGraph(SDL_Renderer* renderer, int x, int y, int w, int h);
 
@@ -38,15 +72,20 @@ private:
 
     const size_t POPULATION_SIZE;
     std::vector<size_t> m_topology;
-    size_t m_hiddenNodeCount;
-    const int FPS = 120;
+    // simulation steps per second when visualizing at 1x
+    const double VIS_STEPS_PER_SECOND = 120.0;
     const int MAX_STEPS_PER_GAME = 2500;
 
     Game m_game;
-    Population m_population;
+    ThreadPool m_pool;
+    TrainingRun m_run;
     TrainerState m_state;
+    // topology index of the hidden layer the menu edits
+    size_t m_selectedLayer;
 
-    std::vector<double> m_fitnessHistory;
+    std::string m_logDir;
+    std::string m_logPath;
+    GenerationLogReader m_logReader;
 
     SDL_Rect btnReset;
     SDL_Rect btnMinusNode;
@@ -55,4 +94,12 @@ private:
     std::unique_ptr<Snake> m_visSnake;
     std::unique_ptr<Food>  m_visFood;
     std::unique_ptr<World> m_visWorld;
+    std::unique_ptr<NeuralNetwork> m_visBrain;
+
+    // fixed-timestep pacing of the visualization, see runVisualizationStep
+    size_t m_visSpeedIndex;
+    bool m_visPaused;
+    bool m_visStepOnce;
+    double m_visAccumulator;
+    Uint64 m_visLastTick;
 };
\ No newline at end of file
@@ -0,0 +1,138 @@
+#pragma once
+
+#include <vector>
+#include <memory>
+#include "Evaluator.hpp"
+#include "GenerationLog.hpp"
+#include "Population.hpp"
+#include "ThreadPool.hpp"
+
+/**
+ * @brief What happened in one generation of a TrainingRun.
+ */
+struct GenerationReport {
+    size_t generation;
+    double bestFitness;
+    double averageFitness;
+    int bestScore;
+    size_t evaluations;
+    long long steps;
+    // steps skipped by ending looping games early (see EvalConfig::detectLoops)
+    long long stepsSaved;
+    // individuals given full-length games after screening (see ScreeningConfig)
+    size_t promoted;
+    // individuals whose screening game was cut and who were not promoted
+    size_t screenedOut;
+    double seconds;
+};
+
+/**
+ * Two-stage evaluation. Every individual first plays its games (all
+ * EvalConfig::episodes of them) only up to screenSteps. A game that ends on its own within that budget is already
+ * exact, since the full game with the same seed is the same game. Of the
+ * rest, the top promoteFraction by screening fitness play the full game, and
+ * so does any other cut game whose upper confidence
+ * bound could still reach the elite; everyone else keeps the screening
+ * fitness, which only covers the steps played.
+ *
+ * The bound comes from the promoted games themselves: full fitness is
+ * regressed on screening fitness, and a cut game is promoted if the
+ * prediction plus ucb residual standard deviations reaches the fitness of
+ * the eliteFraction-th best individual.
+ */
+struct ScreeningConfig {
+    // step budget of the screening games, 0 turns screening off
+    int screenSteps = 0;
+    double promoteFraction = 0.2;
+    double eliteFraction = 0.05;
+    // width of the confidence bound in residual standard deviations, 0 for none
+    double ucb = 0.5;
+};
+
+/**
+ * A headless training loop: evaluates a population on the worker pool and
+ * breeds the next generation. The SDL trainer and the sweep runner both
+ * drive one of these.
+ */
+class TrainingRun {
+public:
+    /**
+     * @param seed Seed of the population and of every game's food; the same
+     * seed and settings train the same generations. 0 draws a random one.
+     */
+    TrainingRun(size_t popSize, const std::vector<size_t>& topology, const EvalConfig& evalConfig, ThreadPool& pool,
+                OptimizerType optimizerType = OptimizerType::Genetic,
+                GenePrecision precision = GenePrecision::Double, uint64_t seed = 0);
+
+    /**
+     * @brief Evaluates the current generation and evolves the next one.
+     */
+    GenerationReport step();
+
+    /**
+     * @brief Starts over with a fresh random population.
+     */
+    void reset(size_t popSize, const std::vector<size_t>& newTopology);
+
+    /**
+     * @brief Changes the topology of the running population without
+     * starting over (see Population::morph). An open log still names the
+     * old topology in its header, so reopen it (openLog) to record the
+     * morphed run.
+     */
+    void morph(const Morph& morph);
+
+    void setScreening(const ScreeningConfig& config) { screening = config; }
+    const ScreeningConfig& getScreening() const { return screening; }
+
+    /**
+     * @brief Records the games of the following steps into writer, which
+     * must have a ring per pool worker; null stops recording.
+     */
+    void setTrajectoryWriter(TrajectoryWriter* writer) { trajectoryWriter = writer; }
+
+    /**
+     * @brief Appends a GenerationRecord to the log at path after every step.
+     * @return false if the log could not be created.
+     */
+    bool openLog(const std::string& path);
+    void closeLog();
+
+    Population& getPopulation() { return population; }
+    const Population& getPopulation() const { return population; }
+    const std::vector<size_t>& getTopology() const { return topology; }
+
+private:
+    ThreadPool& pool;
+    EvalConfig evalConfig;
+    std::vector<size_t> topology;
+    Population population;
+    ScreeningConfig screening;
+    std::vector<GameResult> results;
+    // screening stage bookkeeping, kept between generations to reuse storage
+    std::vector<double> screenFitness;
+    std::vector<size_t> ranking;
+    std::vector<size_t> promotedList;
+    std::vector<char> promoted;
+    // food seeds of generation g, individual i are streamKey(seed, g, i); with
+    // several episodes every individual plays episode k on commonSeeds[k]
+    uint64_t seed;
+    std::vector<uint64_t> commonSeeds;
+    // one evaluation context per pool worker, created on first use
+    std::vector<std::unique_ptr<EvalContext>> contexts;
+    std::vector<double> sortedFitness;
+    GenerationLogWriter log;
+    TrajectoryWriter* trajectoryWriter = nullptr;
+
+    EvalContext& contextFor(size_t worker);
+    GameResult play(EvalContext& context, size_t individual, int stepLimit);
+    void playScreening(int stepLimit);
+    void playPromoted(size_t first);
+    size_t promoteByConfidence(size_t screened);
+
+    // the generation's gauges and counters, see Metrics.hpp
+    void publishMetrics(const GenerationReport& report);
+
+    void writeLogRecord(const GenerationReport& report, const std::vector<double>& champion,
+                        double evalSeconds, double evolveSeconds);
+};
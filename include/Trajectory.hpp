@@ -0,0 +1,253 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <cstddef>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+
+/**
+ * Trajectory dataset: one row per simulated step with the sensor inputs, the
+ * network outputs, the action taken and the reward, for offline analysis and
+ * policy distillation.
+ *
+ * Recording is split so the evaluation loop never waits on I/O. Each pool
+ * worker pushes rows into its own single-producer single-consumer ring, and
+ * one background thread drains the rings into column buffers. Every
+ * CHUNK_ROWS rows it compresses the columns and appends them to the file as
+ * a chunk. The rings are bounded: when one is full, its worker either waits
+ * for the writer (backpressure, the default) or drops the row.
+ *
+ * File layout: a TrajectoryFileHeader, then chunks, each a
+ * TrajectoryChunkHeader followed by its compressed columns in column order,
+ * then an index of chunk offsets and a TrajectoryFileFooter. The reader maps
+ * the file and decodes chunks on demand. A file without a footer (the
+ * writer died) is still readable by walking the chunk headers.
+ *
+ * Columns: generation, individual, episode, flags, action, step, reward,
+ * then one per input and one per output. Inputs, outputs and reward are
+ * stored as float.
+ */
+
+/**
+ * @brief Set in a row's flags when the game was a screening game that may
+ * be replayed in full later (see ScreeningConfig).
+ */
+const uint8_t TRAJECTORY_SCREENING = 1;
+
+/**
+ * @brief The fixed fields of one recorded step.
+ */
+struct TrajectoryStep {
+    uint32_t generation;
+    uint32_t individual;
+    uint16_t episode;
+    uint8_t flags;
+    uint8_t action;
+    uint32_t step;
+    // change of the game's fitness over this step
+    float reward;
+};
+
+struct TrajectoryFileHeader {
+    char magic[8];
+    uint32_t version;
+    uint32_t inputCount;
+    uint32_t outputCount;
+    uint32_t columnCount;
+    uint32_t chunkRows;
+    uint32_t reserved;
+};
+
+struct TrajectoryChunkHeader {
+    uint32_t magic;
+    uint32_t rows;
+    // followed by columnCount uint32 compressed sizes, then the columns
+};
+
+struct TrajectoryFileFooter {
+    uint64_t indexOffset;
+    uint64_t chunkCount;
+    uint64_t rowCount;
+    char magic[8];
+};
+
+/**
+ * @brief Recording settings.
+ */
+struct TrajectoryOptions {
+    // share of games recorded, decided per game from its food seed so every
+    // pass over the same game makes the same choice
+    double sampleRate = 1.0;
+    // ring memory of all workers together
+    size_t bufferBytes = 64u << 20;
+    // drop rows when a ring is full instead of waiting for the writer
+    bool dropWhenFull = false;
+};
+
+/**
+ * @brief Single-producer single-consumer ring of packed rows. The producer is
+ * one pool worker, the consumer the writer thread.
+ */
+class TrajectoryRing {
+public:
+    TrajectoryRing(size_t capacity, size_t inputCount, size_t outputCount, bool dropWhenFull);
+
+    /**
+     * @brief Appends one row, waiting for space or dropping it when full.
+     * @return false if the row was dropped.
+     */
+    bool push(const TrajectoryStep& step, const double* inputs, const double* outputs);
+
+    size_t getInputCount() const { return inputCount; }
+
+private:
+    friend class TrajectoryWriter;
+
+    std::vector<uint8_t> storage;
+    size_t capacity;
+    size_t rowBytes;
+    size_t inputCount;
+    size_t outputCount;
+    bool dropWhenFull;
+
+    // head is written by the producer, tail by the consumer; separate lines
+    // so they do not false-share
+    alignas(64) std::atomic<size_t> head;
+    alignas(64) std::atomic<size_t> tail;
+    // producer-side statistics, read after the producer is done
+    alignas(64) uint64_t dropped;
+    uint64_t stallNanoseconds;
+};
+
+class TrajectoryWriter {
+public:
+    TrajectoryWriter();
+    ~TrajectoryWriter();
+
+    TrajectoryWriter(const TrajectoryWriter&) = delete;
+    TrajectoryWriter& operator=(const TrajectoryWriter&) = delete;
+
+    /**
+     * @brief Creates the file and starts the writer thread.
+     * @param producers Number of rings, one per pool worker.
+     * @return false if the file could not be created.
+     */
+    bool open(const std::string& path, size_t inputCount, size_t outputCount, size_t producers,
+              const TrajectoryOptions& options);
+
+    /**
+     * @brief Drains every ring, writes the last chunk and the index, and
+     * prints what was written. Producers must have stopped pushing.
+     */
+    void close();
+    bool isOpen() const { return writerThread.joinable(); }
+
+    TrajectoryRing* getRing(size_t producer) { return rings[producer].get(); }
+
+    /**
+     * @brief Whether the game with this food seed is recorded.
+     */
+    bool sampleGame(uint64_t gameSeed) const;
+
+    // number of rows per chunk
+    static const size_t CHUNK_ROWS = 65536;
+
+private:
+    std::vector<std::unique_ptr<TrajectoryRing>> rings;
+    std::thread writerThread;
+    std::atomic<bool> stopping;
+    int fd;
+    uint64_t sampleThreshold;
+    std::vector<size_t> columnWidths;
+    std::vector<size_t> columnOffsets;
+    size_t rowBytes;
+
+    // writer-thread state
+    std::vector<std::vector<uint8_t>> columns;
+    size_t stagedRows;
+    std::vector<uint8_t> encoded;
+    std::vector<uint8_t> scratch;
+    std::vector<uint64_t> chunkOffsets;
+    uint64_t fileOffset;
+    uint64_t rowCount;
+    uint64_t rawBytes;
+    uint64_t compressedBytes;
+
+    void run();
+    size_t drain(TrajectoryRing& ring);
+    void writeChunk();
+    bool writeAll(const void* data, size_t size);
+};
+
+/**
+ * @brief One decoded chunk; column c of the inputs is inputs[c * rows + r].
+ */
+struct TrajectoryChunk {
+    size_t rows = 0;
+    std::vector<uint32_t> generation;
+    std::vector<uint32_t> individual;
+    std::vector<uint16_t> episode;
+    std::vector<uint8_t> flags;
+    std::vector<uint8_t> action;
+    std::vector<uint32_t> step;
+    std::vector<float> reward;
+    std::vector<float> inputs;
+    std::vector<float> outputs;
+};
+
+class TrajectoryReader {
+public:
+    TrajectoryReader();
+    ~TrajectoryReader();
+
+    TrajectoryReader(const TrajectoryReader&) = delete;
+    TrajectoryReader& operator=(const TrajectoryReader&) = delete;
+
+    /**
+     * @brief Maps a trajectory file. A file without its index (the writer
+     * did not finish) is read up to the first incomplete chunk.
+     * @return false if the file cannot be mapped, is not a trajectory file,
+     * or its index points at a chunk that is damaged or does not fit in it.
+     */
+    bool open(const std::string& path);
+    void close();
+
+    size_t getChunkCount() const { return chunks.empty() ? 0 : chunks.size() - 1; }
+    uint64_t getRowCount() const { return rowCount; }
+    size_t getInputCount() const { return inputCount; }
+    size_t getOutputCount() const { return outputCount; }
+    // compressed size of one chunk in the file, headers included
+    size_t getChunkBytes(size_t index) const;
+
+    /**
+     * @brief Decodes one chunk.
+     * @return false if the chunk is damaged.
+     */
+    bool readChunk(size_t index, TrajectoryChunk& chunk) const;
+
+private:
+    // end of the chunk at offset, with its row count, or 0 if it is damaged
+    // or runs past the end of the file
+    uint64_t chunkEnd(uint64_t offset, uint32_t& rows) const;
+
+    int fd;
+    const uint8_t* map;
+    size_t mappedBytes;
+    size_t inputCount;
+    size_t outputCount;
+    size_t columnCount;
+    // rows a chunk may hold at most, from the file header
+    size_t chunkRows;
+    uint64_t rowCount;
+    // byte offset of every chunk header, plus the end of the last chunk
+    std::vector<uint64_t> chunks;
+};
+
+/**
+ * @brief Prints the chunks of a trajectory file with their compression.
+ * @return Process exit code.
+ */
+int summarizeTrajectories(const std::string& path);
@@ -6,6 +6,15 @@
 #include <SDL2/SDL.h>
 #include <vector>
 
+// Sensor values fed to the brain and the relative moves it chooses between.
+// The sensor layout follows the size of the brain's input layer:
+// BASIC_INPUT_NODES looks one cell around the head, RAY_INPUT_NODES casts 8
+// rays and measures the distance to the wall, body and food along each.
+const size_t BASIC_INPUT_NODES = 11;
+const size_t RAY_INPUT_NODES = 24;
+const size_t INPUT_NODES = BASIC_INPUT_NODES;
+const size_t OUTPUT_NODES = 3;
+
 class World {
 public:
     World(Snake& snake, Food& food, int width, int height);
@@ -14,9 +23,39 @@ public:
     void handle_input(SDL_Event& event);
     void reset();
     void handle_ai_input(NeuralNetwork& nn);
+
+    /**
+     * @brief Turns the snake relative to its heading: 0 left, 1 straight,
+     * 2 right. Other values keep the heading.
+     */
+    void apply_action(int action);
+
+    /**
+     * @brief True if the last update() killed the snake. The world has
+     * already been reset by then, so this is the only trace of the death.
+     */
+    bool snake_died() const { return died; }
+
+    /**
+     * @brief Writes the sensor values for a brain with `input_count` inputs
+     * (BASIC_INPUT_NODES or RAY_INPUT_NODES) into `inputs`.
+     */
+    void get_game_state(size_t input_count, double* inputs);
     int getScore() const;
     bool snake_hit_wall();
 
+    /**
+     * @brief Zobrist hash of the snake, its heading and the food.
+     */
+    uint64_t state_hash() const;
+
+    /**
+     * @brief Counts the food events and resets. Between two of them the game
+     * is deterministic under a fixed policy, so a repeated state_hash() within
+     * one epoch means the snake is stuck in a loop.
+     */
+    uint64_t get_epoch() const { return epoch; }
+
 private:
     Snake& snake;
     Food& food;
@@ -24,8 +63,10 @@ private:
     int height;
     int cell_size;
     int score;
+    uint64_t epoch;
+    bool died;
     void draw_grid(SDL_Renderer *renderer);
     bool snake_is_eating_food();
-    std::vector<double> get_game_state();
+    void get_ray_state(double* inputs);
     bool is_danger_at(Point p);
 };
\ No newline at end of file
@@ -0,0 +1,72 @@
+#pragma once
+
+#include <cstdint>
+#include <cstddef>
+#include <vector>
+#include "Point.hpp"
+#include "Random.hpp"
+
+/**
+ * Zobrist hashing of game states.
+ *
+ * A state hashes to the XOR of one 64-bit key per feature: every body
+ * segment (its cell and the direction to the next segment), the head cell,
+ * the heading and the food cell. Moving the snake only swaps the keys of the
+ * segments that changed, so the hash is updated in O(1) per step. Keys come
+ * from a counter-based stream instead of a stored table, so any board size
+ * works.
+ */
+enum ZobristFeature {
+    ZOBRIST_SEGMENT = 1,
+    ZOBRIST_HEAD,
+    ZOBRIST_DIRECTION,
+    ZOBRIST_FOOD
+};
+
+// link codes of a segment besides the four Direction values
+const int LINK_SAME_CELL = 4;
+const int LINK_TAIL_END = 5;
+
+/**
+ * @brief Key of one feature. The arguments are packed without overlap, so
+ * distinct features always get distinct keys.
+ */
+inline uint64_t zobristKey(ZobristFeature feature, Point p, int code) {
+    uint64_t index = ((uint64_t)feature << 48) | ((uint64_t)(uint16_t)p.x << 32)
+                   | ((uint64_t)(uint16_t)p.y << 16) | (uint64_t)(uint16_t)code;
+    return counterRandom(0x5A0B5157A7E5EEDull, index);
+}
+
+/**
+ * Open-addressing set of state hashes seen since the last clear().
+ *
+ * Every slot is tagged with the epoch it was written in, so clear() only
+ * bumps the epoch and costs O(1) no matter how many states were stored.
+ */
+class VisitedStates {
+public:
+    explicit VisitedStates(size_t capacity = 256);
+
+    /**
+     * @brief Forgets every state inserted so far.
+     */
+    void clear();
+
+    /**
+     * @brief Adds a state hash.
+     * @return true if it was already in the set, i.e. the state repeats.
+     */
+    bool insert(uint64_t hash);
+
+private:
+    struct Slot {
+        uint64_t hash;
+        uint32_t epoch;
+    };
+
+    std::vector<Slot> slots;
+    size_t count;
+    uint32_t epoch;
+
+    void grow();
+};
@@ -0,0 +1,93 @@
+#ifndef SNAKESIM_H
+#define SNAKESIM_H
+
+/*
+ * snakesim: the snake simulation as a shared library with a C ABI
+ * (build with 'make lib', link with -lsnakesim).
+ *
+ * A handle owns N independent environments that are always stepped
+ * together. Every call takes caller-owned arrays laid out environment by
+ * environment, and the library writes observations, rewards and done flags
+ * straight into them. Nothing is allocated or copied per step, so the
+ * arrays can be numpy buffers passed in once.
+ *
+ * Semantics of one step, per environment:
+ *  - actions are relative to the heading: 0 turn left, 1 straight,
+ *    2 turn right.
+ *  - the reward is +1 for eating, -1 for dying and 0 otherwise.
+ *  - done is 1 when the snake died or starved (went more than
+ *    starvation_steps steps without food, if that limit is not 0, like
+ *    the trainer's games). A finished environment
+ *    restarts on its own, and the observation written for it is already the
+ *    first one of the next episode, which continues the environment's food
+ *    stream.
+ *
+ * Functions returning int return 0 on success and a negative SNAKESIM_ERROR
+ * code otherwise. No C++ exception ever crosses the ABI.
+ */
+
+#include <stddef.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#if defined(__GNUC__)
+#define SNAKESIM_API __attribute__((visibility("default")))
+#else
+#define SNAKESIM_API
+#endif
+
+/* bumped on any incompatible change of the functions below */
+#define SNAKESIM_ABI_VERSION 1
+
+#define SNAKESIM_ERROR_ARGUMENT (-1)
+#define SNAKESIM_ERROR_INTERNAL (-2)
+
+typedef struct snakesim_envs snakesim_envs;
+
+SNAKESIM_API uint32_t snakesim_abi_version(void);
+
+/*
+ * Creates `count` environments on a board of width x height cells, at
+ * least 26x26 (the snake starts around cell (25, 25); the trainer uses 40x30).
+ * observation_size selects the sensors: 11 (one cell around the head) or
+ * 24 (8 ray casts; boards of at most 64x64 cells). threads is the number of
+ * worker threads stepping the environments, 0 or 1 to step them on the
+ * calling thread. Returns NULL on invalid arguments or allocation failure.
+ */
+SNAKESIM_API snakesim_envs* snakesim_create(uint32_t count, uint32_t width, uint32_t height,
+                                            uint32_t observation_size, uint32_t starvation_steps,
+                                            uint32_t threads);
+
+SNAKESIM_API void snakesim_destroy(snakesim_envs* envs);
+
+SNAKESIM_API uint32_t snakesim_count(const snakesim_envs* envs);
+SNAKESIM_API uint32_t snakesim_observation_size(const snakesim_envs* envs);
+
+/*
+ * Restarts every environment. seeds holds one seed per environment, or is
+ * NULL to seed environment i with i. Writes count * observation_size
+ * observations.
+ */
+SNAKESIM_API int snakesim_reset(snakesim_envs* envs, const uint64_t* seeds, double* observations);
+
+/*
+ * Advances every environment by one step.
+ * actions: count values; observations: count * observation_size values;
+ * rewards: count values; dones: count values.
+ */
+SNAKESIM_API int snakesim_step(snakesim_envs* envs, const int32_t* actions, double* observations,
+                               double* rewards, uint8_t* dones);
+
+/*
+ * Writes the food eaten so far in the current episode of every environment.
+ */
+SNAKESIM_API int snakesim_scores(const snakesim_envs* envs, int32_t* scores);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -0,0 +1,46 @@
+#include "Activation.hpp"
+#include "Kernels.hpp"
+
+SNAKE_DISPATCH
+void applyActivation(ActivationType type, double* values, size_t count) {
+    switch (type) {
+        case ActivationType::SIGMOID:
+            for (size_t i = 0; i < count; ++i) values[i] = fastSigmoid(values[i]);
+            break;
+        case ActivationType::RELU:
+            for (size_t i = 0; i < count; ++i) values[i] = relu(values[i]);
+            break;
+        case ActivationType::TANH:
+            for (size_t i = 0; i < count; ++i) values[i] = fastTanh(values[i]);
+            break;
+        case ActivationType::IDENTITY:
+            break;
+    }
+}
+
+std::vector<ActivationType> NetworkActivations::forLayers(size_t layers) const {
+    std::vector<ActivationType> types(layers, hidden);
+    if (layers > 0) types.back() = output;
+    return types;
+}
+
+const char* activationName(ActivationType type) {
+    switch (type) {
+        case ActivationType::SIGMOID: return "sigmoid";
+        case ActivationType::RELU: return "relu";
+        case ActivationType::TANH: return "tanh";
+        case ActivationType::IDENTITY: return "identity";
+    }
+    return "relu";
+}
+
+bool parseActivationType(const std::string& name, ActivationType& type) {
+    for (ActivationType candidate : { ActivationType::SIGMOID, ActivationType::RELU,
+                                      ActivationType::TANH, ActivationType::IDENTITY }) {
+        if (name == activationName(candidate)) {
+            type = candidate;
+            return true;
+        }
+    }
+    return false;
+}
@@ -0,0 +1,59 @@
+#include "AllocationCounter.hpp"
+#include <cstdlib>
+#include <new>
+
+// zero-initialized, so touching them needs no dynamic TLS initialization
+static thread_local size_t allocationCount = 0;
+static thread_local bool counting = false;
+
+void countThreadAllocations(bool enabled) {
+    counting = enabled;
+}
+
+size_t threadAllocationCount() {
+    return allocationCount;
+}
+
+void* operator new(std::size_t size) {
+    if (counting) allocationCount++;
+    void* memory = std::malloc(size ? size : 1);
+    if (!memory) throw std::bad_alloc();
+    return memory;
+}
+
+void* operator new[](std::size_t size) {
+    return ::operator new(size);
+}
+
+void* operator new(std::size_t size, const std::nothrow_t&) noexcept {
+    if (counting) allocationCount++;
+    return std::malloc(size ? size : 1);
+}
+
+void* operator new[](std::size_t size, const std::nothrow_t&) noexcept {
+    return ::operator new(size, std::nothrow);
+}
+
+void operator delete(void* memory) noexcept {
+    std::free(memory);
+}
+
+void operator delete[](void* memory) noexcept {
+    std::free(memory);
+}
+
+void operator delete(void* memory, std::size_t) noexcept {
+    std::free(memory);
+}
+
+void operator delete[](void* memory, std::size_t) noexcept {
+    std::free(memory);
+}
+
+void operator delete(void* memory, const std::nothrow_t&) noexcept {
+    std::free(memory);
+}
+
+void operator delete[](void* memory, const std::nothrow_t&) noexcept {
+    std::free(memory);
+}
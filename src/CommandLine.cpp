@@ -0,0 +1,372 @@
+#include "CommandLine.hpp"
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <stdexcept>
+
+static std::vector<std::string> splitList(const std::string& text, char separator) {
+    std::vector<std::string> items;
+    std::stringstream stream(text);
+    std::string item;
+    while (std::getline(stream, item, separator)) {
+        items.push_back(item);
+    }
+    return items;
+}
+
+// "8-8" -> {8, 8}; "0" is a topology without hidden layers
+static std::vector<size_t> parseHiddenLayers(const std::string& text) {
+    std::vector<size_t> layers;
+    for (const std::string& item : splitList(text, '-')) {
+        size_t nodes = std::stoul(item);
+        if (nodes > 0) layers.push_back(nodes);
+    }
+    return layers;
+}
+
+bool parseCommandLine(int argc, char* argv[], CommandLine& commandLine) {
+    SweepOptions& sweep = commandLine.sweep;
+    HeadlessOptions& headless = commandLine.headless;
+    BenchmarkOptions& benchmark = commandLine.benchmark;
+
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        auto value = [&]() -> std::string {
+            if (i + 1 >= argc) throw std::invalid_argument(arg + " needs a value");
+            return argv[++i];
+        };
+
+        try {
+            if (arg == "--help" || arg == "-h") {
+                printUsage(argv[0]);
+                return false;
+            } else if (arg == "--inputs") {
+                size_t inputs = std::stoul(value());
+                if (inputs != BASIC_INPUT_NODES && inputs != RAY_INPUT_NODES) {
+                    throw std::invalid_argument("--inputs must be 11 (basic) or 24 (ray casts)");
+                }
+                commandLine.trainer.inputNodes = inputs;
+                headless.inputNodes = inputs;
+                benchmark.inputNodes = inputs;
+                sweep.inputNodes = inputs;
+            } else if (arg == "--headless") {
+                commandLine.mode = RunMode::Headless;
+            } else if (arg == "--check-allocations") {
+                commandLine.mode = RunMode::AllocationCheck;
+            } else if (arg == "--hidden") {
+                headless.hiddenLayers = parseHiddenLayers(value());
+                benchmark.hiddenLayers = headless.hiddenLayers;
+                commandLine.trainer.hiddenLayers = headless.hiddenLayers;
+            } else if (arg == "--topology") {
+                // the whole network, e.g. 11-256-256-3
+                std::vector<size_t> topology = parseHiddenLayers(value());
+                if (topology.size() < 2 || topology.back() != OUTPUT_NODES ||
+                    (topology.front() != BASIC_INPUT_NODES && topology.front() != RAY_INPUT_NODES)) {
+                    throw std::invalid_argument("--topology must start with 11 or 24 inputs and end with " +
+                                                std::to_string(OUTPUT_NODES) + " outputs, e.g. 11-256-256-3");
+                }
+                std::vector<size_t> hidden(topology.begin() + 1, topology.end() - 1);
+                commandLine.trainer.inputNodes = topology.front();
+                commandLine.trainer.hiddenLayers = hidden;
+                headless.inputNodes = topology.front();
+                headless.hiddenLayers = hidden;
+                benchmark.inputNodes = topology.front();
+                benchmark.hiddenLayers = hidden;
+                sweep.inputNodes = topology.front();
+                sweep.hiddenLayers = { hidden };
+                commandLine.diffTest.topologies = { topology };
+            } else if (arg == "--population") {
+                headless.populationSize = std::stoul(value());
+                if (headless.populationSize < 1) throw std::invalid_argument("--population must be at least 1");
+                benchmark.populationSize = headless.populationSize;
+            } else if (arg == "--optimizer") {
+                OptimizerType optimizer;
+                if (!parseOptimizerType(value(), optimizer)) {
+                    throw std::invalid_argument("--optimizer must be ga, es or cmaes");
+                }
+                headless.optimizer = optimizer;
+                commandLine.trainer.optimizer = optimizer;
+            } else if (arg == "--no-loop-detection") {
+                headless.eval.detectLoops = false;
+                commandLine.trainer.detectLoops = false;
+            } else if (arg == "--loop-scoring") {
+                std::string scoring = value();
+                if (scoring == "credit") headless.eval.loopScoring = LoopScoring::CreditRemaining;
+                else if (scoring == "stop") headless.eval.loopScoring = LoopScoring::StopCounting;
+                else throw std::invalid_argument("--loop-scoring must be credit or stop");
+                commandLine.trainer.loopScoring = headless.eval.loopScoring;
+            } else if (arg == "--hidden-activation" || arg == "--output-activation") {
+                ActivationType activation;
+                if (!parseActivationType(value(), activation)) {
+                    throw std::invalid_argument(arg + " must be relu, sigmoid, tanh or identity");
+                }
+                NetworkActivations& activations = headless.eval.activations;
+                (arg == "--hidden-activation" ? activations.hidden : activations.output) = activation;
+                commandLine.trainer.activations = activations;
+            } else if (arg == "--gene-precision") {
+                if (!parseGenePrecision(value(), headless.precision)) {
+                    throw std::invalid_argument("--gene-precision must be double, fp16 or bf16");
+                }
+                commandLine.trainer.precision = headless.precision;
+            } else if (arg == "--compare-precision") {
+                commandLine.mode = RunMode::PrecisionComparison;
+            } else if (arg == "--prune-weights") {
+                headless.pruneThreshold = std::stod(value());
+                commandLine.trainer.pruneThreshold = headless.pruneThreshold;
+            } else if (arg == "--sparse-density") {
+                headless.eval.sparseDensity = std::stod(value());
+                commandLine.trainer.sparseDensity = headless.eval.sparseDensity;
+            } else if (arg == "--benchmark-sparse") {
+                commandLine.mode = RunMode::SparseBenchmark;
+            } else if (arg == "--benchmark-layers") {
+                commandLine.mode = RunMode::LayerBenchmark;
+            } else if (arg == "--widths") {
+                commandLine.sparseBenchmark.widths.clear();
+                for (const std::string& item : splitList(value(), ',')) {
+                    commandLine.sparseBenchmark.widths.push_back(std::stoul(item));
+                }
+                commandLine.layerBenchmark.widths = commandLine.sparseBenchmark.widths;
+            } else if (arg == "--batches") {
+                commandLine.layerBenchmark.batches.clear();
+                for (const std::string& item : splitList(value(), ',')) {
+                    commandLine.layerBenchmark.batches.push_back(std::stoul(item));
+                }
+            } else if (arg == "--zero-share") {
+                commandLine.layerBenchmark.zeroShare = std::stod(value());
+            } else if (arg == "--densities") {
+                commandLine.sparseBenchmark.densities.clear();
+                for (const std::string& item : splitList(value(), ',')) {
+                    commandLine.sparseBenchmark.densities.push_back(std::stod(item));
+                }
+            } else if (arg == "--screen-steps") {
+                headless.screening.screenSteps = std::stoi(value());
+                commandLine.trainer.screening = headless.screening;
+            } else if (arg == "--promote-fraction") {
+                headless.screening.promoteFraction = std::stod(value());
+                commandLine.trainer.screening = headless.screening;
+            } else if (arg == "--promote-ucb") {
+                headless.screening.ucb = std::stod(value());
+                commandLine.trainer.screening = headless.screening;
+            } else if (arg == "--elite-fraction") {
+                headless.screening.eliteFraction = std::stod(value());
+                commandLine.trainer.screening = headless.screening;
+            } else if (arg == "--episodes") {
+                headless.eval.episodes = std::stoi(value());
+                if (headless.eval.episodes < 1) throw std::invalid_argument("--episodes must be at least 1");
+                commandLine.trainer.episodes = headless.eval.episodes;
+                commandLine.diffTest.episodes = (size_t)headless.eval.episodes;
+            } else if (arg == "--aggregate") {
+                std::string aggregate = value();
+                if (aggregate == "mean") {
+                    headless.eval.aggregate = EpisodeAggregate::Mean;
+                } else if (aggregate == "min") {
+                    headless.eval.aggregate = EpisodeAggregate::Min;
+                } else {
+                    // "q0.25": the 25th percentile episode
+                    if (aggregate.size() < 2 || aggregate[0] != 'q') {
+                        throw std::invalid_argument("--aggregate must be mean, min or qQUANTILE, e.g. q0.25");
+                    }
+                    headless.eval.aggregate = EpisodeAggregate::Quantile;
+                    headless.eval.aggregateQuantile = std::stod(aggregate.substr(1));
+                }
+                commandLine.trainer.aggregate = headless.eval.aggregate;
+                commandLine.trainer.aggregateQuantile = headless.eval.aggregateQuantile;
+            } else if (arg == "--compare-screening") {
+                commandLine.mode = RunMode::ScreeningComparison;
+            } else if (arg == "--compare-optimizers") {
+                commandLine.mode = RunMode::Benchmark;
+            } else if (arg == "--optimizers") {
+                benchmark.optimizers.clear();
+                for (const std::string& item : splitList(value(), ',')) {
+                    OptimizerType optimizer;
+                    if (!parseOptimizerType(item, optimizer)) {
+                        throw std::invalid_argument("unknown optimizer " + item);
+                    }
+                    benchmark.optimizers.push_back(optimizer);
+                }
+            } else if (arg == "--target-score") {
+                benchmark.targetScore = std::stoi(value());
+            } else if (arg == "--max-evaluations") {
+                benchmark.maxEvaluations = std::stoul(value());
+            } else if (arg == "--repeats") {
+                benchmark.repeats = std::stoul(value());
+                headless.repeats = benchmark.repeats;
+            } else if (arg == "--sweep") {
+                commandLine.mode = RunMode::Sweep;
+            } else if (arg == "--topologies") {
+                sweep.hiddenLayers.clear();
+                for (const std::string& item : splitList(value(), ',')) {
+                    sweep.hiddenLayers.push_back(parseHiddenLayers(item));
+                }
+            } else if (arg == "--populations") {
+                sweep.populationSizes.clear();
+                for (const std::string& item : splitList(value(), ',')) {
+                    sweep.populationSizes.push_back(std::stoul(item));
+                    if (sweep.populationSizes.back() < 1) {
+                        throw std::invalid_argument("--populations must be at least 1 each");
+                    }
+                }
+            } else if (arg == "--mutation-rates") {
+                sweep.mutationRates.clear();
+                for (const std::string& item : splitList(value(), ',')) {
+                    sweep.mutationRates.push_back(std::stod(item));
+                }
+            } else if (arg == "--mutation-strengths") {
+                sweep.mutationStrengths.clear();
+                for (const std::string& item : splitList(value(), ',')) {
+                    sweep.mutationStrengths.push_back(std::stod(item));
+                }
+            } else if (arg == "--generations") {
+                sweep.generations = std::stoul(value());
+                headless.generations = sweep.generations;
+            } else if (arg == "--thresholds") {
+                sweep.scoreThresholds.clear();
+                for (const std::string& item : splitList(value(), ',')) {
+                    sweep.scoreThresholds.push_back(std::stoi(item));
+                }
+            } else if (arg == "--prune-after") {
+                sweep.pruneAfter = std::stoul(value());
+            } else if (arg == "--prune-ratio") {
+                sweep.pruneRatio = std::stod(value());
+            } else if (arg == "--threads") {
+                sweep.threads = std::stoul(value());
+                headless.threads = sweep.threads;
+                benchmark.threads = sweep.threads;
+                commandLine.diffTest.threads = sweep.threads;
+            } else if (arg == "--pin-threads") {
+                headless.pinThreads = true;
+                commandLine.trainer.pinThreads = true;
+            } else if (arg == "--scaling-report") {
+                commandLine.mode = RunMode::ScalingReport;
+            } else if (arg == "--metrics-socket") {
+                commandLine.metricsSocket = value();
+            } else if (arg == "--trace") {
+                commandLine.tracePath = value();
+            } else if (arg == "--log") {
+                headless.logPath = value();
+            } else if (arg == "--trajectories") {
+                headless.trajectoryPath = value();
+            } else if (arg == "--trajectory-rate") {
+                headless.trajectory.sampleRate = std::stod(value());
+            } else if (arg == "--trajectory-buffer") {
+                headless.trajectory.bufferBytes = std::stoul(value()) << 20;
+            } else if (arg == "--trajectory-drop") {
+                headless.trajectory.dropWhenFull = true;
+            } else if (arg == "--read-trajectories") {
+                commandLine.mode = RunMode::TrajectorySummary;
+                commandLine.trajectoryPath = value();
+            } else if (arg == "--log-dir") {
+                commandLine.trainer.logDir = value();
+            } else if (arg == "--tail-log") {
+                commandLine.mode = RunMode::TailLog;
+                commandLine.tailLogPath = value();
+            } else if (arg == "--out") {
+                sweep.outputPath = value();
+                benchmark.outputPath = sweep.outputPath;
+                commandLine.sparseBenchmark.outputPath = sweep.outputPath;
+                commandLine.layerBenchmark.outputPath = sweep.outputPath;
+            } else if (arg == "--difftest") {
+                commandLine.mode = RunMode::DiffTest;
+            } else if (arg == "--policies") {
+                commandLine.diffTest.policies = std::stoul(value());
+            } else if (arg == "--seed") {
+                commandLine.diffTest.seed = std::stoull(value(), nullptr, 0);
+            } else if (arg == "--check-export") {
+                commandLine.mode = RunMode::ExportCheck;
+                commandLine.exportCheckDir = value();
+            } else {
+                throw std::invalid_argument("unknown option " + arg);
+            }
+        } catch (const std::exception& e) {
+            std::cerr << "Error: " << e.what() << std::endl;
+            printUsage(argv[0]);
+            return false;
+        }
+    }
+    return true;
+}
+
+void printUsage(const char* program) {
+    std::cout << "Usage: " << program << " [options]\n"
+              << "  (no options)              interactive SDL trainer\n"
+              << "  --inputs N                11 for one-cell sensors, 24 for 8-direction ray casts\n"
+              << "  --topology LIST           the whole network, e.g. 11-256-256-3 (any mode); --hidden sets\n"
+              << "                            just the hidden layers, e.g. 16-8 (0 = none)\n"
+              << "  --optimizer NAME          ga (default), es (OpenAI-style ES) or cmaes (separable CMA-ES)\n"
+              << "  --hidden-activation NAME  relu (default), sigmoid, tanh or identity for the hidden layers\n"
+              << "  --output-activation NAME  relu (default), sigmoid, tanh or identity for the output layer\n"
+              << "  --no-loop-detection       play looping games out until starvation\n"
+              << "  --loop-scoring MODE       credit (default): a loop scores the steps it would have run;\n"
+              << "                            stop: only the steps played count\n"
+              << "  --gene-precision P        store population genes as double (default), fp16 or bf16\n"
+              << "  --prune-weights T         GA: zero new genes below T in magnitude (default 0 = off)\n"
+              << "  --sparse-density D        run layers with at most D nonzero weights sparse (default 0.1)\n"
+              << "  --episodes K              games per individual, on food seeds shared by the generation\n"
+              << "    --aggregate MODE        mean (default), min or a quantile such as q0.25\n"
+              << "  --screen-steps N          screen every individual with an N-step game first (0 = off)\n"
+              << "    --promote-fraction F    share of the population promoted to full games (default 0.2)\n"
+              << "    --promote-ucb C         also promote games whose bound reaches the elite, 0 = off (default 0.5)\n"
+              << "    --elite-fraction F      the elite that bound is compared with (default 0.05)\n"
+              << "  --log-dir DIR             where the interactive trainer writes its generation logs\n"
+              << "  --headless                train one population without a window\n"
+              << "    --hidden LIST           hidden layer sizes, e.g. 8 or 16-8 (0 = none)\n"
+              << "    --population N          population size\n"
+              << "    --generations N         generations to train\n"
+              << "    --threads N             worker threads (default: all cores)\n"
+              << "    --pin-threads           pin workers to CPUs and keep each NUMA node on its own share\n"
+              << "                            of the population (also for the trainer and --scaling-report)\n"
+              << "    --log FILE              write a generation log\n"
+              << "    --trajectories FILE     record every step (inputs, outputs, action, reward) to FILE\n"
+              << "    --trajectory-rate R     share of games recorded (default 1)\n"
+              << "    --trajectory-buffer MB  ring memory for all workers (default 64)\n"
+              << "    --trajectory-drop       drop steps when the writer falls behind instead of waiting\n"
+              << "  --compare-screening       train --repeats times with and without screening and compare\n"
+              << "                            steps with champion fitness on held-out games\n"
+              << "  --compare-precision       train --repeats times per gene precision and compare memory\n"
+              << "                            per individual with champion fitness on held-out games\n"
+              << "  --scaling-report          train on 1, 2, 4, ... workers up to all cores and print the\n"
+              << "                            parallel efficiency (takes the --headless options)\n"
+              << "  --check-allocations       play --population games on one evaluation context and fail\n"
+              << "                            if they allocate (takes --inputs and --hidden)\n"
+              << "  --sweep                   train a hyperparameter grid headless\n"
+              << "    --topologies LIST       hidden layers per topology, e.g. 4,8,8-8 (0 = none)\n"
+              << "    --populations LIST      population sizes, e.g. 200,500\n"
+              << "    --mutation-rates LIST   per-gene mutation rates, e.g. 0.02,0.05\n"
+              << "    --mutation-strengths LIST\n"
+              << "                            mutation noise deviations, e.g. 0.1,0.2 (default 0.2)\n"
+              << "    --generations N         generation budget per configuration\n"
+              << "    --thresholds LIST       mean champion scores on held-out games to time, e.g. 5,10,20\n"
+              << "    --prune-after N         earliest generation a run may be stopped\n"
+              << "    --prune-ratio R         stop runs below R x the leader's best fitness\n"
+              << "    --threads N             worker threads (default: all cores)\n"
+              << "    --out FILE              results table (CSV)\n"
+              << "  --compare-optimizers      count the game evaluations each optimizer needs to reach a score\n"
+              << "    --optimizers LIST       optimizers to compare, e.g. ga,es,cmaes\n"
+              << "    --target-score N        food count that ends a run\n"
+              << "    --max-evaluations N     evaluation budget per run\n"
+              << "    --repeats N             runs per optimizer\n"
+              << "    --hidden, --population, --threads, --out as above\n"
+              << "  --benchmark-sparse        time dense against sparse layers over a range of densities\n"
+              << "    --widths LIST           layer widths, e.g. 8,32,128,512\n"
+              << "    --densities LIST        shares of nonzero weights, e.g. 1,0.5,0.1\n"
+              << "    --out FILE              results table (CSV)\n"
+              << "  --benchmark-layers        time the blocked layer kernels against a plain reference\n"
+              << "    --widths LIST           layer widths (default 8,16,...,1024)\n"
+              << "    --batches LIST          input vectors per call (default 1,8)\n"
+              << "    --zero-share S          share of zero layer inputs (default 0.5)\n"
+              << "    --out FILE              results table (CSV)\n"
+              << "  --read-trajectories FILE  decode a trajectory file and print its chunks\n"
+              << "  --tail-log FILE           print a generation log as it grows, until its run ends\n"
+              << "  --metrics-socket PATH     serve live Prometheus metrics on a Unix socket (any mode)\n"
+              << "  --trace FILE              write a Chrome trace on exit (build with make TRACE=1)\n"
+              << "  --difftest                play seeded games on an independent reference game and network\n"
+              << "                            and on every optimized engine, check the other optimized parts\n"
+              << "                            against plain implementations, and fail on any difference\n"
+              << "                            (make difftest)\n"
+              << "    --policies N            policies per kind (random, pruned, evolved) and topology\n"
+              << "                            (default 200)\n"
+              << "    --seed S                seed of the boards, policies, games and training (default 1)\n"
+              << "    --topology, --episodes, --threads as above\n"
+              << "  --check-export DIR        export policy headers and the outputs they must reproduce to DIR,\n"
+              << "                            with a check.cpp that compares them (run by make difftest)\n";
+}
@@ -0,0 +1,1131 @@
+#include "DiffTest.hpp"
+#include "Evaluator.hpp"
+#include "TrainingRun.hpp"
+#include "ThreadPool.hpp"
+#include "Exporter.hpp"
+#include "Random.hpp"
+#include "World.hpp"
+#include "Occupancy.hpp"
+#include "NeuralNetwork.hpp"
+#include "Trajectory.hpp"
+#include "GeneStore.hpp"
+#include "Morphism.hpp"
+#include "snakesim.h"
+#include <iostream>
+#include <fstream>
+#include <cstdio>
+#include <sstream>
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstring>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <cstdlib>
+#include <sys/stat.h>
+#include <unistd.h>
+
+// keep the policy genes, the game seeds, the network inputs, the ray check
+// boards, the morph seeds and the evolved runs apart
+const uint64_t POLICY_SEED_SALT = 0xD1FF9E7E5ull;
+const uint64_t GAME_SEED_SALT = 0xD1FF6A3E5ull;
+const uint64_t INPUT_SEED_SALT = 0xD1FF1A9E7ull;
+const uint64_t RAY_SEED_SALT = 0xD1FF4A7C5ull;
+const uint64_t MORPH_SEED_SALT = 0xD1FF30E9Full;
+const uint64_t EVOLVED_SEED_SALT = 0xD1FFE7015ull;
+// share of genes a pruned policy keeps
+const double PRUNED_DENSITY = 0.05;
+// rows of the training run the evolved policies come from
+const size_t EVOLVED_POPULATION = 100;
+// differences printed per check or worker; all of them are counted
+const size_t MAX_REPORTED = 5;
+// pixels per board cell, as in World
+const int CELL_SIZE = 20;
+// random boards of the ray check, and start cells cast from on each
+const size_t RAY_CHECK_BOARDS = 4000;
+const size_t RAY_CHECK_STARTS = 32;
+// batch sizes of the batching check, odd ones to reach the kernels' tails
+const size_t CHECK_BATCHES[] = { 2, 3, 8, 13 };
+// policies of each kind per topology in the network checks
+const size_t NETWORK_CHECK_POLICIES = 20;
+// random doubles each narrow gene precision rounds in the precision check
+const size_t PRECISION_CHECK_VALUES = 1 << 20;
+// rows of the trajectory round trip: two full chunks and a partial one
+const size_t TRAJECTORY_CHECK_ROWS = 2 * TrajectoryWriter::CHUNK_ROWS + 1234;
+
+enum class PolicyKind {
+    Random,
+    Pruned,
+    Evolved
+};
+
+static const char* policyKindName(PolicyKind kind) {
+    switch (kind) {
+        case PolicyKind::Random: return "random";
+        case PolicyKind::Pruned: return "pruned";
+        case PolicyKind::Evolved: return "evolved";
+    }
+    return "?";
+}
+
+// compass directions clockwise from up; headings are 0, 2, 4 and 6
+static const Point COMPASS[8] = { {0, -1}, {1, -1}, {1, 0}, {1, 1}, {0, 1}, {-1, 1}, {-1, 0}, {-1, -1} };
+
+// The nearest occupied cell along (dx, dy), found by walking the board.
+static int walkedDistance(const std::vector<int>& counts, Point from, int dx, int dy) {
+    const int size = OccupancyGrid::MAX_SIZE;
+    for (int k = 1;; ++k) {
+        int x = from.x + k * dx;
+        int y = from.y + k * dy;
+        if (x < 0 || x >= size || y < 0 || y >= size) return 0;
+        if (counts[y * size + x] > 0) return k;
+    }
+}
+
+// OccupancyGrid against a plain count per cell on random boards: from
+// empty to a quarter full, some cells holding two body parts (as right
+// after the snake grows) and some parts removed again (as when it moves).
+// Every ray from random start cells in all 8 directions must hit the same
+// cell as the walk.
+static size_t checkRays(const DiffTestOptions& options) {
+    const int SIZE = OccupancyGrid::MAX_SIZE;
+    OccupancyGrid grid;
+    std::vector<int> counts(SIZE * SIZE);
+    std::vector<Point> parts;
+    size_t rays = 0;
+    size_t mismatches = 0;
+    for (size_t b = 0; b < RAY_CHECK_BOARDS; ++b) {
+        const uint64_t key = streamKey(options.seed ^ RAY_SEED_SALT, b, 0);
+        uint64_t counter = 0;
+        auto next = [&](size_t n) { return (int)randomIndex(counterRandom(key, counter++), n); };
+
+        grid.clear();
+        std::fill(counts.begin(), counts.end(), 0);
+        parts.clear();
+        size_t partCount = b * (SIZE * SIZE / 4) / RAY_CHECK_BOARDS;
+        for (size_t i = 0; i < partCount; ++i) {
+            Point p = !parts.empty() && next(8) == 0 ? parts.back() : Point{ next(SIZE), next(SIZE) };
+            parts.push_back(p);
+            grid.add(p);
+            counts[p.y * SIZE + p.x]++;
+        }
+        for (const Point& p : parts) {
+            if (next(3) != 0) continue;
+            grid.remove(p);
+            counts[p.y * SIZE + p.x]--;
+        }
+
+        for (size_t s = 0; s < RAY_CHECK_STARTS; ++s) {
+            Point from = { next(SIZE), next(SIZE) };
+            for (const Point& d : COMPASS) {
+                int expected = walkedDistance(counts, from, d.x, d.y);
+                int actual = grid.distanceTo(from, d.x, d.y);
+                rays++;
+                if (actual != expected && mismatches++ < MAX_REPORTED) {
+                    std::cerr << "  board " << b << ": the ray from (" << from.x << ", " << from.y << ") along ("
+                              << d.x << ", " << d.y << ") hits at " << actual << ", the walk at " << expected
+                              << std::endl;
+                }
+            }
+        }
+    }
+    std::cout << "Differential test: rays, " << rays << " rays, " << mismatches << " differences" << std::endl;
+    return mismatches;
+}
+
+enum Engine {
+    ENGINE_REFERENCE,
+    ENGINE_CONTEXT,
+    ENGINE_LOOPS,
+    ENGINE_LOCKSTEP,
+    ENGINE_BRAIN_FITNESS,
+    ENGINE_MORPHED,
+    ENGINE_SNAKESIM,
+    ENGINE_COUNT
+};
+
+static const char* ENGINE_NAMES[ENGINE_COUNT] = {
+    "reference", "EvalContext", "EvalContext + loop detection", "lockstep episodes",
+    "evaluate_brain_fitness", "morphed network", "snakesim"
+};
+
+/**
+ * @brief What the reference game saw: the sensors before every step, the
+ * action it took, and the score and death flag after it.
+ */
+struct ReferenceTrace {
+    std::vector<double> observations;
+    std::vector<int> actions;
+    std::vector<int> scores;
+    std::vector<char> deaths;
+};
+
+static double referenceActivation(ActivationType type, double x) {
+    switch (type) {
+        case ActivationType::SIGMOID: return 1.0 / (1.0 + std::exp(-x));
+        case ActivationType::RELU: return x > 0.0 ? x : 0.0;
+        case ActivationType::TANH: return std::tanh(x);
+        case ActivationType::IDENTITY: return x;
+    }
+    return x;
+}
+
+/**
+ * @brief The network as the genes define it, evaluated the plain way: per
+ * layer the biases, then the weights neuron by neuron, and every neuron sums
+ * its bias and then each input times its weight in input order. Sigmoid and
+ * tanh come from std::exp and std::tanh, so only ReLU and identity networks
+ * can match the engines bit for bit, and the test plays ReLU ones.
+ */
+struct ReferenceNetwork {
+    std::vector<size_t> topology;
+    std::vector<ActivationType> activations;
+    const double* genes = nullptr;
+    std::vector<double> current;
+    std::vector<double> next;
+
+    // the action with the largest output, the first of equal ones
+    int decide(const double* inputs) {
+        current.assign(inputs, inputs + topology.front());
+        const double* gene = genes;
+        for (size_t l = 1; l < topology.size(); ++l) {
+            const double* biases = gene;
+            const double* weights = gene + topology[l];
+            next.assign(topology[l], 0.0);
+            for (size_t n = 0; n < topology[l]; ++n) {
+                double sum = biases[n];
+                for (size_t p = 0; p < topology[l - 1]; ++p) sum += current[p] * weights[n * topology[l - 1] + p];
+                next[n] = referenceActivation(activations[l - 1], sum);
+            }
+            gene = weights + topology[l] * topology[l - 1];
+            current.swap(next);
+        }
+        int best = 0;
+        for (size_t o = 1; o < current.size(); ++o) {
+            if (current[o] > current[best]) best = (int)o;
+        }
+        return best;
+    }
+};
+
+/**
+ * @brief The game rules written out plainly, without World, Snake or the
+ * occupancy grid. Food positions come from the seed's counter stream, x
+ * then y, like Food::move_randomly.
+ */
+struct ReferenceGame {
+    int columns;
+    int rows;
+    std::deque<Point> body;
+    int heading;
+    Point food;
+    uint64_t foodKey;
+    uint64_t foodDraws;
+    int score;
+    bool died;
+
+    ReferenceGame(int columns, int rows, uint64_t seed)
+        : columns(columns), rows(rows), foodKey(mixBits(seed)), foodDraws(0), died(false) {
+        reset();
+    }
+
+    bool inside(Point c) const { return c.x >= 0 && c.x < columns && c.y >= 0 && c.y < rows; }
+
+    // segments first..last-1 of the body
+    bool onBody(Point c, size_t first, size_t last) const {
+        for (size_t i = first; i < last; ++i) {
+            if (body[i] == c) return true;
+        }
+        return false;
+    }
+
+    void placeFood() {
+        food.x = (int)randomIndex(counterRandom(foodKey, foodDraws++), (size_t)columns);
+        food.y = (int)randomIndex(counterRandom(foodKey, foodDraws++), (size_t)rows);
+    }
+
+    void reset() {
+        body = { {25, 25}, {24, 25}, {23, 25} };
+        heading = 2;
+        placeFood();
+        score = 0;
+    }
+
+    // action 0 turns left, 1 goes straight, 2 turns right
+    void step(int action) {
+        if (action == 0) heading = (heading + 6) % 8;
+        if (action == 2) heading = (heading + 2) % 8;
+        Point head = { body.front().x + COMPASS[heading].x, body.front().y + COMPASS[heading].y };
+        body.push_front(head);
+        body.pop_back();
+
+        died = !inside(head) || onBody(head, 1, body.size());
+        if (died) reset();
+        if (body.front() == food) {
+            body.push_back(body.back());
+            // the new food may land on the head, not on the rest of the body
+            do {
+                placeFood();
+            } while (onBody(food, 1, body.size()));
+            score++;
+        }
+    }
+
+    // 11 sensors: danger left, straight, right (wall or body without head
+    // and tail end); food left, right, straight, back of the heading; tail
+    // left, right, up, down on the board
+    void basicSensors(double* out) const {
+        Point head = body.front();
+        Point tail = body.back();
+        const int turns[3] = { 6, 0, 2 };
+        for (int t = 0; t < 3; ++t) {
+            Point d = COMPASS[(heading + turns[t]) % 8];
+            Point c = { head.x + d.x, head.y + d.y };
+            out[t] = !inside(c) || onBody(c, 1, body.size() - 1) ? 1.0 : 0.0;
+        }
+        Point forward = COMPASS[heading];
+        Point left = COMPASS[(heading + 6) % 8];
+        int fx = food.x - head.x;
+        int fy = food.y - head.y;
+        int alongLeft = fx * left.x + fy * left.y;
+        int alongForward = fx * forward.x + fy * forward.y;
+        out[3] = alongLeft > 0 ? 1.0 : 0.0;
+        out[4] = alongLeft < 0 ? 1.0 : 0.0;
+        out[5] = alongForward > 0 ? 1.0 : 0.0;
+        out[6] = alongForward < 0 ? 1.0 : 0.0;
+        out[7] = tail.x < head.x ? 1.0 : 0.0;
+        out[8] = tail.x > head.x ? 1.0 : 0.0;
+        out[9] = tail.y < head.y ? 1.0 : 0.0;
+        out[10] = tail.y > head.y ? 1.0 : 0.0;
+    }
+
+    // 24 sensors: 8 rays clockwise from the heading, each 1/distance to the
+    // wall, to the nearest body cell (head included) and to the food, 0 for
+    // none
+    void raySensors(double* out) const {
+        Point head = body.front();
+        for (int ray = 0; ray < 8; ++ray) {
+            Point d = COMPASS[(heading + ray) % 8];
+            int wall = 1;
+            int nearestBody = 0;
+            int foodAt = 0;
+            for (int k = 1;; ++k) {
+                Point c = { head.x + k * d.x, head.y + k * d.y };
+                if (!inside(c)) {
+                    wall = k;
+                    break;
+                }
+                if (nearestBody == 0 && onBody(c, 0, body.size())) nearestBody = k;
+                if (foodAt == 0 && c == food) foodAt = k;
+            }
+            out[3 * ray] = 1.0 / wall;
+            out[3 * ray + 1] = nearestBody > 0 ? 1.0 / nearestBody : 0.0;
+            out[3 * ray + 2] = foodAt > 0 ? 1.0 / foodAt : 0.0;
+        }
+    }
+};
+
+/**
+ * @brief Everything one pool worker needs, allocated once.
+ */
+struct DiffWorker {
+    std::unique_ptr<EvalContext> exact;
+    std::unique_ptr<EvalContext> looping;
+    std::unique_ptr<EvalContext> lockstep;
+    std::unique_ptr<EvalContext> morphed;
+    std::unique_ptr<snakesim_envs, void (*)(snakesim_envs*)> sim{ nullptr, snakesim_destroy };
+    ReferenceNetwork network;
+    ReferenceTrace trace;
+    std::vector<double> genes;
+    std::vector<double> morphedGenes;
+    std::vector<double> observation;
+    std::vector<uint64_t> seeds;
+    std::vector<GameResult> expected;
+    double seconds[ENGINE_COUNT] = {};
+    long long games[ENGINE_COUNT] = {};
+    long long steps[ENGINE_COUNT] = {};
+    size_t mismatches = 0;
+    std::vector<std::string> reports;
+};
+
+static std::string topologyName(const std::vector<size_t>& topology) {
+    std::stringstream name;
+    for (size_t l = 0; l < topology.size(); ++l) name << (l > 0 ? "-" : "") << topology[l];
+    return name.str();
+}
+
+// Random genes in [-1, 1); pruned policies keep a gene with probability
+// PRUNED_DENSITY, judged by its magnitude, which is uniform in [0, 1).
+static void fillPolicy(PolicyKind kind, uint64_t key, double* genes, size_t count) {
+    fillUniform(key, 0, genes, count, -1.0, 1.0);
+    if (kind != PolicyKind::Pruned) return;
+    for (size_t g = 0; g < count; ++g) {
+        if (std::abs(genes[g]) >= PRUNED_DENSITY) genes[g] = 0.0;
+        else genes[g] /= PRUNED_DENSITY;
+    }
+}
+
+// Sensor-like inputs: half of them zero, the rest in [0, 1).
+static void fillInputs(uint64_t key, double* inputs, size_t count) {
+    fillUniform(key, 0, inputs, count, 0.0, 2.0);
+    for (size_t i = 0; i < count; ++i) inputs[i] = inputs[i] < 1.0 ? 0.0 : inputs[i] - 1.0;
+}
+
+static bool sameBits(const double* a, const double* b, size_t count) {
+    return std::memcmp(a, b, count * sizeof(double)) == 0;
+}
+
+// The reference game: a ReferenceGame driven by a ReferenceNetwork one step
+// after another, scored like the evaluator without loop detection.
+static GameResult playReference(ReferenceNetwork& network, const EvalConfig& config, uint64_t seed,
+                                ReferenceTrace* trace) {
+    ReferenceGame game(config.width / CELL_SIZE, config.height / CELL_SIZE, seed);
+    const size_t inputs = network.topology.front();
+    double sensors[RAY_INPUT_NODES];
+    if (trace) {
+        trace->observations.clear();
+        trace->actions.clear();
+        trace->scores.clear();
+        trace->deaths.clear();
+    }
+    int steps = 0;
+    int scoreAtLastFood = 0;
+    int stepsSinceLastFood = 0;
+    while (true) {
+        if (inputs == RAY_INPUT_NODES) {
+            game.raySensors(sensors);
+        } else {
+            game.basicSensors(sensors);
+        }
+        int action = network.decide(sensors);
+        if (trace) {
+            trace->observations.insert(trace->observations.end(), sensors, sensors + inputs);
+            trace->actions.push_back(action);
+        }
+        game.step(action);
+        steps++;
+        if (trace) {
+            trace->scores.push_back(game.score);
+            trace->deaths.push_back(game.died ? 1 : 0);
+        }
+        stepsSinceLastFood++;
+        if (game.score > scoreAtLastFood) {
+            scoreAtLastFood = game.score;
+            stepsSinceLastFood = 0;
+        }
+        if (stepsSinceLastFood > STARVATION_STEPS || steps >= config.maxSteps) break;
+    }
+    double fitness = (double)steps + (double)(game.score * 1000.0);
+    return { fitness, steps, game.score, 0, false };
+}
+
+static void report(DiffWorker& worker, const std::string& game, Engine engine, const std::string& what) {
+    worker.mismatches++;
+    if (worker.reports.size() < MAX_REPORTED) {
+        worker.reports.push_back(game + ": " + ENGINE_NAMES[engine] + " " + what);
+    }
+}
+
+static std::string describe(const GameResult& result) {
+    std::stringstream text;
+    text << "fitness " << result.fitness << ", steps " << result.steps << ", score " << result.score
+         << ", saved " << result.stepsSaved << (result.truncated ? ", truncated" : "");
+    return text.str();
+}
+
+static void compareExact(DiffWorker& worker, const std::string& game, Engine engine, const GameResult& actual,
+                         const GameResult& expected) {
+    if (actual.fitness != expected.fitness || actual.steps != expected.steps || actual.score != expected.score ||
+        actual.stepsSaved != expected.stepsSaved || actual.truncated != expected.truncated) {
+        report(worker, game, engine, "gave " + describe(actual) + ", reference " + describe(expected));
+    }
+}
+
+// a game cut by loop detection credits the steps it did not play
+static void compareLooping(DiffWorker& worker, const std::string& game, Engine engine, const GameResult& actual,
+                           const GameResult& expected) {
+    if (actual.fitness != expected.fitness || actual.score != expected.score ||
+        actual.steps + actual.stepsSaved != expected.steps || actual.truncated) {
+        report(worker, game, engine, "gave " + describe(actual) + ", reference " + describe(expected));
+    }
+}
+
+// replays the reference game's actions on the snakesim ABI, step by step
+static void compareSimulation(DiffWorker& worker, const std::string& game, const std::vector<size_t>& topology,
+                              uint64_t seed) {
+    const size_t inputs = topology.front();
+    const ReferenceTrace& trace = worker.trace;
+    size_t steps = trace.scores.size();
+    worker.observation.resize(inputs);
+    double* observation = worker.observation.data();
+
+    auto sameObservation = [&](size_t step) {
+        const double* expected = trace.observations.data() + step * inputs;
+        return std::equal(observation, observation + inputs, expected);
+    };
+    std::stringstream what;
+    if (snakesim_reset(worker.sim.get(), &seed, observation) != 0) {
+        what << "could not reset";
+    } else if (!sameObservation(0)) {
+        what << "observation differs before step 0";
+    }
+    for (size_t s = 0; s < steps && what.tellp() == 0; ++s) {
+        int32_t action = trace.actions[s];
+        double reward;
+        uint8_t done;
+        int32_t score;
+        if (snakesim_step(worker.sim.get(), &action, observation, &reward, &done) != 0 ||
+            snakesim_scores(worker.sim.get(), &score) != 0) {
+            what << "failed at step " << s;
+        } else if (score != trace.scores[s]) {
+            what << "score " << score << " at step " << s << ", reference " << trace.scores[s];
+        } else if ((done != 0) != (trace.deaths[s] != 0)) {
+            what << (done ? "died" : "survived") << " at step " << s << ", unlike the reference";
+        } else if (s + 1 < steps && !sameObservation(s + 1)) {
+            what << "observation differs after step " << s;
+        }
+    }
+    worker.steps[ENGINE_SNAKESIM] += (long long)steps;
+    if (what.tellp() > 0) report(worker, game, ENGINE_SNAKESIM, what.str());
+}
+
+template <typename Run>
+static auto timed(DiffWorker& worker, Engine engine, Run run) -> decltype(run()) {
+    auto start = std::chrono::steady_clock::now();
+    auto result = run();
+    worker.seconds[engine] += std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    worker.games[engine]++;
+    return result;
+}
+
+// Plays one policy on the reference and on every engine.
+static void checkPolicy(DiffWorker& worker, const std::vector<size_t>& topology, const double* genes,
+                        size_t geneCount, const std::string& game, const EvalConfig& exactConfig,
+                        const EvalConfig& loopConfig) {
+    worker.network.topology = topology;
+    worker.network.activations = exactConfig.activations.forLayers(topology.size() - 1);
+    worker.network.genes = genes;
+
+    size_t episodes = worker.seeds.size();
+    worker.expected.resize(episodes);
+    for (size_t k = 0; k < episodes; ++k) {
+        worker.expected[k] = timed(worker, ENGINE_REFERENCE, [&]() {
+            return playReference(worker.network, exactConfig, worker.seeds[k], k == 0 ? &worker.trace : nullptr);
+        });
+        worker.steps[ENGINE_REFERENCE] += worker.expected[k].steps;
+    }
+    const GameResult& expected = worker.expected[0];
+    uint64_t seed = worker.seeds[0];
+
+    GameResult exact = timed(worker, ENGINE_CONTEXT, [&]() {
+        return worker.exact->evaluate(topology, genes, geneCount, seed);
+    });
+    worker.steps[ENGINE_CONTEXT] += exact.steps;
+    compareExact(worker, game, ENGINE_CONTEXT, exact, expected);
+
+    GameResult looping = timed(worker, ENGINE_LOOPS, [&]() {
+        return worker.looping->evaluate(topology, genes, geneCount, seed);
+    });
+    worker.steps[ENGINE_LOOPS] += looping.steps;
+    compareLooping(worker, game, ENGINE_LOOPS, looping, expected);
+
+    // the summed results of the reference games, mean fitness as evaluateEpisodes takes it
+    GameResult together = { 0.0, 0, 0, 0, false };
+    double fitnessSum = 0.0;
+    for (const GameResult& result : worker.expected) {
+        fitnessSum += result.fitness;
+        together.steps += result.steps;
+        together.score = std::max(together.score, result.score);
+    }
+    together.fitness = fitnessSum / (double)episodes;
+    GameResult lockstep = timed(worker, ENGINE_LOCKSTEP, [&]() {
+        return worker.lockstep->evaluateEpisodes(topology, genes, geneCount, worker.seeds.data());
+    });
+    worker.games[ENGINE_LOCKSTEP] += (long long)episodes - 1;
+    worker.steps[ENGINE_LOCKSTEP] += lockstep.steps;
+    compareExact(worker, game, ENGINE_LOCKSTEP, lockstep, together);
+
+    std::vector<double> row(genes, genes + geneCount);
+    GameResult brainFitness = timed(worker, ENGINE_BRAIN_FITNESS, [&]() {
+        return evaluate_brain_fitness(topology, row, loopConfig, seed);
+    });
+    worker.steps[ENGINE_BRAIN_FITNESS] += brainFitness.steps;
+    compareLooping(worker, game, ENGINE_BRAIN_FITNESS, brainFitness, expected);
+
+    // grown by a neuron or a layer picked from the seed; with ReLU hidden
+    // layers both morphs must leave every game unchanged
+    uint64_t choice = mixBits(seed ^ MORPH_SEED_SALT);
+    size_t hidden = topology.size() - 2;
+    Morph morph = { MorphKind::InsertLayer, 1 + (size_t)((choice >> 1) % (topology.size() - 1)) };
+    if (hidden > 0 && (choice & 1)) morph = { MorphKind::AddNeuron, 1 + (size_t)((choice >> 1) % hidden) };
+    std::vector<size_t> grown = morphedTopology(topology, morph);
+    worker.morphedGenes.resize(NeuralNetwork::geneCountFor(grown));
+    applyMorph(topology, morph, genes, worker.morphedGenes.data(), choice);
+    GameResult morphed = timed(worker, ENGINE_MORPHED, [&]() {
+        return worker.morphed->evaluate(grown, worker.morphedGenes.data(), worker.morphedGenes.size(), seed);
+    });
+    worker.steps[ENGINE_MORPHED] += morphed.steps;
+    compareExact(worker, game + " grown to " + topologyName(grown), ENGINE_MORPHED, morphed, expected);
+
+    timed(worker, ENGINE_SNAKESIM, [&]() {
+        compareSimulation(worker, game, topology, seed);
+        return 0;
+    });
+}
+
+/**
+ * @brief The policies every network check runs on: NETWORK_CHECK_POLICIES
+ * of each kind per tested topology, seeded from options.seed.
+ * @param check Called with the topology's index, the kind, the policy's
+ * index within its kind, the genes, and the policy's name for reports.
+ */
+static void forEachCheckPolicy(const DiffTestOptions& options,
+                               const std::function<void(size_t, PolicyKind, size_t, const std::vector<double>&,
+                                                        const std::string&)>& check) {
+    std::vector<double> genes;
+    for (size_t t = 0; t < options.topologies.size(); ++t) {
+        const std::vector<size_t>& topology = options.topologies[t];
+        genes.resize(NeuralNetwork::geneCountFor(topology));
+        for (PolicyKind kind : { PolicyKind::Random, PolicyKind::Pruned }) {
+            for (size_t i = 0; i < NETWORK_CHECK_POLICIES; ++i) {
+                fillPolicy(kind, streamKey(options.seed ^ POLICY_SEED_SALT, (uint64_t)t * 3 + (uint64_t)kind, i),
+                           genes.data(), genes.size());
+                check(t, kind, i, genes,
+                      topologyName(topology) + " " + policyKindName(kind) + " policy " + std::to_string(i));
+            }
+        }
+    }
+}
+
+// feedForwardBatch against feedForward on each row, bit for bit, with the
+// layer formats the engines pick (pruned policies take the sparse kernels).
+static size_t checkBatching(const DiffTestOptions& options) {
+    size_t rows = 0;
+    size_t mismatches = 0;
+    std::vector<double> batch;
+    forEachCheckPolicy(options, [&](size_t t, PolicyKind, size_t i, const std::vector<double>& genes,
+                                    const std::string& policy) {
+        const std::vector<size_t>& topology = options.topologies[t];
+        const size_t inputs = topology.front();
+        const size_t outputs = topology.back();
+        NeuralNetwork batched(topology, ActivationType::RELU);
+        NeuralNetwork single(topology, ActivationType::RELU);
+        batched.setGenes(genes);
+        single.setGenes(genes);
+        for (size_t size : CHECK_BATCHES) {
+            batch.resize(size * inputs);
+            fillInputs(streamKey(options.seed ^ INPUT_SEED_SALT, t, i * 64 + size), batch.data(), batch.size());
+            const double* together = batched.feedForwardBatch(batch.data(), size);
+            for (size_t r = 0; r < size; ++r) {
+                rows++;
+                if (sameBits(single.feedForward(batch.data() + r * inputs), together + r * outputs, outputs)) {
+                    continue;
+                }
+                if (mismatches++ < MAX_REPORTED) {
+                    std::cerr << "  " << policy << ": feedForwardBatch row " << r << " of " << size
+                              << " differs from feedForward" << std::endl;
+                }
+            }
+        }
+    });
+    std::cout << "Differential test: batching, " << rows << " rows, " << mismatches << " differences" << std::endl;
+    return mismatches;
+}
+
+// Every layer on the sparse kernel against every layer dense, bit for bit,
+// one row at a time and batched. Skipping a zero weight must not change the
+// sum, so pruned genes and random ones give the same outputs either way.
+static size_t checkSparse(const DiffTestOptions& options) {
+    const size_t BATCH = 8;
+    size_t rows = 0;
+    size_t mismatches = 0;
+    std::vector<double> batch;
+    std::vector<double> expected;
+    forEachCheckPolicy(options, [&](size_t t, PolicyKind, size_t i, const std::vector<double>& genes,
+                                    const std::string& policy) {
+        const std::vector<size_t>& topology = options.topologies[t];
+        const size_t inputs = topology.front();
+        const size_t outputs = topology.back();
+        NeuralNetwork dense(topology, ActivationType::RELU);
+        NeuralNetwork sparse(topology, ActivationType::RELU);
+        dense.setSparseDensity(0.0);
+        sparse.setSparseDensity(1.0);
+        dense.setGenes(genes);
+        sparse.setGenes(genes);
+        // (density 0 still runs a layer without any weights sparse)
+        if (sparse.getSparseLayerCount() != topology.size() - 1) {
+            if (mismatches++ < MAX_REPORTED) {
+                std::cerr << "  " << policy << ": density 1 left a layer dense" << std::endl;
+            }
+            return;
+        }
+        batch.resize(BATCH * inputs);
+        expected.resize(BATCH * outputs);
+        fillInputs(streamKey(options.seed ^ INPUT_SEED_SALT, t, i * 64 + 1), batch.data(), batch.size());
+        const double* denseBatch = dense.feedForwardBatch(batch.data(), BATCH);
+        std::copy(denseBatch, denseBatch + expected.size(), expected.begin());
+        const double* sparseBatch = sparse.feedForwardBatch(batch.data(), BATCH);
+        bool same = sameBits(sparseBatch, expected.data(), expected.size());
+        for (size_t r = 0; r < BATCH && same; ++r) {
+            same = sameBits(sparse.feedForward(batch.data() + r * inputs), expected.data() + r * outputs, outputs);
+        }
+        rows += BATCH;
+        if (!same && mismatches++ < MAX_REPORTED) {
+            std::cerr << "  " << policy << ": the sparse kernel differs from the dense one" << std::endl;
+        }
+    });
+    std::cout << "Differential test: sparse kernel, " << rows << " rows, " << mismatches << " differences"
+              << std::endl;
+    return mismatches;
+}
+
+// Every AddNeuron and InsertLayer a topology allows, on random and pruned
+// genes: with ReLU hidden layers and sensor-like inputs the grown network
+// must give the outputs of the original bit for bit.
+static size_t checkMorphs(const DiffTestOptions& options) {
+    const size_t BATCH = 8;
+    size_t morphs = 0;
+    size_t mismatches = 0;
+    std::vector<double> batch;
+    std::vector<double> expected;
+    std::vector<double> grownGenes;
+    forEachCheckPolicy(options, [&](size_t t, PolicyKind kind, size_t i, const std::vector<double>& genes,
+                                    const std::string& policy) {
+        const std::vector<size_t>& topology = options.topologies[t];
+        const size_t inputs = topology.front();
+        const size_t outputs = topology.back();
+        NeuralNetwork original(topology, ActivationType::RELU);
+        original.setGenes(genes);
+        batch.resize(BATCH * inputs);
+        expected.resize(BATCH * outputs);
+        fillInputs(streamKey(options.seed ^ INPUT_SEED_SALT, t, i * 64 + 2), batch.data(), batch.size());
+        for (size_t r = 0; r < BATCH; ++r) {
+            const double* row = original.feedForward(batch.data() + r * inputs);
+            std::copy(row, row + outputs, expected.begin() + r * outputs);
+        }
+        const uint64_t key = streamKey(options.seed ^ MORPH_SEED_SALT, (uint64_t)t * 3 + (uint64_t)kind, i);
+        for (size_t layer = 1; layer < topology.size(); ++layer) {
+            for (MorphKind morphKind : { MorphKind::InsertLayer, MorphKind::AddNeuron }) {
+                // (the output layer cannot grow a neuron)
+                if (morphKind == MorphKind::AddNeuron && layer + 1 == topology.size()) continue;
+                const Morph morph = { morphKind, layer };
+                std::vector<size_t> grownTopology = morphedTopology(topology, morph);
+                grownGenes.resize(NeuralNetwork::geneCountFor(grownTopology));
+                applyMorph(topology, morph, genes.data(), grownGenes.data(),
+                           streamKey(key, layer, (uint64_t)morphKind));
+                NeuralNetwork grown(grownTopology, ActivationType::RELU);
+                grown.setGenes(grownGenes);
+                bool same = true;
+                for (size_t r = 0; r < BATCH && same; ++r) {
+                    same = sameBits(grown.feedForward(batch.data() + r * inputs), expected.data() + r * outputs,
+                                    outputs);
+                }
+                morphs++;
+                if (!same && mismatches++ < MAX_REPORTED) {
+                    std::cerr << "  " << policy << ": growing to " << topologyName(grownTopology)
+                              << " changed the outputs" << std::endl;
+                }
+            }
+        }
+    });
+    std::cout << "Differential test: morphs, " << morphs << " grown networks, " << mismatches << " differences"
+              << std::endl;
+    return mismatches;
+}
+
+// The value of a 16-bit gene, worked out independently of GeneStore: half
+// from its fields with ldexp, bfloat16 as the top half of a float.
+static double narrowGeneValue(GenePrecision precision, uint16_t bits) {
+    if (precision == GenePrecision::BFloat16) {
+        uint32_t wide = (uint32_t)bits << 16;
+        float value;
+        std::memcpy(&value, &wide, sizeof(value));
+        return value;
+    }
+    int exponent = (bits >> 10) & 0x1F;
+    int mantissa = bits & 0x3FF;
+    double magnitude = exponent == 0 ? std::ldexp((double)mantissa, -24)
+                                     : std::ldexp((double)(1024 + mantissa), exponent - 25);
+    return (bits & 0x8000) ? -magnitude : magnitude;
+}
+
+// Narrow gene storage: every finite 16-bit value must come back from a
+// GeneStore row unchanged, and any double must come back as the nearest
+// finite value (ties to the even pattern, saturating at the largest).
+static size_t checkGenePrecision(const DiffTestOptions& options) {
+    size_t values = 0;
+    size_t mismatches = 0;
+    for (GenePrecision precision : { GenePrecision::Float16, GenePrecision::BFloat16 }) {
+        const uint16_t INFINITE = precision == GenePrecision::Float16 ? 0x7C00 : 0x7F80;
+        const int MIN_EXPONENT = precision == GenePrecision::Float16 ? -30 : -140;
+        const int MAX_EXPONENT = precision == GenePrecision::Float16 ? 17 : 129;
+        auto mismatch = [&](double value, double stored, double expected) {
+            if (mismatches++ < MAX_REPORTED) {
+                char line[160];
+                std::snprintf(line, sizeof(line), "  %s genes: %a is stored as %a, expected %a",
+                              genePrecisionName(precision), value, stored, expected);
+                std::cerr << line << std::endl;
+            }
+        };
+
+        // the non-negative finite values in ascending order, index = bits
+        std::vector<double> finite(INFINITE);
+        for (uint16_t bits = 0; bits < INFINITE; ++bits) finite[bits] = narrowGeneValue(precision, bits);
+        auto nearest = [&](double value) {
+            double magnitude = std::abs(value);
+            size_t above = std::lower_bound(finite.begin(), finite.end(), magnitude) - finite.begin();
+            double result;
+            if (above == finite.size()) {
+                result = finite.back();
+            } else if (finite[above] == magnitude || above == 0) {
+                result = finite[above];
+            } else {
+                double down = magnitude - finite[above - 1];
+                double up = finite[above] - magnitude;
+                bool takeUp = up < down || (up == down && above % 2 == 0);
+                result = finite[takeUp ? above : above - 1];
+            }
+            return std::copysign(result, value);
+        };
+
+        // every finite pattern of both signs, then random doubles over the
+        // whole exponent range and the midpoints between neighbours
+        std::vector<double> input;
+        for (uint16_t bits = 0; bits < INFINITE; ++bits) {
+            input.push_back(finite[bits]);
+            input.push_back(-finite[bits]);
+        }
+        size_t exact = input.size();
+        const uint64_t key = streamKey(options.seed ^ INPUT_SEED_SALT, 0xF16, (uint64_t)precision);
+        std::vector<double> fractions(PRECISION_CHECK_VALUES);
+        fillUniform(key, 0, fractions.data(), fractions.size(), 1.0, 2.0);
+        for (size_t i = 0; i < PRECISION_CHECK_VALUES; ++i) {
+            uint64_t word = counterRandom(key, PRECISION_CHECK_VALUES + i);
+            int exponent = MIN_EXPONENT + (int)randomIndex(word, (size_t)(MAX_EXPONENT - MIN_EXPONENT + 1));
+            double value = std::ldexp(fractions[i], exponent);
+            input.push_back((word >> 63) ? -value : value);
+        }
+        for (uint16_t bits = 1; bits < INFINITE; ++bits) input.push_back(0.5 * (finite[bits - 1] + finite[bits]));
+
+        GeneStore store;
+        store.allocate(1, input.size(), precision);
+        std::vector<double> scratch(input.size());
+        store.commit(0, input.data());
+        const double* stored = store.read(0, scratch.data());
+        for (size_t i = 0; i < input.size(); ++i) {
+            double expected = i < exact ? input[i] : nearest(input[i]);
+            if (!sameBits(&stored[i], &expected, 1)) mismatch(input[i], stored[i], expected);
+        }
+        values += input.size();
+    }
+    std::cout << "Differential test: narrow genes, " << values << " values, " << mismatches << " differences"
+              << std::endl;
+    return mismatches;
+}
+
+// The row the trajectory round trip writes at index j: runs of equal tags
+// like a real recording, random inputs and outputs that are exact floats.
+static TrajectoryStep trajectoryRow(uint64_t key, size_t j, float* inputs, size_t inputCount, float* outputs,
+                                    size_t outputCount) {
+    TrajectoryStep step;
+    step.generation = (uint32_t)(j / 50000);
+    step.individual = (uint32_t)(j / 300 % 100);
+    step.episode = (uint16_t)(j / 150 % 2);
+    step.flags = (j / 7777) % 2 ? TRAJECTORY_SCREENING : 0;
+    step.action = (uint8_t)randomIndex(counterRandom(key, 3 * j), 3);
+    step.step = (uint32_t)(j % 150);
+    step.reward = randomIndex(counterRandom(key, 3 * j + 1), 40) == 0 ? 1001.0f : 1.0f;
+    std::vector<double> values(inputCount + outputCount);
+    fillInputs(streamKey(key, j, 0), values.data(), inputCount);
+    fillUniform(streamKey(key, j, 1), 0, values.data() + inputCount, outputCount, -4.0, 4.0);
+    for (size_t i = 0; i < inputCount; ++i) inputs[i] = (float)values[i];
+    for (size_t o = 0; o < outputCount; ++o) outputs[o] = (float)values[inputCount + o];
+    return step;
+}
+
+// Writes rows through TrajectoryWriter into a temporary file and reads them
+// back with TrajectoryReader; every field must come back unchanged.
+static size_t checkTrajectories(const DiffTestOptions& options) {
+    const char* tmp = std::getenv("TMPDIR");
+    std::string path = std::string(tmp && *tmp ? tmp : "/tmp") + "/snake-difftest-XXXXXX";
+    int fd = mkstemp(&path[0]);
+    if (fd < 0) {
+        std::cerr << "Differential test: could not create " << path << std::endl;
+        return 1;
+    }
+    ::close(fd);
+
+    const size_t inputCount = RAY_INPUT_NODES;
+    const size_t outputCount = OUTPUT_NODES;
+    const uint64_t key = streamKey(options.seed ^ INPUT_SEED_SALT, 0xC0DEC, 0);
+    std::vector<float> inputs(inputCount), outputs(outputCount);
+    std::vector<double> wideInputs(inputCount), wideOutputs(outputCount);
+    size_t mismatches = 0;
+    auto mismatch = [&](const std::string& what) {
+        if (mismatches++ < MAX_REPORTED) std::cerr << "  trajectory round trip: " << what << std::endl;
+    };
+
+    TrajectoryWriter writer;
+    if (!writer.open(path, inputCount, outputCount, 1, TrajectoryOptions())) {
+        std::cerr << "Differential test: could not write " << path << std::endl;
+        std::remove(path.c_str());
+        return 1;
+    }
+    for (size_t j = 0; j < TRAJECTORY_CHECK_ROWS; ++j) {
+        TrajectoryStep step = trajectoryRow(key, j, inputs.data(), inputCount, outputs.data(), outputCount);
+        std::copy(inputs.begin(), inputs.end(), wideInputs.begin());
+        std::copy(outputs.begin(), outputs.end(), wideOutputs.begin());
+        writer.getRing(0)->push(step, wideInputs.data(), wideOutputs.data());
+    }
+    writer.close();
+
+    TrajectoryReader reader;
+    TrajectoryChunk chunk;
+    size_t j = 0;
+    if (!reader.open(path)) {
+        mismatch("could not read the file back");
+    } else if (reader.getRowCount() != TRAJECTORY_CHECK_ROWS || reader.getInputCount() != inputCount ||
+               reader.getOutputCount() != outputCount) {
+        mismatch("the file header does not match what was written");
+    } else {
+        for (size_t c = 0; c < reader.getChunkCount(); ++c) {
+            if (!reader.readChunk(c, chunk)) {
+                mismatch("chunk " + std::to_string(c) + " does not decode");
+                continue;
+            }
+            for (size_t r = 0; r < chunk.rows; ++r, ++j) {
+                TrajectoryStep step = trajectoryRow(key, j, inputs.data(), inputCount, outputs.data(), outputCount);
+                bool same = chunk.generation[r] == step.generation && chunk.individual[r] == step.individual &&
+                            chunk.episode[r] == step.episode && chunk.flags[r] == step.flags &&
+                            chunk.action[r] == step.action && chunk.step[r] == step.step &&
+                            std::memcmp(&chunk.reward[r], &step.reward, sizeof(float)) == 0;
+                for (size_t i = 0; i < inputCount && same; ++i) {
+                    same = std::memcmp(&chunk.inputs[i * chunk.rows + r], &inputs[i], sizeof(float)) == 0;
+                }
+                for (size_t o = 0; o < outputCount && same; ++o) {
+                    same = std::memcmp(&chunk.outputs[o * chunk.rows + r], &outputs[o], sizeof(float)) == 0;
+                }
+                if (!same) mismatch("row " + std::to_string(j) + " differs");
+            }
+        }
+        if (j != TRAJECTORY_CHECK_ROWS) {
+            mismatch("read " + std::to_string(j) + " rows, wrote " + std::to_string(TRAJECTORY_CHECK_ROWS));
+        }
+    }
+    reader.close();
+
+    // an index entry pointing past the end of the file must fail the open
+    // rather than send readChunk outside the mapping
+    if (mismatches == 0) {
+        std::fstream file(path, std::ios::in | std::ios::out | std::ios::binary);
+        TrajectoryFileFooter footer;
+        file.seekg(-(std::streamoff)sizeof(footer), std::ios::end);
+        file.read(reinterpret_cast<char*>(&footer), sizeof(footer));
+        const uint64_t outside = (uint64_t)1 << 40;
+        file.seekp((std::streamoff)(footer.indexOffset + sizeof(uint64_t)));
+        file.write(reinterpret_cast<const char*>(&outside), sizeof(outside));
+        file.close();
+        if (!file || reader.open(path)) mismatch("opened a file whose index points outside it");
+        reader.close();
+    }
+    std::remove(path.c_str());
+
+    std::cout << "Differential test: trajectory round trip, " << TRAJECTORY_CHECK_ROWS << " rows, " << mismatches
+              << " differences" << std::endl;
+    return mismatches;
+}
+
+int runDiffTest(const DiffTestOptions& options) {
+    ThreadPool pool(options.threads);
+    std::vector<DiffWorker> workers(pool.size());
+
+    EvalConfig exactConfig;
+    exactConfig.detectLoops = false;
+    EvalConfig loopConfig;
+    EvalConfig lockstepConfig = exactConfig;
+    lockstepConfig.episodes = (int)std::max<size_t>(1, options.episodes);
+    for (DiffWorker& worker : workers) {
+        worker.exact = std::make_unique<EvalContext>(exactConfig);
+        worker.looping = std::make_unique<EvalContext>(loopConfig);
+        worker.lockstep = std::make_unique<EvalContext>(lockstepConfig);
+        worker.morphed = std::make_unique<EvalContext>(exactConfig);
+        worker.seeds.resize(worker.lockstep->getEpisodeCount());
+    }
+
+    size_t policies = 0;
+    for (size_t t = 0; t < options.topologies.size(); ++t) {
+        const std::vector<size_t>& topology = options.topologies[t];
+        size_t geneCount = NeuralNetwork::geneCountFor(topology);
+        for (DiffWorker& worker : workers) {
+            worker.sim.reset(snakesim_create(1, (uint32_t)(exactConfig.width / CELL_SIZE),
+                                             (uint32_t)(exactConfig.height / CELL_SIZE),
+                                             (uint32_t)topology.front(), 0, 1));
+            if (!worker.sim) {
+                std::cerr << "Differential test: snakesim rejects topology " << topologyName(topology) << std::endl;
+                return 1;
+            }
+        }
+
+        // plays policies first..first+count of a kind; row(i, scratch) gives policy i's genes
+        auto check = [&](PolicyKind kind, size_t first, size_t count,
+                         const std::function<const double*(size_t, double*)>& row) {
+            uint64_t stream = (uint64_t)t * 3 + (uint64_t)kind;
+            pool.parallelFor(count, 0, [&](size_t begin, size_t end, size_t w) {
+                DiffWorker& worker = workers[w];
+                if (worker.genes.size() < geneCount) worker.genes.resize(geneCount);
+                for (size_t i = first + begin; i < first + end; ++i) {
+                    for (size_t k = 0; k < worker.seeds.size(); ++k) {
+                        worker.seeds[k] = streamKey(options.seed ^ GAME_SEED_SALT, stream, i * worker.seeds.size() + k);
+                    }
+                    std::stringstream game;
+                    game << topologyName(topology) << " " << policyKindName(kind) << " policy " << i << ", seed "
+                         << worker.seeds[0];
+                    checkPolicy(worker, topology, row(i, worker.genes.data()), geneCount, game.str(), exactConfig,
+                                loopConfig);
+                }
+            });
+            policies += count;
+        };
+
+        for (PolicyKind kind : { PolicyKind::Random, PolicyKind::Pruned }) {
+            check(kind, 0, options.policies, [&](size_t i, double* scratch) {
+                fillPolicy(kind, streamKey(options.seed ^ POLICY_SEED_SALT, (uint64_t)t * 3 + (uint64_t)kind, i),
+                           scratch, geneCount);
+                return (const double*)scratch;
+            });
+        }
+
+        // the population after each generation, until enough rows were checked
+        TrainingRun run(EVOLVED_POPULATION, topology, loopConfig, pool, OptimizerType::Genetic,
+                        GenePrecision::Double, streamKey(options.seed ^ EVOLVED_SEED_SALT, t, 0) | 1);
+        for (size_t first = 0; first < options.policies; first += EVOLVED_POPULATION) {
+            run.step();
+            const Population& population = run.getPopulation();
+            check(PolicyKind::Evolved, first, std::min(EVOLVED_POPULATION, options.policies - first),
+                  [&](size_t i, double* scratch) { return population.getGeneRow(i - first, scratch); });
+        }
+        std::cout << "Differential test: " << topologyName(topology) << " done" << std::endl;
+    }
+
+    DiffWorker total;
+    total.mismatches += checkRays(options);
+    total.mismatches += checkBatching(options);
+    total.mismatches += checkSparse(options);
+    total.mismatches += checkGenePrecision(options);
+    total.mismatches += checkMorphs(options);
+    total.mismatches += checkTrajectories(options);
+    for (const DiffWorker& worker : workers) {
+        for (int e = 0; e < ENGINE_COUNT; ++e) {
+            total.seconds[e] += worker.seconds[e];
+            total.games[e] += worker.games[e];
+            total.steps[e] += worker.steps[e];
+        }
+        total.mismatches += worker.mismatches;
+        for (const std::string& line : worker.reports) std::cerr << "  " << line << std::endl;
+    }
+
+    std::cout << "Differential test: " << policies << " policies, " << total.mismatches << " differences"
+              << std::endl;
+    double referencePerGame = total.seconds[ENGINE_REFERENCE] / (double)std::max(1LL, total.games[ENGINE_REFERENCE]);
+    for (int e = 0; e < ENGINE_COUNT; ++e) {
+        double perGame = total.seconds[e] / (double)std::max(1LL, total.games[e]);
+        std::cout << "  " << ENGINE_NAMES[e] << ": " << total.games[e] << " games, " << total.steps[e]
+                  << " steps simulated, " << perGame * 1e6 << " us per game";
+        if (e != ENGINE_REFERENCE && perGame > 0.0) std::cout << " (" << referencePerGame / perGame << "x reference)";
+        std::cout << std::endl;
+    }
+    return total.mismatches == 0 ? 0 : 1;
+}
+
+int runExportCheck(const std::string& dir) {
+    const std::vector<std::vector<size_t>> topologies = { {11, 3}, {11, 8, 3}, {11, 16, 8, 3}, {11, 32, 32, 3} };
+    const ActivationType pairs[4][2] = {
+        { ActivationType::RELU, ActivationType::RELU },
+        { ActivationType::TANH, ActivationType::SIGMOID },
+        { ActivationType::SIGMOID, ActivationType::TANH },
+        { ActivationType::IDENTITY, ActivationType::IDENTITY }
+    };
+    const size_t STATES = (size_t)1 << BASIC_INPUT_NODES;
+
+    mkdir(dir.c_str(), 0755);
+    std::ofstream check(dir + "/check.cpp");
+    if (!check) {
+        std::cerr << "Could not write " << dir << "/check.cpp" << std::endl;
+        return 1;
+    }
+    std::stringstream calls;
+    size_t count = 0;
+    for (size_t t = 0; t < topologies.size(); ++t) {
+        for (size_t a = 0; a < 4; ++a) {
+            NetworkActivations activations;
+            activations.hidden = pairs[a][0];
+            activations.output = pairs[a][1];
+            NeuralNetwork brain(topologies[t], activations);
+            std::vector<double> genes(NeuralNetwork::geneCountFor(topologies[t]));
+            fillUniform(streamKey(POLICY_SEED_SALT, t, a), 0, genes.data(), genes.size(), -1.0, 1.0);
+            brain.setGenes(genes);
+
+            std::string name = "policy_" + std::to_string(count++);
+            if (!exportPolicyHeader(brain, dir + "/" + name + ".hpp", name)) {
+                std::cerr << "Could not write " << dir << "/" << name << ".hpp" << std::endl;
+                return 1;
+            }
+            std::ofstream expected(dir + "/" + name + ".expected");
+            double inputs[BASIC_INPUT_NODES];
+            char literal[64];
+            for (size_t state = 0; state < STATES; ++state) {
+                for (size_t i = 0; i < BASIC_INPUT_NODES; ++i) inputs[i] = (state >> i) & 1 ? 1.0 : 0.0;
+                const double* outputs = brain.feedForward(inputs);
+                for (size_t o = 0; o < OUTPUT_NODES; ++o) {
+                    // hex floats, so the expected values are exact
+                    std::snprintf(literal, sizeof(literal), "%a", outputs[o]);
+                    expected << literal << (o + 1 < OUTPUT_NODES ? " " : "\n");
+                }
+            }
+            if (!expected) {
+                std::cerr << "Could not write " << dir << "/" << name << ".expected" << std::endl;
+                return 1;
+            }
+            check << "#include \"" << name << ".hpp\"\n";
+            calls << "    failures += check(dir, \"" << name << "\", " << name << "::forward);\n";
+        }
+    }
+
+    check << "#include <cstdio>\n"
+          << "#include <string>\n\n"
+          << "// Generated by snake --check-export: every exported forward() against the\n"
+          << "// outputs NeuralNetwork::feedForward gave for all binary sensor states.\n"
+          << "static int check(const std::string& dir, const char* name, void (*forward)(const double*, double*)) {\n"
+          << "    std::FILE* file = std::fopen((dir + \"/\" + name + \".expected\").c_str(), \"r\");\n"
+          << "    if (!file) { std::printf(\"%s: no expected outputs\\n\", name); return 1; }\n"
+          << "    int failures = 0;\n"
+          << "    for (unsigned state = 0; state < " << STATES << "; ++state) {\n"
+          << "        double in[" << BASIC_INPUT_NODES << "], out[" << OUTPUT_NODES << "];\n"
+          << "        for (int i = 0; i < " << BASIC_INPUT_NODES << "; ++i) in[i] = (state >> i) & 1 ? 1.0 : 0.0;\n"
+          << "        forward(in, out);\n"
+          << "        for (int o = 0; o < " << OUTPUT_NODES << "; ++o) {\n"
+          << "            double expected;\n"
+          << "            if (std::fscanf(file, \"%la\", &expected) != 1 || expected != out[o]) {\n"
+          << "                if (failures++ < 5) std::printf(\"%s: state %u output %d is %a, feedForward gave %a\\n\",\n"
+          << "                                                name, state, o, out[o], expected);\n"
+          << "            }\n"
+          << "        }\n"
+          << "    }\n"
+          << "    std::fclose(file);\n"
+          << "    return failures;\n"
+          << "}\n\n"
+          << "int main(int argc, char** argv) {\n"
+          << "    std::string dir = argc > 1 ? argv[1] : \".\";\n"
+          << "    int failures = 0;\n"
+          << calls.str()
+          << "    std::printf(\"Export check: " << count << " headers, %d differences\\n\", failures);\n"
+          << "    return failures == 0 ? 0 : 1;\n"
+          << "}\n";
+    if (!check) {
+        std::cerr << "Could not write " << dir << "/check.cpp" << std::endl;
+        return 1;
+    }
+    std::cout << "Export check: " << count << " headers written to " << dir << std::endl;
+    return 0;
+}
@@ -0,0 +1,170 @@
+#include "Evaluator.hpp"
+#include "NeuralNetwork.hpp"
+#include "World.hpp"
+#include "Trace.hpp"
+#include "Zobrist.hpp"
+#include <algorithm>
+
+EvalContext::Episode::Episode(const EvalConfig& config, uint16_t index)
+    : snake(), food(10, 10), world(snake, food, config.width, config.height),
+      epoch(0), steps(0), scoreAtLastFood(0), stepsSinceLastFood(0), stepsSaved(0), ended(false),
+      recording(false), index(index), lastFitness(0.0) {}
+
+GameResult EvalContext::Episode::result(const EvalConfig& config) {
+    int scored_steps = steps;
+    if (config.loopScoring == LoopScoring::CreditRemaining) scored_steps += stepsSaved;
+    double fitness = (double)scored_steps + (double)(world.getScore() * 1000.0);
+    bool truncated = !ended && steps < config.maxSteps && !world.snake_hit_wall() && !snake.hit_itself();
+    return { fitness, steps, world.getScore(), stepsSaved, truncated };
+}
+
+EvalContext::EvalContext(const EvalConfig& config) : config(config) {
+    size_t count = (size_t)std::max(1, config.episodes);
+    for (size_t e = 0; e < count; ++e) {
+        episodes.push_back(std::make_unique<Episode>(config, (uint16_t)e));
+    }
+    running.reserve(count);
+    batchInputs.resize(count * RAY_INPUT_NODES);
+    episodeFitness.resize(count);
+}
+
+void EvalContext::recordTrajectories(TrajectoryWriter* writer, size_t producer) {
+    trajectoryWriter = writer;
+    trajectoryRing = writer ? writer->getRing(producer) : nullptr;
+}
+
+void EvalContext::play(const std::vector<size_t>& topology, const double* genes, size_t geneCount,
+                       const uint64_t* seeds, size_t count, int stepLimit) {
+    TRACE_ZONE("EvalContext::play");
+    if (!brain || brain->getTopology() != topology) {
+        brain = std::make_unique<NeuralNetwork>(topology, config.activations);
+        brain->setSparseDensity(config.sparseDensity);
+    }
+    brain->setGenes(genes, geneCount);
+
+    int step_limit = std::min(stepLimit, config.maxSteps);
+    running.clear();
+    for (size_t e = 0; e < count; ++e) {
+        Episode& episode = *episodes[e];
+        episode.food.seed(seeds[e]);
+        episode.world.reset();
+        episode.steps = 0;
+        episode.scoreAtLastFood = 0;
+        episode.stepsSinceLastFood = 0;
+        episode.stepsSaved = 0;
+        episode.ended = false;
+        episode.recording = trajectoryRing && trajectoryWriter->sampleGame(seeds[e]);
+        episode.lastFitness = 0.0;
+        episode.visited.clear();
+        episode.epoch = episode.world.get_epoch();
+        if (config.detectLoops) episode.visited.insert(episode.world.state_hash());
+        if (step_limit > 0) running.push_back(&episode);
+    }
+
+    const size_t inputs = topology.front();
+    const size_t outputs = topology.back();
+    const uint8_t flags = step_limit < config.maxSteps ? TRAJECTORY_SCREENING : 0;
+    while (!running.empty()) {
+        for (size_t j = 0; j < running.size(); ++j) {
+            running[j]->world.get_game_state(inputs, batchInputs.data() + j * inputs);
+        }
+        const double* decisions = brain->feedForwardBatch(batchInputs.data(), running.size());
+
+        size_t still_running = 0;
+        for (size_t j = 0; j < running.size(); ++j) {
+            Episode& episode = *running[j];
+            const double* row = decisions + j * outputs;
+            int action = (int)(std::max_element(row, row + outputs) - row);
+            episode.world.apply_action(action);
+            episode.world.update();
+            episode.steps++;
+            if (episode.recording) {
+                double fitness = (double)episode.steps + (double)(episode.world.getScore() * 1000.0);
+                TrajectoryStep step = { tagGeneration, tagIndividual, episode.index,
+                                        flags, (uint8_t)action, (uint32_t)(episode.steps - 1),
+                                        (float)(fitness - episode.lastFitness) };
+                episode.lastFitness = fitness;
+                trajectoryRing->push(step, batchInputs.data() + j * inputs, row);
+            }
+            episode.stepsSinceLastFood++;
+            if (episode.world.getScore() > episode.scoreAtLastFood) {
+                episode.scoreAtLastFood = episode.world.getScore();
+                episode.stepsSinceLastFood = 0;
+            }
+
+            bool done = false;
+            if (episode.stepsSinceLastFood > STARVATION_STEPS) {
+                episode.ended = true;
+                done = true;
+            } else if (config.detectLoops) {
+                if (episode.world.get_epoch() != episode.epoch) {
+                    episode.epoch = episode.world.get_epoch();
+                    episode.visited.clear();
+                }
+                if (episode.visited.insert(episode.world.state_hash())) {
+                    // no food and no death can happen inside the loop, so the game
+                    // would only end by starvation or the step budget
+                    episode.stepsSaved = std::min(STARVATION_STEPS + 1 - episode.stepsSinceLastFood,
+                                                  config.maxSteps - episode.steps);
+                    episode.ended = true;
+                    done = true;
+                }
+            }
+            if (!done && (episode.world.snake_hit_wall() || episode.snake.hit_itself() || episode.steps >= step_limit)) {
+                done = true;
+            }
+            if (!done) running[still_running++] = &episode;
+        }
+        running.resize(still_running);
+    }
+}
+
+GameResult EvalContext::evaluate(const std::vector<size_t>& topology, const double* genes, size_t geneCount, uint64_t seed,
+                                 int stepLimit) {
+    TRACE_ZONE("EvalContext::evaluate");
+    play(topology, genes, geneCount, &seed, 1, stepLimit);
+    return episodes[0]->result(config);
+}
+
+GameResult EvalContext::evaluateEpisodes(const std::vector<size_t>& topology, const double* genes, size_t geneCount,
+                                         const uint64_t* seeds, int stepLimit) {
+    TRACE_ZONE("EvalContext::evaluateEpisodes");
+    const size_t count = episodes.size();
+    play(topology, genes, geneCount, seeds, count, stepLimit);
+
+    GameResult total = { 0.0, 0, 0, 0, false };
+    for (size_t e = 0; e < count; ++e) {
+        GameResult game = episodes[e]->result(config);
+        episodeFitness[e] = game.fitness;
+        total.steps += game.steps;
+        total.stepsSaved += game.stepsSaved;
+        total.score = std::max(total.score, game.score);
+        total.truncated = total.truncated || game.truncated;
+    }
+
+    switch (config.aggregate) {
+        case EpisodeAggregate::Mean: {
+            double sum = 0.0;
+            for (size_t e = 0; e < count; ++e) sum += episodeFitness[e];
+            total.fitness = sum / (double)count;
+            break;
+        }
+        case EpisodeAggregate::Min:
+            total.fitness = *std::min_element(episodeFitness.begin(), episodeFitness.begin() + count);
+            break;
+        case EpisodeAggregate::Quantile: {
+            double q = std::min(1.0, std::max(0.0, config.aggregateQuantile));
+            size_t rank = (size_t)(q * (double)(count - 1) + 0.5);
+            std::nth_element(episodeFitness.begin(), episodeFitness.begin() + rank, episodeFitness.begin() + count);
+            total.fitness = episodeFitness[rank];
+            break;
+        }
+    }
+    return total;
+}
+
+GameResult evaluate_brain_fitness(const std::vector<size_t>& topology, const std::vector<double>& genes, const EvalConfig& config,
+                                  uint64_t seed) {
+    EvalContext context(config);
+    return context.evaluate(topology, genes.data(), genes.size(), seed);
+}
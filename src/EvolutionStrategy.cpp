@@ -0,0 +1,125 @@
+#include "EvolutionStrategy.hpp"
+#include "Random.hpp"
+#include <algorithm>
+#include <cmath>
+
+EvolutionStrategy::EvolutionStrategy()
+    : popSize(0), geneCount(0), seed(0), sigma(0.1), learningRate(0.03), adamStep(0) {}
+
+void EvolutionStrategy::setMutation(double, double strength) {
+    sigma = strength;
+}
+
+void EvolutionStrategy::reset(GeneStore& genes, size_t popSize, size_t geneCount, uint64_t seed, ThreadPool& pool) {
+    this->popSize = popSize;
+    // generation 0 of the plain seed already produced the initial genes
+    this->seed = mixBits(seed ^ 0x5EED5EED5EED5EEDull);
+    // start from the first random individual
+    restart(genes, geneCount, 0, pool);
+}
+
+void EvolutionStrategy::morph(GeneStore& genes, size_t geneCount, size_t generation, ThreadPool& pool) {
+    // the Adam moments belong to the old genes, so they start over
+    restart(genes, geneCount, generation, pool);
+}
+
+void EvolutionStrategy::restart(GeneStore& genes, size_t geneCount, size_t generation, ThreadPool& pool) {
+    this->geneCount = geneCount;
+    scratch.assign(pool.size() * geneCount, 0.0);
+    const double* first = genes.read(0, scratch.data());
+    mean.assign(first, first + geneCount);
+    adamM.assign(geneCount, 0.0);
+    adamV.assign(geneCount, 0.0);
+    adamStep = 0;
+
+    // evolve() of this generation regenerates the same noise
+    writeCandidates(genes, generation, pool);
+}
+
+void EvolutionStrategy::writeCandidates(GeneStore& rows, size_t generation, ThreadPool& pool) {
+    rows.commit(0, mean.data());
+
+    // rows 2k+1 and 2k+2 share the noise of pair k with opposite signs; with
+    // an even population the last row is left without a partner
+    pool.parallelFor(popSize - 1, 0, [&](size_t begin, size_t end, size_t worker) {
+        for (size_t r = begin + 1; r < end + 1; ++r) {
+            double* row = rows.writeBuffer(r, scratch.data() + worker * geneCount);
+            fillGaussian(streamKey(seed, generation, (r - 1) / 2), 0, row, geneCount, sigma);
+            double sign = ((r - 1) % 2 == 0) ? 1.0 : -1.0;
+            for (size_t j = 0; j < geneCount; ++j) {
+                row[j] = mean[j] + sign * row[j];
+            }
+            rows.commit(r, row);
+        }
+    });
+}
+
+void EvolutionStrategy::shapeFitness(const double* fitness) {
+    // centered ranks in [-0.5, 0.5] over rows 1..popSize-1; tied rows share
+    // their average rank, which matters because many snakes starve alike
+    size_t count = popSize - 1;
+    order.resize(count);
+    for (size_t i = 0; i < count; ++i) order[i] = i + 1;
+    std::sort(order.begin(), order.end(), [fitness](size_t a, size_t b) {
+        return fitness[a] < fitness[b] || (fitness[a] == fitness[b] && a < b);
+    });
+
+    shaped.assign(popSize, 0.0);
+    double denominator = count > 1 ? (double)(count - 1) : 1.0;
+    for (size_t first = 0; first < count;) {
+        size_t last = first;
+        while (last + 1 < count && fitness[order[last + 1]] == fitness[order[first]]) last++;
+        double rank = 0.5 * (double)(first + last) / denominator - 0.5;
+        for (size_t i = first; i <= last; ++i) shaped[order[i]] = rank;
+        first = last + 1;
+    }
+}
+
+void EvolutionStrategy::evolve(const GeneStore&, const double* fitness, const FitnessStats&,
+                               size_t generation, GeneStore& next, ThreadPool& pool) {
+    if (popSize < 2) {
+        writeCandidates(next, generation + 1, pool);
+        return;
+    }
+    shapeFitness(fitness);
+
+    const double BETA1 = 0.9;
+    const double BETA2 = 0.999;
+    const double EPSILON = 1e-8;
+    const double WEIGHT_DECAY = 0.005;
+    size_t pairs = popSize / 2;
+    double norm = 1.0 / ((double)(popSize - 1) * sigma);
+    adamStep++;
+    double correction1 = 1.0 - std::pow(BETA1, (double)adamStep);
+    double correction2 = 1.0 - std::pow(BETA2, (double)adamStep);
+
+    // each worker owns a slice of genes and replays every pair's noise for it
+    pool.parallelFor(geneCount, 0, [&](size_t begin, size_t end, size_t) {
+        double eps[RANDOM_BLOCK];
+        double gradient[RANDOM_BLOCK];
+        for (size_t block = begin; block < end; block += RANDOM_BLOCK) {
+            size_t lanes = std::min(RANDOM_BLOCK, end - block);
+            std::fill(gradient, gradient + lanes, 0.0);
+
+            for (size_t k = 0; k < pairs; ++k) {
+                size_t plus = 2 * k + 1;
+                double weight = shaped[plus] - (plus + 1 < popSize ? shaped[plus + 1] : 0.0);
+                if (weight == 0.0) continue;
+                fillGaussian(streamKey(seed, generation, k), block, eps, lanes, 1.0);
+                for (size_t j = 0; j < lanes; ++j) {
+                    gradient[j] += weight * eps[j];
+                }
+            }
+
+            for (size_t j = 0; j < lanes; ++j) {
+                size_t g = block + j;
+                double grad = gradient[j] * norm - WEIGHT_DECAY * mean[g];
+                adamM[g] = BETA1 * adamM[g] + (1.0 - BETA1) * grad;
+                adamV[g] = BETA2 * adamV[g] + (1.0 - BETA2) * grad * grad;
+                mean[g] += learningRate * (adamM[g] / correction1) / (std::sqrt(adamV[g] / correction2) + EPSILON);
+            }
+        }
+    });
+
+    writeCandidates(next, generation + 1, pool);
+}
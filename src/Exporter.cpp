@@ -0,0 +1,135 @@
+#include "Exporter.hpp"
+#include "Activation.hpp"
+#include <fstream>
+#include <cstdio>
+
+// hex float literals round-trip every double exactly
+static std::string literal(double value) {
+    char buffer[64];
+    std::snprintf(buffer, sizeof(buffer), "%a", value);
+    return buffer;
+}
+
+// Each body mirrors the matching function in Activation.hpp operation for
+// operation, with the coefficients spelled out exactly.
+static std::string activationBody(ActivationType type) {
+    switch (type) {
+        case ActivationType::SIGMOID:
+            return "return 0.5 + 0.5 * activate_tanh(0.5 * x);";
+        case ActivationType::RELU:
+            return "return (0.0 < x) ? x : 0.0;";
+        case ActivationType::TANH: {
+            std::string body = "const double c0 = x < -" + literal(TANH_CLAMP) + " ? -" + literal(TANH_CLAMP) + " : x;\n"
+                             + "    const double c = " + literal(TANH_CLAMP) + " < c0 ? " + literal(TANH_CLAMP) + " : c0;\n"
+                             + "    const double s = c * c;\n"
+                             + "    double p = " + literal(TANH_NUMERATOR[6]) + ";\n";
+            for (int i = 5; i >= 0; --i) body += "    p = p * s + " + literal(TANH_NUMERATOR[i]) + ";\n";
+            body += "    double q = " + literal(TANH_DENOMINATOR[3]) + ";\n";
+            for (int i = 2; i >= 0; --i) body += "    q = q * s + " + literal(TANH_DENOMINATOR[i]) + ";\n";
+            return body + "    return c * p / q;";
+        }
+        case ActivationType::IDENTITY:
+            return "return x;";
+    }
+    return "";
+}
+
+bool exportPolicyHeader(const NeuralNetwork& brain, const std::string& path, const std::string& name) {
+    std::ofstream out(path);
+    if (!out) return false;
+
+    const std::vector<size_t>& topology = brain.getTopology();
+    const std::vector<double> genes = brain.getGenes();
+    const size_t inputs = topology.front();
+    const size_t outputs = topology.back();
+    const std::vector<ActivationType>& activations = brain.getActivations();
+
+    out << "// Generated by snake: exported champion policy.\n"
+        << "// Topology:";
+    for (size_t n : topology) out << " " << n;
+    out << ", activations:";
+    for (ActivationType activation : activations) out << " " << activationName(activation);
+    out << ".\n"
+        << "// Self-contained and allocation free. Compile without floating-point\n"
+        << "// contraction (-ffp-contract=off, no -ffast-math) to reproduce\n"
+        << "// NeuralNetwork::feedForward bit for bit.\n"
+        << "#pragma once\n\n"
+        << "#include <cstddef>\n"
+        << "\nnamespace " << name << " {\n\n"
+        << "constexpr std::size_t INPUTS = " << inputs << ";\n"
+        << "constexpr std::size_t OUTPUTS = " << outputs << ";\n"
+        << "constexpr std::size_t LAYERS = " << topology.size() << ";\n"
+        << "constexpr std::size_t TOPOLOGY[LAYERS] = {";
+    for (size_t i = 0; i < topology.size(); ++i) out << (i ? ", " : " ") << topology[i];
+    out << " };\n\n";
+
+    // weights and biases in the same order as the gene vector
+    size_t geneIndex = 0;
+    for (size_t l = 1; l < topology.size(); ++l) {
+        size_t neurons = topology[l];
+        size_t prev = topology[l - 1];
+        out << "constexpr double B" << l << "[" << neurons << "] = {";
+        for (size_t n = 0; n < neurons; ++n) {
+            out << (n ? ", " : " ") << literal(genes[geneIndex++]);
+        }
+        out << " };\n";
+        out << "constexpr double W" << l << "[" << neurons << "][" << prev << "] = {\n";
+        for (size_t n = 0; n < neurons; ++n) {
+            out << "    {";
+            for (size_t p = 0; p < prev; ++p) {
+                out << (p ? ", " : " ") << literal(genes[geneIndex++]);
+            }
+            out << " },\n";
+        }
+        out << "};\n\n";
+    }
+
+    // sigmoid is built on tanh, so tanh comes first whenever either is used
+    auto uses = [&activations](ActivationType type) {
+        for (ActivationType activation : activations) {
+            if (activation == type) return true;
+        }
+        return false;
+    };
+    for (ActivationType type : { ActivationType::TANH, ActivationType::SIGMOID,
+                                 ActivationType::RELU, ActivationType::IDENTITY }) {
+        bool needed = uses(type) || (type == ActivationType::TANH && uses(ActivationType::SIGMOID));
+        if (!needed) continue;
+        out << "inline double activate_" << activationName(type) << "(double x) {\n    "
+            << activationBody(type) << "\n}\n\n";
+    }
+
+    out << "/** Writes the OUTPUTS raw network outputs for one input vector. */\n"
+        << "inline void forward(const double* in, double* out) {\n";
+    for (size_t l = 1; l < topology.size(); ++l) {
+        size_t neurons = topology[l];
+        size_t prev = topology[l - 1];
+        bool last = l + 1 == topology.size();
+        std::string source = l == 1 ? "in[" : "h" + std::to_string(l - 1) + "_";
+        std::string close = l == 1 ? "]" : "";
+        for (size_t n = 0; n < neurons; ++n) {
+            // left-associative sum: bias first, then inputs in order
+            out << "    " << (last ? "out[" + std::to_string(n) + "] = " : "const double h" + std::to_string(l) + "_" + std::to_string(n) + " = ")
+                << "activate_" << activationName(activations[l - 1]) << "(B" << l << "[" << n << "]";
+            for (size_t p = 0; p < prev; ++p) {
+                out << " + " << source << p << close << " * W" << l << "[" << n << "][" << p << "]";
+            }
+            out << ");\n";
+        }
+    }
+    out << "}\n\n";
+
+    out << "/** Returns the index of the first maximal output: 0 left, 1 straight, 2 right. */\n"
+        << "inline int act(const double* in) {\n"
+        << "    double out[OUTPUTS];\n"
+        << "    forward(in, out);\n"
+        << "    int best = 0;\n"
+        << "    for (int i = 1; i < (int)OUTPUTS; ++i) {\n"
+        << "        if (out[best] < out[i]) best = i;\n"
+        << "    }\n"
+        << "    return best;\n"
+        << "}\n\n"
+        << "}\n";
+
+    return (bool)out;
+}
@@ -3,11 +3,25 @@
 
 #include "Food.hpp"
 #include "Point.hpp"
+#include "Random.hpp"
+#include <atomic>
+#include <random>
 
 const int CELL_SIZE = 20;
 
+// unseeded foods get distinct streams derived from one per-process seed
+static const uint64_t process_seed = ((uint64_t)std::random_device{}() << 32) | std::random_device{}();
+static std::atomic<uint64_t> food_count(0);
+
 Food::Food(int x, int y) {
     this->position = Point{x, y};
+    this->rng_key = streamKey(process_seed, 0, food_count++);
+    this->rng_counter = 0;
+}
+
+void Food::seed(uint64_t seed) {
+    this->rng_key = mixBits(seed);
+    this->rng_counter = 0;
 }
 
 void Food::draw(SDL_Renderer *renderer) {
@@ -21,6 +35,6 @@ void Food::draw(SDL_Renderer *renderer) {
 }
 
 void Food::move_randomly(int max_x, int max_y) {
-    this->position.x = rand() % max_x;
-    this->position.y = rand() % max_y;
+    this->position.x = (int)randomIndex(counterRandom(rng_key, rng_counter++), max_x);
+    this->position.y = (int)randomIndex(counterRandom(rng_key, rng_counter++), max_y);
 }
@@ -0,0 +1,166 @@
+#include "GeneStore.hpp"
+#include "Kernels.hpp"
+#include <algorithm>
+#include <cstring>
+
+const char* genePrecisionName(GenePrecision precision) {
+    switch (precision) {
+        case GenePrecision::Double: return "double";
+        case GenePrecision::Float16: return "fp16";
+        case GenePrecision::BFloat16: return "bf16";
+    }
+    return "?";
+}
+
+bool parseGenePrecision(const std::string& name, GenePrecision& precision) {
+    for (GenePrecision candidate : { GenePrecision::Double, GenePrecision::Float16, GenePrecision::BFloat16 }) {
+        if (name == genePrecisionName(candidate)) {
+            precision = candidate;
+            return true;
+        }
+    }
+    return false;
+}
+
+// Conversions between double and a 16-bit float with EXPONENT exponent bits
+// and 15 - EXPONENT mantissa bits (5 for half, 8 for bfloat16), straight from
+// the double's bits so there is a single rounding.
+template <int EXPONENT>
+static inline uint16_t narrowValue(double value) {
+    const int MANTISSA = 15 - EXPONENT;
+    const int BIAS = (1 << (EXPONENT - 1)) - 1;
+    const uint16_t INFINITE = (uint16_t)(((1 << EXPONENT) - 1) << MANTISSA);
+    const uint16_t LARGEST = (uint16_t)(INFINITE - 1);
+
+    uint64_t bits;
+    std::memcpy(&bits, &value, sizeof(bits));
+    uint16_t sign = (uint16_t)((bits >> 48) & 0x8000);
+    int exponent = (int)((bits >> 52) & 0x7FF);
+    uint64_t mantissa = bits & ((1ull << 52) - 1);
+
+    if (exponent == 0x7FF) {
+        // NaN stays NaN, infinities saturate like any other overflow
+        return mantissa ? (uint16_t)(sign | INFINITE | (1 << (MANTISSA - 1))) : (uint16_t)(sign | LARGEST);
+    }
+    int target = exponent - 1023 + BIAS;
+    int shift = 52 - MANTISSA;
+    uint64_t significand;
+    uint64_t result;
+    if (target > 0) {
+        // normal: exponent and mantissa side by side, so a rounding carry
+        // moves into the exponent on its own
+        significand = mantissa;
+        result = ((uint64_t)target << MANTISSA) | (mantissa >> shift);
+    } else {
+        // subnormal or zero: shift the implicit bit in as well
+        shift += 1 - target;
+        if (shift > 63) return sign;
+        significand = mantissa | (1ull << 52);
+        result = significand >> shift;
+    }
+    uint64_t remainder = significand & ((1ull << shift) - 1);
+    uint64_t half = 1ull << (shift - 1);
+    if (remainder > half || (remainder == half && (result & 1))) ++result;
+    if (result >= INFINITE) return (uint16_t)(sign | LARGEST);
+    return (uint16_t)(sign | result);
+}
+
+template <int EXPONENT>
+static inline double widenValue(uint16_t value) {
+    const int MANTISSA = 15 - EXPONENT;
+    const int BIAS = (1 << (EXPONENT - 1)) - 1;
+    const int MAX_EXPONENT = (1 << EXPONENT) - 1;
+
+    uint64_t sign = (uint64_t)(value & 0x8000) << 48;
+    int exponent = (value >> MANTISSA) & MAX_EXPONENT;
+    uint64_t mantissa = value & ((1u << MANTISSA) - 1);
+
+    uint64_t bits;
+    if (exponent == MAX_EXPONENT) {
+        bits = sign | (0x7FFull << 52) | (mantissa << (52 - MANTISSA));
+    } else if (exponent == 0) {
+        if (mantissa == 0) {
+            bits = sign;
+        } else {
+            // normalize the subnormal
+            int shift = 0;
+            while (!(mantissa & (1u << MANTISSA))) {
+                mantissa <<= 1;
+                ++shift;
+            }
+            mantissa &= (1u << MANTISSA) - 1;
+            bits = sign | ((uint64_t)(1 - BIAS - shift + 1023) << 52) | (mantissa << (52 - MANTISSA));
+        }
+    } else {
+        bits = sign | ((uint64_t)(exponent - BIAS + 1023) << 52) | (mantissa << (52 - MANTISSA));
+    }
+    double result;
+    std::memcpy(&result, &bits, sizeof(result));
+    return result;
+}
+
+SNAKE_DISPATCH
+static void narrowRow(GenePrecision precision, const double* values, uint16_t* row, size_t count) {
+    if (precision == GenePrecision::Float16) {
+        for (size_t i = 0; i < count; ++i) row[i] = narrowValue<5>(values[i]);
+    } else {
+        for (size_t i = 0; i < count; ++i) row[i] = narrowValue<8>(values[i]);
+    }
+}
+
+SNAKE_DISPATCH
+static void widenRow(GenePrecision precision, const uint16_t* row, double* values, size_t count) {
+    if (precision == GenePrecision::Float16) {
+        for (size_t i = 0; i < count; ++i) values[i] = widenValue<5>(row[i]);
+    } else {
+        for (size_t i = 0; i < count; ++i) values[i] = widenValue<8>(row[i]);
+    }
+}
+
+GeneStore::GeneStore() : rows(0), geneCount(0), precision(GenePrecision::Double) {}
+
+void GeneStore::allocate(size_t rows, size_t geneCount, GenePrecision precision) {
+    this->rows = rows;
+    this->geneCount = geneCount;
+    this->precision = precision;
+    // fresh, untouched blocks; the old ones are released rather than reused
+    if (precision == GenePrecision::Double) {
+        std::vector<double, FirstTouchAllocator<double>>(rows * geneCount).swap(wide);
+        std::vector<uint16_t, FirstTouchAllocator<uint16_t>>().swap(narrow);
+    } else {
+        std::vector<uint16_t, FirstTouchAllocator<uint16_t>>(rows * geneCount).swap(narrow);
+        std::vector<double, FirstTouchAllocator<double>>().swap(wide);
+    }
+}
+
+void GeneStore::swap(GeneStore& other) {
+    std::swap(rows, other.rows);
+    std::swap(geneCount, other.geneCount);
+    std::swap(precision, other.precision);
+    wide.swap(other.wide);
+    narrow.swap(other.narrow);
+}
+
+size_t GeneStore::getRowBytes() const {
+    return geneCount * (precision == GenePrecision::Double ? sizeof(double) : sizeof(uint16_t));
+}
+
+const double* GeneStore::read(size_t row, double* scratch) const {
+    if (precision == GenePrecision::Double) return wide.data() + row * geneCount;
+    widenRow(precision, narrow.data() + row * geneCount, scratch, geneCount);
+    return scratch;
+}
+
+double* GeneStore::writeBuffer(size_t row, double* scratch) {
+    if (precision == GenePrecision::Double) return wide.data() + row * geneCount;
+    return scratch;
+}
+
+void GeneStore::commit(size_t row, const double* values) {
+    if (precision == GenePrecision::Double) {
+        double* target = wide.data() + row * geneCount;
+        if (values != target) std::copy(values, values + geneCount, target);
+        return;
+    }
+    narrowRow(precision, values, narrow.data() + row * geneCount, geneCount);
+}
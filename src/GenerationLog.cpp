@@ -0,0 +1,219 @@
+#include "GenerationLog.hpp"
+#include "Random.hpp"
+#include <chrono>
+#include <cstring>
+#include <iomanip>
+#include <iostream>
+#include <thread>
+#include <algorithm>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+static const char LOG_MAGIC[8] = { 'S', 'N', 'A', 'K', 'E', 'L', 'O', 'G' };
+static const uint32_t LOG_VERSION = 1;
+
+GenerationLogWriter::GenerationLogWriter()
+    : fd(-1), header(nullptr), chunk(nullptr), chunkStart(0), count(0) {}
+
+GenerationLogWriter::~GenerationLogWriter() {
+    close();
+}
+
+bool GenerationLogWriter::open(const std::string& path, const std::vector<size_t>& topology) {
+    close();
+    fd = ::open(path.c_str(), O_RDWR | O_CREAT | O_TRUNC, 0644);
+    if (fd < 0) return false;
+
+    if (ftruncate(fd, sizeof(GenerationLogHeader)) != 0) {
+        close();
+        return false;
+    }
+    void* mapped = mmap(nullptr, sizeof(GenerationLogHeader), PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    if (mapped == MAP_FAILED) {
+        close();
+        return false;
+    }
+    header = static_cast<GenerationLogHeader*>(mapped);
+    std::memcpy(header->magic, LOG_MAGIC, sizeof(LOG_MAGIC));
+    header->version = LOG_VERSION;
+    header->recordSize = sizeof(GenerationRecord);
+    header->count = 0;
+    header->finished = 0;
+    header->layers = (uint32_t)std::min<size_t>(topology.size(), 16);
+    for (uint32_t i = 0; i < header->layers; ++i) {
+        header->topology[i] = (uint32_t)topology[i];
+    }
+
+    count = 0;
+    if (!mapChunk(0)) {
+        close();
+        return false;
+    }
+    return true;
+}
+
+bool GenerationLogWriter::mapChunk(uint64_t first) {
+    const size_t chunkBytes = CHUNK_RECORDS * sizeof(GenerationRecord);
+    if (chunk) {
+        msync(chunk, chunkBytes, MS_ASYNC);
+        munmap(chunk, chunkBytes);
+        chunk = nullptr;
+    }
+
+    // grow the file one chunk at a time; the tail stays sparse until written
+    off_t offset = sizeof(GenerationLogHeader) + first * sizeof(GenerationRecord);
+    if (ftruncate(fd, offset + chunkBytes) != 0) return false;
+    void* mapped = mmap(nullptr, chunkBytes, PROT_READ | PROT_WRITE, MAP_SHARED, fd, offset);
+    if (mapped == MAP_FAILED) return false;
+
+    chunk = static_cast<GenerationRecord*>(mapped);
+    chunkStart = first;
+    return true;
+}
+
+void GenerationLogWriter::append(const GenerationRecord& record) {
+    if (!isOpen()) return;
+    if (count - chunkStart == CHUNK_RECORDS && !mapChunk(count)) {
+        close();
+        return;
+    }
+
+    chunk[count - chunkStart] = record;
+    count++;
+    // readers only look at records below the published count
+    __atomic_store_n(&header->count, count, __ATOMIC_RELEASE);
+
+    if (count % FLUSH_EVERY == 0) flush();
+}
+
+void GenerationLogWriter::flush() {
+    if (!isOpen()) return;
+    if (chunk) msync(chunk, CHUNK_RECORDS * sizeof(GenerationRecord), MS_ASYNC);
+    msync(header, sizeof(GenerationLogHeader), MS_ASYNC);
+}
+
+void GenerationLogWriter::close() {
+    if (chunk) {
+        msync(chunk, CHUNK_RECORDS * sizeof(GenerationRecord), MS_SYNC);
+        munmap(chunk, CHUNK_RECORDS * sizeof(GenerationRecord));
+        chunk = nullptr;
+    }
+    if (header) {
+        __atomic_store_n(&header->finished, 1u, __ATOMIC_RELEASE);
+        msync(header, sizeof(GenerationLogHeader), MS_SYNC);
+        munmap(header, sizeof(GenerationLogHeader));
+        header = nullptr;
+    }
+    if (fd >= 0) {
+        // drop the unused part of the last chunk
+        if (ftruncate(fd, sizeof(GenerationLogHeader) + count * sizeof(GenerationRecord)) != 0) {
+            // the log is still valid, just longer than it needs to be
+        }
+        ::close(fd);
+        fd = -1;
+    }
+}
+
+GenerationLogReader::GenerationLogReader()
+    : fd(-1), map(nullptr), mappedBytes(0), records(nullptr), count(0) {}
+
+GenerationLogReader::~GenerationLogReader() {
+    close();
+}
+
+bool GenerationLogReader::open(const std::string& path) {
+    close();
+    fd = ::open(path.c_str(), O_RDONLY);
+    if (fd < 0) return false;
+    refresh();
+    if (!map) {
+        close();
+        return false;
+    }
+    return true;
+}
+
+void GenerationLogReader::close() {
+    if (map) munmap(const_cast<char*>(map), mappedBytes);
+    if (fd >= 0) ::close(fd);
+    fd = -1;
+    map = nullptr;
+    mappedBytes = 0;
+    records = nullptr;
+    count = 0;
+}
+
+size_t GenerationLogReader::refresh() {
+    if (fd < 0) return 0;
+
+    struct stat info;
+    if (fstat(fd, &info) != 0) return count;
+    size_t fileBytes = (size_t)info.st_size;
+
+    if (fileBytes > mappedBytes && fileBytes >= sizeof(GenerationLogHeader)) {
+        void* mapped = mmap(nullptr, fileBytes, PROT_READ, MAP_SHARED, fd, 0);
+        if (mapped == MAP_FAILED) return count;
+        const GenerationLogHeader* header = static_cast<const GenerationLogHeader*>(mapped);
+        if (std::memcmp(header->magic, LOG_MAGIC, sizeof(LOG_MAGIC)) != 0 ||
+            header->recordSize != sizeof(GenerationRecord)) {
+            munmap(mapped, fileBytes);
+            return count;
+        }
+        if (map) munmap(const_cast<char*>(map), mappedBytes);
+        map = static_cast<const char*>(mapped);
+        mappedBytes = fileBytes;
+        records = reinterpret_cast<const GenerationRecord*>(map + sizeof(GenerationLogHeader));
+    }
+    if (!map) return 0;
+
+    const GenerationLogHeader* header = reinterpret_cast<const GenerationLogHeader*>(map);
+    size_t published = (size_t)__atomic_load_n(&header->count, __ATOMIC_ACQUIRE);
+    size_t mappedRecords = (mappedBytes - sizeof(GenerationLogHeader)) / sizeof(GenerationRecord);
+    count = std::min(published, mappedRecords);
+    return count;
+}
+
+bool GenerationLogReader::isFinished() const {
+    if (!map) return false;
+    const GenerationLogHeader* header = reinterpret_cast<const GenerationLogHeader*>(map);
+    return __atomic_load_n(&header->finished, __ATOMIC_ACQUIRE) != 0;
+}
+
+uint64_t hashGenes(const double* genes, size_t count) {
+    uint64_t hash = 0x243F6A8885A308D3ull ^ count;
+    for (size_t i = 0; i < count; ++i) {
+        uint64_t bits;
+        std::memcpy(&bits, &genes[i], sizeof(bits));
+        hash = mixBits(hash ^ bits);
+    }
+    return hash;
+}
+
+int tailGenerationLog(const std::string& path) {
+    GenerationLogReader reader;
+    if (!reader.open(path)) {
+        std::cerr << "Could not open generation log " << path << std::endl;
+        return 1;
+    }
+
+    std::cout << "gen,best,average,median,p10,p90,worst,steps,steps_saved,promoted,eval_s,evolve_s,champion" << std::endl;
+    size_t printed = 0;
+    while (true) {
+        // read the flag first: once it is set, the final count is already published
+        bool finished = reader.isFinished();
+        size_t available = reader.refresh();
+        for (; printed < available; ++printed) {
+            const GenerationRecord& r = reader[printed];
+            std::cout << r.generation << ',' << r.best << ',' << r.average << ',' << r.median << ','
+                      << r.p10 << ',' << r.p90 << ',' << r.worst << ',' << r.steps << ',' << r.stepsSaved << ',' << r.promoted << ','
+                      << r.evalSeconds << ',' << r.evolveSeconds << ','
+                      << std::hex << std::setw(16) << std::setfill('0') << r.championHash
+                      << std::dec << std::setfill(' ') << std::endl;
+        }
+        if (finished) break;
+        std::this_thread::sleep_for(std::chrono::milliseconds(200));
+    }
+    return 0;
+}
@@ -0,0 +1,101 @@
+#include "GeneticOptimizer.hpp"
+#include "Random.hpp"
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
+GeneticOptimizer::GeneticOptimizer()
+    : popSize(0), geneCount(0), seed(0), mutationRate(0.05), mutationStrength(0.2), pruneThreshold(0.0) {}
+
+void GeneticOptimizer::reset(GeneStore&, size_t popSize, size_t geneCount, uint64_t seed, ThreadPool& pool) {
+    this->popSize = popSize;
+    this->geneCount = geneCount;
+    this->seed = seed;
+    scratch.assign(pool.size() * 3 * geneCount, 0.0);
+}
+
+void GeneticOptimizer::morph(GeneStore&, size_t geneCount, size_t, ThreadPool& pool) {
+    // the morphed rows are the parents of the next generation as they are
+    this->geneCount = geneCount;
+    scratch.assign(pool.size() * 3 * geneCount, 0.0);
+}
+
+void GeneticOptimizer::setMutation(double rate, double strength) {
+    mutationRate = rate;
+    mutationStrength = strength;
+}
+
+void GeneticOptimizer::evolve(const GeneStore& genes, const double* fitness, const FitnessStats& stats,
+                              size_t generation, GeneStore& next, ThreadPool& pool) {
+    // the pool is idle here, so worker 0's scratch is free
+    next.commit(0, genes.read(stats.bestIndex, scratch.data()));
+
+    // every child has its own RNG stream, so workers write disjoint rows and
+    // the result does not depend on how the range is split between them
+    pool.parallelFor(popSize - 1, 0, [&](size_t begin, size_t end, size_t worker) {
+        double* rows = scratch.data() + worker * 3 * geneCount;
+        for (size_t i = begin + 1; i < end + 1; ++i) {
+            uint64_t key = streamKey(seed, generation + 1, i);
+            // tournament draws sit above the crossover counters
+            uint64_t counter = 1ull << 62;
+            const double* parentA = genes.read(selectParent(fitness, key, counter), rows);
+            const double* parentB = genes.read(selectParent(fitness, key, counter), rows + geneCount);
+            double* child = next.writeBuffer(i, rows + 2 * geneCount);
+            crossover(parentA, parentB, child, key);
+            mutate(child, key);
+            next.commit(i, child);
+        }
+    });
+}
+
+size_t GeneticOptimizer::selectParent(const double* fitness, uint64_t key, uint64_t& counter) const {
+    const int TOURNAMENT_SIZE = 5;
+    size_t winner = 0;
+    double best_fit = -1.0;
+
+    for (int i = 0; i < TOURNAMENT_SIZE; ++i) {
+        size_t index = randomIndex(counterRandom(key, counter++), popSize);
+        if (fitness[index] > best_fit) {
+            best_fit = fitness[index];
+            winner = index;
+        }
+    }
+    return winner;
+}
+
+void GeneticOptimizer::crossover(const double* parentA, const double* parentB, double* child, uint64_t key) const {
+    // uniform crossover as a bitwise select: child = (A & mask) | (B & ~mask)
+    uint64_t masks[RANDOM_BLOCK];
+
+    for (size_t begin = 0; begin < geneCount; begin += RANDOM_BLOCK) {
+        size_t lanes = std::min(RANDOM_BLOCK, geneCount - begin);
+        fillCoinMasks(key, begin / RANDOM_BLOCK, masks, lanes);
+
+        uint64_t bitsA[RANDOM_BLOCK], bitsB[RANDOM_BLOCK];
+        std::memcpy(bitsA, parentA + begin, lanes * sizeof(double));
+        std::memcpy(bitsB, parentB + begin, lanes * sizeof(double));
+        for (size_t j = 0; j < lanes; ++j) {
+            bitsA[j] = (bitsA[j] & masks[j]) | (bitsB[j] & ~masks[j]);
+        }
+        std::memcpy(child + begin, bitsA, lanes * sizeof(double));
+    }
+}
+
+void GeneticOptimizer::mutate(double* child, uint64_t key) const {
+    // mutation draws from the upper half of the stream, crossover from the lower
+    const uint64_t MUTATION_COUNTER = 1ull << 63;
+    double noise[RANDOM_BLOCK];
+
+    for (size_t begin = 0; begin < geneCount; begin += RANDOM_BLOCK) {
+        size_t lanes = std::min(RANDOM_BLOCK, geneCount - begin);
+        fillMutationNoise(key, MUTATION_COUNTER + begin, noise, lanes, mutationRate, mutationStrength);
+
+        // genes start inside [-1, 1], so clamping every lane only affects
+        // mutated ones; with a zero threshold the pruning never fires
+        double* row = child + begin;
+        for (size_t j = 0; j < lanes; ++j) {
+            double gene = std::min(1.0, std::max(-1.0, row[j] + noise[j]));
+            row[j] = std::abs(gene) < pruneThreshold ? 0.0 : gene;
+        }
+    }
+}
@@ -0,0 +1,261 @@
+#include "Headless.hpp"
+#include "TrainingRun.hpp"
+#include "AllocationCounter.hpp"
+#include "Random.hpp"
+#include <iostream>
+#include <algorithm>
+#include <sstream>
+
+static std::vector<size_t> buildTopology(const HeadlessOptions& options) {
+    std::vector<size_t> topology = { options.inputNodes };
+    topology.insert(topology.end(), options.hiddenLayers.begin(), options.hiddenLayers.end());
+    topology.push_back(OUTPUT_NODES);
+    return topology;
+}
+
+int runHeadless(const HeadlessOptions& options) {
+    std::vector<size_t> topology = buildTopology(options);
+
+    ThreadPool pool(options.threads, options.pinThreads);
+    if (options.pinThreads) {
+        std::cout << "Headless: " << pool.size() << " workers pinned, loops sharded over "
+                  << pool.getNodeCount() << " NUMA node(s)" << std::endl;
+    }
+    TrainingRun run(options.populationSize, topology, options.eval, pool, options.optimizer, options.precision);
+    run.setScreening(options.screening);
+    run.getPopulation().setPruning(options.pruneThreshold);
+    std::cout << "Headless: " << run.getPopulation().getBytesPerIndividual() << " bytes per individual ("
+              << genePrecisionName(options.precision) << " genes)" << std::endl;
+    if (!options.logPath.empty() && !run.openLog(options.logPath)) {
+        std::cerr << "Could not open generation log " << options.logPath << std::endl;
+        return 1;
+    }
+    TrajectoryWriter trajectories;
+    if (!options.trajectoryPath.empty()) {
+        if (!trajectories.open(options.trajectoryPath, topology.front(), topology.back(), pool.size(),
+                               options.trajectory)) {
+            std::cerr << "Could not open trajectory file " << options.trajectoryPath << std::endl;
+            return 1;
+        }
+        run.setTrajectoryWriter(&trajectories);
+    }
+
+    double totalSeconds = 0.0;
+    long long totalSteps = 0;
+    long long totalSaved = 0;
+    bool screening = options.screening.screenSteps > 0;
+    for (size_t g = 0; g < options.generations; ++g) {
+        GenerationReport report = run.step();
+        totalSeconds += report.seconds;
+        totalSteps += report.steps;
+        totalSaved += report.stepsSaved;
+        std::cout << "Gen: " << report.generation
+                  << " | Best: " << (int)report.bestFitness
+                  << " | Avg: " << report.averageFitness
+                  << " | Score: " << report.bestScore
+                  << " | Saved: " << report.stepsSaved << " steps";
+        if (screening) {
+            std::cout << " | Promoted: " << report.promoted << "/" << report.evaluations;
+        }
+        std::cout << " | " << report.seconds << " s" << std::endl;
+    }
+
+    if (totalSeconds > 0.0) {
+        std::cout << "Headless: " << options.generations << " generations in " << totalSeconds << " s, "
+                  << (long long)(totalSteps / totalSeconds) << " steps/s, "
+                  << totalSaved << " steps saved by loop detection" << std::endl;
+    }
+    if (options.pruneThreshold > 0.0) {
+        NeuralNetwork champion = run.getPopulation().getBrain(0);
+        champion.setSparseDensity(options.eval.sparseDensity);
+        std::cout << "Champion: " << champion.getWeightDensity() * 100.0 << "% of weights nonzero, "
+                  << champion.getSparseLayerCount() << " of " << topology.size() - 1
+                  << " layers sparse" << std::endl;
+    }
+    trajectories.close();
+    return 0;
+}
+
+int runAllocationCheck(const HeadlessOptions& options) {
+    const size_t WARMUP_GAMES = 16;
+    std::vector<size_t> topology = buildTopology(options);
+    size_t geneCount = NeuralNetwork::geneCountFor(topology);
+    size_t games = options.populationSize;
+
+    std::vector<double> genes(games * geneCount);
+    for (size_t i = 0; i < games; ++i) {
+        fillUniform(streamKey(0xA110Cull, 0, i), 0, genes.data() + i * geneCount, geneCount, -1.0, 1.0);
+    }
+
+    // game i plays its episodes on seeds i, i + games, i + 2 * games, ...
+    EvalContext context(options.eval);
+    std::vector<uint64_t> seeds(context.getEpisodeCount());
+    auto play = [&](size_t i) {
+        for (size_t k = 0; k < seeds.size(); ++k) seeds[k] = i + k * games;
+        return context.evaluateEpisodes(topology, genes.data() + i * geneCount, geneCount, seeds.data());
+    };
+
+    // the first games size the context's buffers
+    for (size_t i = 0; i < WARMUP_GAMES && i < games; ++i) {
+        play(i);
+    }
+
+    long long steps = 0;
+    countThreadAllocations(true);
+    size_t before = threadAllocationCount();
+    for (size_t i = 0; i < games; ++i) {
+        steps += play(i).steps;
+    }
+    size_t allocations = threadAllocationCount() - before;
+    countThreadAllocations(false);
+
+    std::cout << "Allocation check: " << allocations << " heap allocations in " << games
+              << " games (" << steps << " steps)" << std::endl;
+    return allocations == 0 ? 0 : 1;
+}
+
+// mean full-length fitness and score of one gene row over held-out games
+static void scoreChampion(EvalContext& context, const std::vector<size_t>& topology, const double* genes,
+                          size_t geneCount, double& fitness, double& score) {
+    const size_t HELD_OUT_GAMES = 200;
+    // fixed, so every champion is scored on the same games
+    const uint64_t HELD_OUT_SEED = 0x4E1D0C7A5EEDull;
+    fitness = 0.0;
+    score = 0.0;
+    for (size_t k = 0; k < HELD_OUT_GAMES; ++k) {
+        GameResult result = context.evaluate(topology, genes, geneCount, streamKey(HELD_OUT_SEED, 0, k));
+        fitness += result.fitness;
+        score += result.score;
+    }
+    fitness /= HELD_OUT_GAMES;
+    score /= HELD_OUT_GAMES;
+}
+
+int runScreeningComparison(const HeadlessOptions& options) {
+    std::vector<size_t> topology = buildTopology(options);
+    ThreadPool pool(options.threads);
+    EvalContext holdOut(options.eval);
+
+    ScreeningConfig screened = options.screening;
+    if (screened.screenSteps <= 0) screened.screenSteps = 100;
+    const ScreeningConfig settings[2] = { ScreeningConfig(), screened };
+    const char* names[2] = { "full games", "screened" };
+    double steps[2] = { 0.0, 0.0 };
+    double fitness[2] = { 0.0, 0.0 };
+    double score[2] = { 0.0, 0.0 };
+    double seconds[2] = { 0.0, 0.0 };
+
+    for (size_t repeat = 0; repeat < options.repeats; ++repeat) {
+        for (int s = 0; s < 2; ++s) {
+            TrainingRun run(options.populationSize, topology, options.eval, pool, options.optimizer);
+            run.setScreening(settings[s]);
+            for (size_t g = 0; g < options.generations; ++g) {
+                GenerationReport report = run.step();
+                steps[s] += (double)report.steps;
+                seconds[s] += report.seconds;
+            }
+            // row 0 holds the optimizer's best guess
+            std::vector<double> champion = run.getPopulation().getGenes(0);
+            double championFitness, championScore;
+            scoreChampion(holdOut, topology, champion.data(), champion.size(), championFitness, championScore);
+            fitness[s] += championFitness;
+            score[s] += championScore;
+            std::cout << "Screening comparison: " << names[s] << " #" << repeat
+                      << " champion fitness " << championFitness << ", score " << championScore << std::endl;
+        }
+    }
+
+    double runs = (double)std::max<size_t>(1, options.repeats);
+    std::cout << "Screening comparison over " << options.repeats << " runs of " << options.generations
+              << " generations (screen " << screened.screenSteps << " steps, promote "
+              << screened.promoteFraction << ", ucb " << screened.ucb << "):" << std::endl;
+    for (int s = 0; s < 2; ++s) {
+        std::cout << "  " << names[s] << ": " << (long long)(steps[s] / runs) << " steps, "
+                  << seconds[s] / runs << " s, champion fitness " << fitness[s] / runs
+                  << ", score " << score[s] / runs << std::endl;
+    }
+    if (steps[0] > 0.0) {
+        std::cout << "  steps saved: " << 100.0 * (1.0 - steps[1] / steps[0]) << "%, champion fitness change: "
+                  << (fitness[1] - fitness[0]) / runs << std::endl;
+    }
+    return 0;
+}
+
+int runPrecisionComparison(const HeadlessOptions& options) {
+    std::vector<size_t> topology = buildTopology(options);
+    ThreadPool pool(options.threads, options.pinThreads);
+    EvalContext holdOut(options.eval);
+
+    const GenePrecision precisions[3] = { GenePrecision::Double, GenePrecision::Float16, GenePrecision::BFloat16 };
+    size_t bytes[3] = { 0, 0, 0 };
+    double fitness[3] = { 0.0, 0.0, 0.0 };
+    double score[3] = { 0.0, 0.0, 0.0 };
+    double seconds[3] = { 0.0, 0.0, 0.0 };
+
+    for (size_t repeat = 0; repeat < options.repeats; ++repeat) {
+        for (int p = 0; p < 3; ++p) {
+            TrainingRun run(options.populationSize, topology, options.eval, pool, options.optimizer, precisions[p]);
+            run.setScreening(options.screening);
+            for (size_t g = 0; g < options.generations; ++g) {
+                seconds[p] += run.step().seconds;
+            }
+            bytes[p] = run.getPopulation().getBytesPerIndividual();
+            std::vector<double> champion = run.getPopulation().getGenes(0);
+            double championFitness, championScore;
+            scoreChampion(holdOut, topology, champion.data(), champion.size(), championFitness, championScore);
+            fitness[p] += championFitness;
+            score[p] += championScore;
+            std::cout << "Precision comparison: " << genePrecisionName(precisions[p]) << " #" << repeat
+                      << " champion fitness " << championFitness << ", score " << championScore << std::endl;
+        }
+    }
+
+    double runs = (double)std::max<size_t>(1, options.repeats);
+    std::cout << "Precision comparison over " << options.repeats << " runs of " << options.generations
+              << " generations (" << NeuralNetwork::geneCountFor(topology) << " genes):" << std::endl;
+    for (int p = 0; p < 3; ++p) {
+        std::cout << "  " << genePrecisionName(precisions[p]) << ": " << bytes[p] << " bytes per individual, "
+                  << seconds[p] / runs << " s, champion fitness " << fitness[p] / runs
+                  << ", score " << score[p] / runs << std::endl;
+    }
+    return 0;
+}
+
+int runScalingReport(const HeadlessOptions& options) {
+    std::vector<size_t> topology = buildTopology(options);
+    NumaTopology numa = options.pinThreads ? NumaTopology::detect() : NumaTopology::singleNode();
+    size_t cores = options.threads > 0 ? options.threads : numa.cpuCount();
+    std::cout << "Scaling report: " << numa.describe() << ", workers "
+              << (options.pinThreads ? "pinned" : "floating") << std::endl;
+
+    std::vector<size_t> counts;
+    for (size_t threads = 1; threads < cores; threads *= 2) counts.push_back(threads);
+    counts.push_back(cores);
+
+    double baseline = 0.0;
+    // printed at the end, away from the runs' own output
+    std::stringstream table;
+    table << "threads,nodes,steps_per_second,speedup,efficiency,stolen_chunks\n";
+    for (size_t threads : counts) {
+        ThreadPool pool(threads, options.pinThreads);
+        TrainingRun run(options.populationSize, topology, options.eval, pool, options.optimizer);
+        run.setScreening(options.screening);
+        // the first generation creates the worker contexts
+        run.step();
+
+        double seconds = 0.0;
+        long long steps = 0;
+        for (size_t g = 0; g < options.generations; ++g) {
+            GenerationReport report = run.step();
+            seconds += report.seconds;
+            steps += report.steps;
+        }
+        double rate = seconds > 0.0 ? (double)steps / seconds : 0.0;
+        if (threads == 1) baseline = rate;
+        double speedup = baseline > 0.0 ? rate / baseline : 0.0;
+        table << threads << "," << pool.getNodeCount() << "," << (long long)rate << "," << speedup << ","
+              << speedup / (double)threads << "," << pool.getStolenChunks() << "\n";
+    }
+    std::cout << table.str();
+    return 0;
+}
@@ -0,0 +1,238 @@
+#include "KernelBenchmark.hpp"
+#include "Kernels.hpp"
+#include "World.hpp"
+#include "NeuralNetwork.hpp"
+#include <iostream>
+#include <fstream>
+#include <chrono>
+#include <random>
+#include <cstdint>
+#include <algorithm>
+
+// every timing runs about this many multiply-adds of the dense layer
+const double WORK_PER_TIMING = 2e8;
+
+/**
+ * @brief A randomly pruned layer in both formats.
+ */
+struct BenchmarkLayer {
+    size_t inputs;
+    size_t neurons;
+    std::vector<double> weights;
+    std::vector<double> biases;
+    std::vector<double> values;
+    std::vector<uint32_t> columns;
+    std::vector<uint32_t> rowStart;
+};
+
+static BenchmarkLayer makeLayer(size_t inputs, size_t neurons, double density, std::mt19937& engine) {
+    std::uniform_real_distribution<double> weight(-1.0, 1.0);
+    std::uniform_real_distribution<double> keep(0.0, 1.0);
+
+    BenchmarkLayer layer;
+    layer.inputs = inputs;
+    layer.neurons = neurons;
+    layer.weights.assign(inputs * neurons, 0.0);
+    layer.biases.resize(neurons);
+    layer.rowStart.push_back(0);
+    // neuron-major like the genes, so the sparse rows come out in order
+    for (size_t n = 0; n < neurons; ++n) {
+        layer.biases[n] = weight(engine);
+        for (size_t p = 0; p < inputs; ++p) {
+            if (keep(engine) >= density) continue;
+            double w = weight(engine);
+            layer.weights[p * neurons + n] = w;
+            layer.values.push_back(w);
+            layer.columns.push_back((uint32_t)p);
+        }
+        layer.rowStart.push_back((uint32_t)layer.values.size());
+    }
+    return layer;
+}
+
+// nanoseconds per call of run(), which is repeated enough to be measurable
+template <typename Run>
+static double timeCalls(size_t work, Run run) {
+    size_t calls = std::max<size_t>(16, (size_t)(WORK_PER_TIMING / (double)std::max<size_t>(1, work)));
+    run();
+    auto start = std::chrono::steady_clock::now();
+    for (size_t i = 0; i < calls; ++i) run();
+    auto end = std::chrono::steady_clock::now();
+    return std::chrono::duration<double, std::nano>(end - start).count() / (double)calls;
+}
+
+int runSparseBenchmark(const SparseBenchmarkOptions& options) {
+    std::cout << "CPU dispatch: " << cpuDispatchLevel() << std::endl;
+    std::mt19937 engine(12345);
+    std::uniform_real_distribution<double> activation(0.01, 1.0);
+
+    std::ofstream out(options.outputPath);
+    if (!out) {
+        std::cerr << "Could not open " << options.outputPath << std::endl;
+        return 1;
+    }
+    out << "width,density,dense_ns,sparse_ns,speedup\n";
+
+    bool agree = true;
+    double checksum = 0.0;
+    for (size_t width : options.widths) {
+        // hidden activations with no zeros, so only the weights are sparse
+        std::vector<double> input(width);
+        for (double& x : input) x = activation(engine);
+        std::vector<double> dense(width), sparse(width);
+
+        double crossover = 0.0;
+        std::cout << "Width " << width << ":" << std::endl;
+        for (double density : options.densities) {
+            BenchmarkLayer layer = makeLayer(width, width, density, engine);
+            double denseNs = timeCalls(width * width, [&]() {
+                denseLayer(layer.weights.data(), layer.biases.data(), input.data(), dense.data(), width, width);
+                checksum += dense[0];
+            });
+            double sparseNs = timeCalls(width * width, [&]() {
+                sparseLayer(layer.values.data(), layer.columns.data(), layer.rowStart.data(),
+                            layer.biases.data(), input.data(), sparse.data(), width);
+                checksum += sparse[0];
+            });
+            if (dense != sparse) agree = false;
+            if (sparseNs < denseNs) crossover = std::max(crossover, density);
+
+            std::cout << "  density " << density << ": dense " << denseNs << " ns, sparse " << sparseNs
+                      << " ns (" << denseNs / sparseNs << "x)" << std::endl;
+            out << width << "," << density << "," << denseNs << "," << sparseNs << "," << denseNs / sparseNs << "\n";
+        }
+        if (crossover > 0.0) {
+            std::cout << "  sparse wins at density " << crossover << " and below" << std::endl;
+        } else {
+            std::cout << "  sparse never wins" << std::endl;
+        }
+
+        // input layer: binary sensors, few active at a time
+        BenchmarkLayer inputLayer = makeLayer(BASIC_INPUT_NODES, width, 1.0, engine);
+        std::vector<double> allActive(BASIC_INPUT_NODES, 1.0);
+        std::vector<double> fewActive(BASIC_INPUT_NODES, 0.0);
+        for (size_t p = 0; p < BASIC_INPUT_NODES; p += 4) fewActive[p] = 1.0;
+        double allNs = timeCalls(BASIC_INPUT_NODES * width, [&]() {
+            denseLayer(inputLayer.weights.data(), inputLayer.biases.data(), allActive.data(), dense.data(),
+                       BASIC_INPUT_NODES, width);
+            checksum += dense[0];
+        });
+        double fewNs = timeCalls(BASIC_INPUT_NODES * width, [&]() {
+            denseLayer(inputLayer.weights.data(), inputLayer.biases.data(), fewActive.data(), dense.data(),
+                       BASIC_INPUT_NODES, width);
+            checksum += dense[0];
+        });
+        std::cout << "  input layer " << BASIC_INPUT_NODES << "->" << width << ": all inputs on " << allNs
+                  << " ns, 3 on " << fewNs << " ns" << std::endl;
+    }
+
+    std::cout << "Results written to " << options.outputPath << " (checksum " << checksum << ")" << std::endl;
+    if (!agree) {
+        std::cerr << "Sparse and dense layers disagree" << std::endl;
+        return 1;
+    }
+    return 0;
+}
+
+// one neuron after another, each a dot product with its weight row (rows is
+// neuron-major); no zero skipping and no blocking
+static void referenceLayer(const double* rows, const double* biases, const double* input, double* output,
+                           size_t inputs, size_t neurons, size_t batch) {
+    for (size_t b = 0; b < batch; ++b) {
+        const double* x = input + b * inputs;
+        for (size_t n = 0; n < neurons; ++n) {
+            double sum = biases[n];
+            const double* row = rows + n * inputs;
+            for (size_t p = 0; p < inputs; ++p) sum += x[p] * row[p];
+            output[b * neurons + n] = sum;
+        }
+    }
+}
+
+int runLayerBenchmark(const LayerBenchmarkOptions& options) {
+    std::cout << "CPU dispatch: " << cpuDispatchLevel() << std::endl;
+    std::mt19937 engine(12345);
+    std::uniform_real_distribution<double> activation(0.01, 1.0);
+    std::uniform_real_distribution<double> unit(0.0, 1.0);
+    std::uniform_real_distribution<double> gene(-1.0, 1.0);
+
+    std::ofstream out(options.outputPath);
+    if (!out) {
+        std::cerr << "Could not open " << options.outputPath << std::endl;
+        return 1;
+    }
+    out << "width,batch,reference_ns,blocked_ns,speedup,network_ns\n";
+
+    bool agree = true;
+    double checksum = 0.0;
+    for (size_t width : options.widths) {
+        BenchmarkLayer layer = makeLayer(width, width, 1.0, engine);
+        std::vector<double> rows(width * width), packed(width * width);
+        for (size_t p = 0; p < width; ++p) {
+            for (size_t n = 0; n < width; ++n) {
+                double w = layer.weights[p * width + n];
+                rows[n * width + p] = w;
+                packed[packedWeightIndex(p, n, width, width)] = w;
+            }
+        }
+
+        std::vector<size_t> topology = { BASIC_INPUT_NODES, width, width, OUTPUT_NODES };
+        NeuralNetwork network(topology, ActivationType::RELU);
+        std::vector<double> genes(NeuralNetwork::geneCountFor(topology));
+        for (double& g : genes) g = gene(engine);
+        network.setGenes(genes);
+
+        std::cout << "Width " << width << ":" << std::endl;
+        for (size_t batch : options.batches) {
+            if (batch == 0) continue;
+            // hidden activations with zeroShare of them zero, as behind a ReLU
+            std::vector<double> input(batch * width);
+            for (double& x : input) x = unit(engine) < options.zeroShare ? 0.0 : activation(engine);
+            std::vector<double> expected(batch * width), blocked(batch * width);
+
+            size_t work = batch * width * width;
+            double referenceNs = timeCalls(work, [&]() {
+                referenceLayer(rows.data(), layer.biases.data(), input.data(), expected.data(), width, width, batch);
+                checksum += expected[0];
+            });
+            double blockedNs = timeCalls(work, [&]() {
+                if (batch == 1) {
+                    denseLayer(layer.weights.data(), layer.biases.data(), input.data(), blocked.data(), width, width);
+                } else {
+                    denseLayerBatch(packed.data(), layer.biases.data(), input.data(), blocked.data(), width, width,
+                                    batch);
+                }
+                checksum += blocked[0];
+            });
+            if (blocked != expected) agree = false;
+
+            // binary sensors, about a third of them on
+            std::vector<double> sensors(batch * BASIC_INPUT_NODES);
+            for (double& x : sensors) x = unit(engine) < 0.3 ? 1.0 : 0.0;
+            double networkNs = timeCalls(work, [&]() {
+                const double* result = batch == 1 ? network.feedForward(sensors.data())
+                                                  : network.feedForwardBatch(sensors.data(), batch);
+                checksum += result[0];
+            });
+            const double* batched = network.feedForwardBatch(sensors.data(), batch);
+            std::vector<double> together(batched, batched + batch * OUTPUT_NODES);
+            for (size_t b = 0; b < batch; ++b) {
+                const double* single = network.feedForward(sensors.data() + b * BASIC_INPUT_NODES);
+                if (!std::equal(single, single + OUTPUT_NODES, together.begin() + b * OUTPUT_NODES)) agree = false;
+            }
+
+            std::cout << "  batch " << batch << ": reference " << referenceNs << " ns, blocked " << blockedNs
+                      << " ns (" << referenceNs / blockedNs << "x), network " << networkNs / (double)batch
+                      << " ns per input" << std::endl;
+            out << width << "," << batch << "," << referenceNs << "," << blockedNs << ","
+                << referenceNs / blockedNs << "," << networkNs << "\n";
+        }
+    }
+
+    std::cout << "Results written to " << options.outputPath << " (checksum " << checksum << ")" << std::endl;
+    if (!agree) {
+        std::cerr << "Blocked layers disagree with the reference" << std::endl;
+        return 1;
+    }
+    return 0;
+}
@@ -0,0 +1,258 @@
+#include "Kernels.hpp"
+
+// layers with fewer neurons than this take the per-neuron path in denseLayerBatch
+const size_t NARROW_LAYER = 8;
+// nonzero inputs denseLayer gathers before sweeping the panels: their rows
+// are read as that many parallel streams while the panel sums stay in registers
+const size_t INPUT_GROUP = 8;
+// batch rows whose sums share the registers with one panel in denseLayerBatch;
+// a block of one panel (at most 256 x 16 doubles, 32 KB) stays in L1 meanwhile
+const size_t BATCH_TILE = 2;
+
+// the helpers are inlined into every dispatched clone, so they get its ISA
+#define KERNEL_INLINE inline __attribute__((always_inline))
+
+// Four doubles that the compiler keeps in one vector register (two on SSE);
+// the element-wise products and sums round exactly like scalar code.
+typedef double Lanes __attribute__((vector_size(4 * sizeof(double))));
+const size_t LANES = 4;
+const size_t PANEL_LANES = PANEL_WIDTH / LANES;
+
+// by reference, since vector arguments and results would depend on the ABI
+static KERNEL_INLINE void loadLanes(Lanes& lanes, const double* source) {
+    __builtin_memcpy(&lanes, source, sizeof(lanes));
+}
+
+static KERNEL_INLINE void storeLanes(double* target, const Lanes& lanes) {
+    __builtin_memcpy(target, &lanes, sizeof(lanes));
+}
+
+// Adds `count` gathered inputs (indices `active`, values `x`) to the sums of
+// the PANEL_WIDTH neurons at output, whose weights are at `weights` in rows
+// of `stride` doubles; the sums stay in registers.
+static KERNEL_INLINE void applyInputGroup(const double* weights, size_t stride, const uint32_t* active,
+                                          const double* x, size_t count, double* output) {
+    Lanes sums[PANEL_LANES];
+    for (size_t v = 0; v < PANEL_LANES; ++v) loadLanes(sums[v], output + v * LANES);
+    for (size_t i = 0; i < count; ++i) {
+        const double* row = weights + active[i] * stride;
+        const double value = x[i];
+        for (size_t v = 0; v < PANEL_LANES; ++v) {
+            Lanes w;
+            loadLanes(w, row + v * LANES);
+            sums[v] += value * w;
+        }
+    }
+    for (size_t v = 0; v < PANEL_LANES; ++v) storeLanes(output + v * LANES, sums[v]);
+}
+
+// Adds inputs [first, last), the panel's block, of ROWS batch rows to the
+// sums of one full panel; input and output point at the first row.
+template <size_t ROWS>
+static KERNEL_INLINE void applyPanelRows(const double* panel, const double* input, size_t inputs,
+                                         size_t first, size_t last, double* output, size_t neurons) {
+    Lanes sums[ROWS][PANEL_LANES];
+    for (size_t r = 0; r < ROWS; ++r) {
+        for (size_t v = 0; v < PANEL_LANES; ++v) loadLanes(sums[r][v], output + r * neurons + v * LANES);
+    }
+    for (size_t p = first; p < last; ++p) {
+        double x[ROWS];
+        bool active = false;
+        for (size_t r = 0; r < ROWS; ++r) {
+            x[r] = input[r * inputs + p];
+            active |= x[r] != 0.0;
+        }
+        if (!active) continue;
+        Lanes row[PANEL_LANES];
+        for (size_t v = 0; v < PANEL_LANES; ++v) loadLanes(row[v], panel + (p - first) * PANEL_WIDTH + v * LANES);
+        for (size_t r = 0; r < ROWS; ++r) {
+            for (size_t v = 0; v < PANEL_LANES; ++v) {
+                sums[r][v] += x[r] * row[v];
+            }
+        }
+    }
+    for (size_t r = 0; r < ROWS; ++r) {
+        for (size_t v = 0; v < PANEL_LANES; ++v) storeLanes(output + r * neurons + v * LANES, sums[r][v]);
+    }
+}
+
+// one full panel for the whole batch, BATCH_TILE rows at a time
+static KERNEL_INLINE void applyPanelBatch(const double* panel, const double* input, size_t inputs,
+                                          size_t first, size_t last, double* output, size_t neurons,
+                                          size_t batch) {
+    size_t b = 0;
+    for (; b + BATCH_TILE <= batch; b += BATCH_TILE) {
+        applyPanelRows<BATCH_TILE>(panel, input + b * inputs, inputs, first, last, output + b * neurons, neurons);
+    }
+    for (; b < batch; ++b) {
+        applyPanelRows<1>(panel, input + b * inputs, inputs, first, last, output + b * neurons, neurons);
+    }
+}
+
+// the narrower last panel for the whole batch; each weight row is applied
+// to every batch row before moving on
+static KERNEL_INLINE void applyNarrowPanelBatch(const double* panel, size_t width, const double* input,
+                                                size_t inputs, size_t first, size_t last, double* output,
+                                                size_t neurons, size_t batch) {
+    for (size_t p = first; p < last; ++p) {
+        const double* row = panel + (p - first) * width;
+        for (size_t b = 0; b < batch; ++b) {
+            const double x = input[b * inputs + p];
+            if (x == 0.0) continue;
+            double* out = output + b * neurons;
+            for (size_t j = 0; j < width; ++j) {
+                out[j] += x * row[j];
+            }
+        }
+    }
+}
+
+SNAKE_DISPATCH
+void denseLayer(const double* weights, const double* biases, const double* input,
+                double* output, size_t inputs, size_t neurons) {
+    for (size_t n = 0; n < neurons; ++n) {
+        output[n] = biases[n];
+    }
+    if (neurons < PANEL_WIDTH) {
+        // too narrow for a panel: add the rows one by one; inputs that are
+        // one add their row without multiplying
+        for (size_t p = 0; p < inputs; ++p) {
+            const double x = input[p];
+            if (x == 0.0) continue;
+            const double* row = weights + p * neurons;
+            if (x == 1.0) {
+                for (size_t n = 0; n < neurons; ++n) {
+                    output[n] += row[n];
+                }
+                continue;
+            }
+            for (size_t n = 0; n < neurons; ++n) {
+                output[n] += x * row[n];
+            }
+        }
+        return;
+    }
+
+    uint32_t active[INPUT_GROUP];
+    double x[INPUT_GROUP];
+    for (size_t p = 0; p < inputs;) {
+        size_t count = 0;
+        for (; p < inputs && count < INPUT_GROUP; ++p) {
+            if (input[p] == 0.0) continue;
+            active[count] = (uint32_t)p;
+            x[count++] = input[p];
+        }
+
+        size_t n = 0;
+        for (; n + PANEL_WIDTH <= neurons; n += PANEL_WIDTH) {
+            applyInputGroup(weights + n, neurons, active, x, count, output + n);
+        }
+        for (size_t i = 0; i < count; ++i) {
+            const double* row = weights + active[i] * neurons;
+            for (size_t m = n; m < neurons; ++m) {
+                output[m] += x[i] * row[m];
+            }
+        }
+    }
+}
+
+SNAKE_DISPATCH
+void denseLayerBatch(const double* weights, const double* biases, const double* input,
+                     double* output, size_t inputs, size_t neurons, size_t batch) {
+    if (neurons < NARROW_LAYER) {
+        // too narrow to vectorize across neurons: keep four rows' sums in
+        // registers instead, so each weight feeds four independent chains;
+        // a layer this narrow is a single input-major panel
+        for (size_t n = 0; n < neurons; ++n) {
+            size_t b = 0;
+            for (; b + 4 <= batch; b += 4) {
+                const double* x0 = input + b * inputs;
+                const double* x1 = x0 + inputs;
+                const double* x2 = x1 + inputs;
+                const double* x3 = x2 + inputs;
+                double a0 = biases[n], a1 = biases[n], a2 = biases[n], a3 = biases[n];
+                for (size_t p = 0; p < inputs; ++p) {
+                    const double w = weights[p * neurons + n];
+                    a0 += x0[p] * w;
+                    a1 += x1[p] * w;
+                    a2 += x2[p] * w;
+                    a3 += x3[p] * w;
+                }
+                output[b * neurons + n] = a0;
+                output[(b + 1) * neurons + n] = a1;
+                output[(b + 2) * neurons + n] = a2;
+                output[(b + 3) * neurons + n] = a3;
+            }
+            for (; b < batch; ++b) {
+                const double* x = input + b * inputs;
+                double a = biases[n];
+                for (size_t p = 0; p < inputs; ++p) {
+                    a += x[p] * weights[p * neurons + n];
+                }
+                output[b * neurons + n] = a;
+            }
+        }
+        return;
+    }
+
+    for (size_t b = 0; b < batch; ++b) {
+        for (size_t n = 0; n < neurons; ++n) {
+            output[b * neurons + n] = biases[n];
+        }
+    }
+    for (size_t first = 0; first < inputs; first += PANEL_INPUTS) {
+        size_t last = first + PANEL_INPUTS < inputs ? first + PANEL_INPUTS : inputs;
+        const double* block = weights + first * neurons;
+        size_t rows = last - first;
+        size_t n = 0;
+        for (; n + PANEL_WIDTH <= neurons; n += PANEL_WIDTH) {
+            applyPanelBatch(block + n * rows, input, inputs, first, last, output + n, neurons, batch);
+        }
+        if (n < neurons) {
+            applyNarrowPanelBatch(block + n * rows, neurons - n, input, inputs, first, last,
+                                  output + n, neurons, batch);
+        }
+    }
+}
+
+SNAKE_DISPATCH
+void sparseLayer(const double* values, const uint32_t* columns, const uint32_t* rowStart,
+                 const double* biases, const double* input, double* output, size_t neurons) {
+    for (size_t n = 0; n < neurons; ++n) {
+        double sum = biases[n];
+        for (uint32_t k = rowStart[n]; k < rowStart[n + 1]; ++k) {
+            sum += input[columns[k]] * values[k];
+        }
+        output[n] = sum;
+    }
+}
+
+SNAKE_DISPATCH
+void sparseLayerBatch(const double* values, const uint32_t* columns, const uint32_t* rowStart,
+                      const double* biases, const double* input, double* output,
+                      size_t inputs, size_t neurons, size_t batch) {
+    for (size_t n = 0; n < neurons; ++n) {
+        for (size_t b = 0; b < batch; ++b) {
+            output[b * neurons + n] = biases[n];
+        }
+        for (uint32_t k = rowStart[n]; k < rowStart[n + 1]; ++k) {
+            const double w = values[k];
+            const double* x = input + columns[k];
+            for (size_t b = 0; b < batch; ++b) {
+                output[b * neurons + n] += x[b * inputs] * w;
+            }
+        }
+    }
+}
+
+const char* cpuDispatchLevel() {
+#if defined(__x86_64__) && defined(__linux__) && defined(__GNUC__) && !defined(SNAKE_NO_DISPATCH)
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("avx512f")) return "avx512f";
+    if (__builtin_cpu_supports("avx2")) return "avx2";
+    if (__builtin_cpu_supports("sse4.2")) return "sse4.2";
+    return "default";
+#else
+    return "default (dispatch disabled)";
+#endif
+}
@@ -0,0 +1,176 @@
+#include "Metrics.hpp"
+#include <sstream>
+#include <fstream>
+#include <cstring>
+#include <algorithm>
+#include <iostream>
+#include <unistd.h>
+#include <poll.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+
+const size_t TrainingMetrics::MAX_WORKERS;
+
+// how often the server thread checks whether it should stop
+const int POLL_MILLISECONDS = 200;
+
+TrainingMetrics& trainingMetrics() {
+    static TrainingMetrics instance;
+    return instance;
+}
+
+void TrainingMetrics::recordEvaluation(uint64_t nanoseconds) {
+    double seconds = (double)nanoseconds * 1e-9;
+    size_t bucket = 0;
+    while (bucket < EVAL_LATENCY_BUCKET_COUNT && seconds > EVAL_LATENCY_BUCKETS[bucket]) ++bucket;
+    latencyBuckets[bucket].fetch_add(1, std::memory_order_relaxed);
+    latencyNanoseconds.fetch_add(nanoseconds, std::memory_order_relaxed);
+}
+
+// resident set size from /proc, 0 where it is not available
+static uint64_t residentBytes() {
+    std::ifstream statm("/proc/self/statm");
+    uint64_t pages = 0, resident = 0;
+    if (!(statm >> pages >> resident)) return 0;
+    return resident * (uint64_t)sysconf(_SC_PAGESIZE);
+}
+
+MetricsServer::MetricsServer() : listener(-1), stopping(false), lastBusy(0), lastScrape(0) {}
+
+MetricsServer::~MetricsServer() {
+    stop();
+}
+
+bool MetricsServer::start(const std::string& path) {
+    sockaddr_un address = {};
+    address.sun_family = AF_UNIX;
+    if (path.size() >= sizeof(address.sun_path)) return false;
+    std::strcpy(address.sun_path, path.c_str());
+
+    listener = socket(AF_UNIX, SOCK_STREAM, 0);
+    if (listener < 0) return false;
+    unlink(path.c_str());
+    if (bind(listener, (sockaddr*)&address, sizeof(address)) != 0 || listen(listener, 8) != 0) {
+        close(listener);
+        listener = -1;
+        return false;
+    }
+
+    this->path = path;
+    stopping = false;
+    lastScrape = metricsClock();
+    trainingMetrics().enabled.store(true, std::memory_order_relaxed);
+    thread = std::thread(&MetricsServer::run, this);
+    return true;
+}
+
+void MetricsServer::stop() {
+    if (!thread.joinable()) return;
+    stopping = true;
+    thread.join();
+    close(listener);
+    listener = -1;
+    unlink(path.c_str());
+    trainingMetrics().enabled.store(false, std::memory_order_relaxed);
+}
+
+void MetricsServer::run() {
+    while (!stopping) {
+        pollfd waiting = { listener, POLLIN, 0 };
+        if (poll(&waiting, 1, POLL_MILLISECONDS) <= 0) continue;
+        int client = accept(listener, nullptr, nullptr);
+        if (client < 0) continue;
+
+        // take whatever request is already there; the reply does not depend on it
+        char request[1024];
+        pollfd reading = { client, POLLIN, 0 };
+        if (poll(&reading, 1, POLL_MILLISECONDS) > 0) {
+            ssize_t ignored = recv(client, request, sizeof(request), 0);
+            (void)ignored;
+        }
+
+        std::string body = render();
+        std::string response = "HTTP/1.0 200 OK\r\nContent-Type: text/plain; version=0.0.4\r\nContent-Length: "
+                             + std::to_string(body.size()) + "\r\n\r\n" + body;
+        size_t sent = 0;
+        while (sent < response.size()) {
+            ssize_t written = send(client, response.data() + sent, response.size() - sent, MSG_NOSIGNAL);
+            if (written <= 0) break;
+            sent += (size_t)written;
+        }
+        close(client);
+    }
+}
+
+static void writeMetric(std::ostream& out, const char* name, const char* type, const char* help, double value) {
+    out << "# HELP " << name << " " << help << "\n# TYPE " << name << " " << type << "\n"
+        << name << " " << value << "\n";
+}
+
+std::string MetricsServer::render() {
+    const auto relaxed = std::memory_order_relaxed;
+    TrainingMetrics& m = trainingMetrics();
+    std::ostringstream out;
+    out.precision(17);
+
+    writeMetric(out, "snake_generation", "gauge", "Generation of the last completed training step.",
+                (double)m.generation.load(relaxed));
+    writeMetric(out, "snake_generations_total", "counter", "Training steps completed.",
+                (double)m.generations.load(relaxed));
+    writeMetric(out, "snake_best_fitness", "gauge", "Best fitness of the last generation.",
+                m.bestFitness.load(relaxed));
+    writeMetric(out, "snake_average_fitness", "gauge", "Average fitness of the last generation.",
+                m.averageFitness.load(relaxed));
+    writeMetric(out, "snake_best_score", "gauge", "Most food eaten in one game of the last generation.",
+                (double)m.bestScore.load(relaxed));
+    writeMetric(out, "snake_evaluations_total", "counter", "Individuals evaluated.",
+                (double)m.evaluations.load(relaxed));
+    writeMetric(out, "snake_steps_total", "counter", "Game steps simulated.", (double)m.steps.load(relaxed));
+    writeMetric(out, "snake_steps_saved_total", "counter", "Game steps skipped by loop detection.",
+                (double)m.stepsSaved.load(relaxed));
+    writeMetric(out, "snake_steps_per_second", "gauge", "Simulation throughput of the last generation.",
+                m.stepsPerSecond.load(relaxed));
+    writeMetric(out, "snake_generation_seconds", "gauge", "Wall time of the last generation.",
+                m.generationSeconds.load(relaxed));
+
+    out << "# HELP snake_evaluation_seconds Time to evaluate one individual (all its episodes).\n"
+        << "# TYPE snake_evaluation_seconds histogram\n";
+    uint64_t cumulative = 0;
+    for (size_t b = 0; b <= EVAL_LATENCY_BUCKET_COUNT; ++b) {
+        cumulative += m.latencyBuckets[b].load(relaxed);
+        std::ostringstream bound;
+        if (b < EVAL_LATENCY_BUCKET_COUNT) bound << EVAL_LATENCY_BUCKETS[b];
+        else bound << "+Inf";
+        out << "snake_evaluation_seconds_bucket{le=\"" << bound.str() << "\"} " << cumulative << "\n";
+    }
+    out << "snake_evaluation_seconds_sum " << (double)m.latencyNanoseconds.load(relaxed) * 1e-9 << "\n"
+        << "snake_evaluation_seconds_count " << cumulative << "\n";
+
+    writeMetric(out, "snake_queue_depth", "gauge", "Loop indices (individuals, gene rows) not yet taken by a worker.",
+                (double)m.queuedItems.load(relaxed));
+    size_t workers = std::min<size_t>(m.workers.load(relaxed), TrainingMetrics::MAX_WORKERS);
+    writeMetric(out, "snake_workers", "gauge", "Worker threads in the pool.", (double)workers);
+
+    out << "# HELP snake_worker_busy_seconds_total Time each worker spent running loop chunks.\n"
+        << "# TYPE snake_worker_busy_seconds_total counter\n";
+    uint64_t busy = 0;
+    for (size_t w = 0; w < workers; ++w) {
+        uint64_t nanoseconds = m.busyNanoseconds[w].load(relaxed);
+        busy += nanoseconds;
+        out << "snake_worker_busy_seconds_total{worker=\"" << w << "\"} " << (double)nanoseconds * 1e-9 << "\n";
+    }
+    uint64_t now = metricsClock();
+    double capacity = (double)(now - lastScrape) * (double)workers;
+    // busy time is booked when a chunk ends, so a chunk that spans two
+    // scrapes can push one interval over 1
+    double utilization = capacity > 0.0 ? (double)(busy - std::min(busy, lastBusy)) / capacity : 0.0;
+    utilization = std::min(1.0, utilization);
+    lastBusy = busy;
+    lastScrape = now;
+    writeMetric(out, "snake_worker_utilization", "gauge", "Share of worker time spent busy since the last scrape.",
+                utilization);
+
+    writeMetric(out, "snake_resident_bytes", "gauge", "Resident set size of the process.",
+                (double)residentBytes());
+    return out.str();
+}
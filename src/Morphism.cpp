@@ -0,0 +1,124 @@
+#include "Morphism.hpp"
+#include "NeuralNetwork.hpp"
+#include "Random.hpp"
+#include <algorithm>
+#include <cmath>
+#include <stdexcept>
+
+// first gene of layer `layer` (topology index, >= 1) in a gene row
+static size_t layerOffset(const std::vector<size_t>& topology, size_t layer) {
+    size_t offset = 0;
+    for (size_t l = 1; l < layer; ++l) {
+        offset += topology[l] * (topology[l - 1] + 1);
+    }
+    return offset;
+}
+
+static bool isHiddenLayer(const std::vector<size_t>& topology, size_t layer) {
+    return layer >= 1 && layer + 1 < topology.size();
+}
+
+std::vector<size_t> morphedTopology(const std::vector<size_t>& topology, const Morph& morph) {
+    std::vector<size_t> result = topology;
+    switch (morph.kind) {
+        case MorphKind::AddNeuron:
+            if (!isHiddenLayer(topology, morph.layer)) {
+                throw std::invalid_argument("Only hidden layers can gain neurons.");
+            }
+            result[morph.layer]++;
+            break;
+        case MorphKind::RemoveNeuron:
+            if (!isHiddenLayer(topology, morph.layer) || topology[morph.layer] < 2 ||
+                morph.neuron >= topology[morph.layer]) {
+                throw std::invalid_argument("Only hidden layers with two or more neurons can lose one.");
+            }
+            result[morph.layer]--;
+            break;
+        case MorphKind::InsertLayer:
+            if (morph.layer < 1 || morph.layer >= topology.size()) {
+                throw std::invalid_argument("A new layer must sit between the inputs and the outputs.");
+            }
+            result.insert(result.begin() + morph.layer, topology[morph.layer - 1]);
+            break;
+    }
+    return result;
+}
+
+void applyMorph(const std::vector<size_t>& topology, const Morph& morph, const double* genes, double* out,
+                uint64_t key) {
+    // throws if the morph does not fit
+    morphedTopology(topology, morph);
+    size_t geneCount = NeuralNetwork::geneCountFor(topology);
+    size_t start = layerOffset(topology, morph.layer);
+    // everything before the edited layer stays where it is
+    out = std::copy(genes, genes + start, out);
+    genes += start;
+
+    if (morph.kind == MorphKind::InsertLayer) {
+        size_t width = topology[morph.layer - 1];
+        std::fill(out, out + width, 0.0);
+        out += width;
+        for (size_t n = 0; n < width; ++n) {
+            for (size_t p = 0; p < width; ++p) {
+                *out++ = n == p ? 1.0 : 0.0;
+            }
+        }
+        // the layer after it still sees the same number of inputs
+        std::copy(genes, genes + (geneCount - start), out);
+        return;
+    }
+
+    size_t inputs = topology[morph.layer - 1];
+    size_t neurons = topology[morph.layer];
+    size_t followers = topology[morph.layer + 1];
+    const double* biases = genes;
+    const double* weights = genes + neurons;
+    const double* nextBiases = weights + neurons * inputs;
+    const double* nextWeights = nextBiases + followers;
+    const double* rest = nextWeights + followers * neurons;
+
+    if (morph.kind == MorphKind::AddNeuron) {
+        out = std::copy(biases, biases + neurons, out);
+        fillUniform(key, 0, out++, 1, -1.0, 1.0);
+        out = std::copy(weights, weights + neurons * inputs, out);
+        fillUniform(key, 1, out, inputs, -1.0, 1.0);
+        out += inputs;
+        out = std::copy(nextBiases, nextBiases + followers, out);
+        for (size_t k = 0; k < followers; ++k) {
+            out = std::copy(nextWeights + k * neurons, nextWeights + (k + 1) * neurons, out);
+            // summed last, so the next layer's sums are unchanged
+            *out++ = 0.0;
+        }
+    } else {
+        size_t m = morph.neuron;
+        out = std::copy(biases, biases + m, out);
+        out = std::copy(biases + m + 1, biases + neurons, out);
+        out = std::copy(weights, weights + m * inputs, out);
+        out = std::copy(weights + (m + 1) * inputs, weights + neurons * inputs, out);
+        out = std::copy(nextBiases, nextBiases + followers, out);
+        for (size_t k = 0; k < followers; ++k) {
+            const double* row = nextWeights + k * neurons;
+            out = std::copy(row, row + m, out);
+            out = std::copy(row + m + 1, row + neurons, out);
+        }
+    }
+    std::copy(rest, genes + (geneCount - start), out);
+}
+
+double neuronContribution(const std::vector<size_t>& topology, size_t layer, size_t neuron, const double* genes) {
+    if (!isHiddenLayer(topology, layer) || neuron >= topology[layer]) {
+        throw std::invalid_argument("Contribution is only defined for hidden neurons.");
+    }
+    size_t inputs = topology[layer - 1];
+    size_t neurons = topology[layer];
+    size_t followers = topology[layer + 1];
+    const double* biases = genes + layerOffset(topology, layer);
+    const double* incoming = biases + neurons + neuron * inputs;
+    const double* nextWeights = biases + neurons + neurons * inputs + followers;
+
+    double scale = std::abs(biases[neuron]);
+    for (size_t p = 0; p < inputs; ++p) scale += std::abs(incoming[p]);
+    double outgoing = 0.0;
+    for (size_t k = 0; k < followers; ++k) outgoing += std::abs(nextWeights[k * neurons + neuron]);
+    return scale * outgoing;
+}
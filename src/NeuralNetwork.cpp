@@ -1,35 +1,70 @@
 #include "NeuralNetwork.hpp"
+#include "Kernels.hpp"
 #include <stdexcept> 
 #include <cmath>     
+#include <algorithm>
 
 // Use the mt19937 Mersenne Twister engine for better randomness
-std::mt19937 NeuralNetwork::randomEngine(std::random_device{}());
+thread_local std::mt19937 NeuralNetwork::randomEngine(std::random_device{}());
 
-NeuralNetwork::NeuralNetwork(const std::vector<size_t>& topology, ActivationType funcType) {
+NeuralNetwork::NeuralNetwork(const std::vector<size_t>& topology, ActivationType funcType)
+    : topology(topology) {
+    buildLayers();
+    activations.assign(layers.size(), funcType);
+}
+
+NeuralNetwork::NeuralNetwork(const std::vector<size_t>& topology, const NetworkActivations& activations)
+    : topology(topology) {
+    buildLayers();
+    this->activations = activations.forLayers(layers.size());
+}
+
+void NeuralNetwork::buildLayers() {
     if (topology.size() < 2) {
         throw std::invalid_argument("Topology must have at least 2 layers (input and output).");
     }
-    this->topology = topology;
-    setActivation(funcType);
 
     for (size_t i = 1; i < topology.size(); ++i) {
         size_t numNeurons = topology[i];
         size_t numPrevLayerNeurons = topology[i - 1];
 
         Layer newLayer;
-        
+        newLayer.inputs = numPrevLayerNeurons;
+        newLayer.neurons = numNeurons;
         newLayer.biases.resize(numNeurons);
-        newLayer.weights.resize(numNeurons, std::vector<double>(numPrevLayerNeurons));
+        newLayer.weights.resize(numNeurons * numPrevLayerNeurons);
+        newLayer.packed.resize(newLayer.weights.size());
+        newLayer.sparseValues.resize(newLayer.weights.size());
+        newLayer.sparseColumns.resize(newLayer.weights.size());
+        newLayer.rowStart.resize(numNeurons + 1);
 
         // initialize all weights and biases with random values
+        size_t nonzero = 0;
         for (size_t n = 0; n < numNeurons; ++n) {
             newLayer.biases[n] = getRandomDouble();
+            newLayer.rowStart[n] = (uint32_t)nonzero;
             for (size_t p = 0; p < numPrevLayerNeurons; ++p) {
-                newLayer.weights[n][p] = getRandomDouble();
+                double weight = getRandomDouble();
+                newLayer.weights[p * numNeurons + n] = weight;
+                if (weight != 0.0) {
+                    newLayer.sparseValues[nonzero] = weight;
+                    newLayer.sparseColumns[nonzero] = (uint32_t)p;
+                    ++nonzero;
+                }
             }
         }
+        newLayer.rowStart[numNeurons] = (uint32_t)nonzero;
+        newLayer.nonzero = nonzero;
+        newLayer.sparse = false;
         layers.push_back(newLayer);
     }
+
+    packedCurrent = false;
+
+    size_t widest = 0;
+    for (size_t size : topology) widest = std::max(widest, size);
+    scratchA.resize(widest);
+    scratchB.resize(widest);
 }
 
 std::vector<double> NeuralNetwork::feedForward(const std::vector<double>& inputs) {
@@ -37,28 +72,63 @@ std::vector<double> NeuralNetwork::feedForward(const std::vector<double>& inputs
         throw std::invalid_argument("Input vector size does not match input layer topology.");
     }
 
-    std::vector<double> currentOutputs = inputs;
+    const double* outputs = feedForward(inputs.data());
+    return std::vector<double>(outputs, outputs + topology.back());
+}
 
-    for (const auto& layer : layers) {
-        size_t numNeurons = layer.biases.size();
-        size_t numPrevLayerNeurons = layer.weights[0].size();
-        
-        std::vector<double> nextOutputs(numNeurons);
+const double* NeuralNetwork::feedForward(const double* inputs) {
+    const double* current = inputs;
+    double* next = scratchA.data();
+
+    for (size_t l = 0; l < layers.size(); ++l) {
+        const Layer& layer = layers[l];
+        if (layer.sparse) {
+            sparseLayer(layer.sparseValues.data(), layer.sparseColumns.data(), layer.rowStart.data(),
+                        layer.biases.data(), current, next, layer.neurons);
+        } else {
+            denseLayer(layer.weights.data(), layer.biases.data(), current,
+                       next, layer.inputs, layer.neurons);
+        }
+        applyActivation(activations[l], next, layer.neurons);
 
-        for (size_t n = 0; n < numNeurons; ++n) {
-            double sum = layer.biases[n];
+        current = next;
+        next = (next == scratchA.data()) ? scratchB.data() : scratchA.data();
+    }
 
-            for (size_t p = 0; p < numPrevLayerNeurons; ++p) {
-                sum += currentOutputs[p] * layer.weights[n][p];
-            }
-            
-            nextOutputs[n] = activation(sum);
+    return current;
+}
+
+const double* NeuralNetwork::feedForwardBatch(const double* inputs, size_t batch) {
+    if (batch == 1) return feedForward(inputs);
+
+    size_t widest = scratchA.size() / std::max<size_t>(1, scratchBatch);
+    if (batch > scratchBatch) {
+        scratchBatch = batch;
+        scratchA.resize(widest * batch);
+        scratchB.resize(widest * batch);
+    }
+
+    if (!packedCurrent) packLayers();
+
+    const double* current = inputs;
+    double* next = scratchA.data();
+
+    for (size_t l = 0; l < layers.size(); ++l) {
+        const Layer& layer = layers[l];
+        if (layer.sparse) {
+            sparseLayerBatch(layer.sparseValues.data(), layer.sparseColumns.data(), layer.rowStart.data(),
+                             layer.biases.data(), current, next, layer.inputs, layer.neurons, batch);
+        } else {
+            denseLayerBatch(layer.packed.data(), layer.biases.data(), current,
+                            next, layer.inputs, layer.neurons, batch);
         }
-        
-        currentOutputs = nextOutputs;
+        applyActivation(activations[l], next, layer.neurons * batch);
+
+        current = next;
+        next = (next == scratchA.data()) ? scratchB.data() : scratchA.data();
     }
 
-    return currentOutputs;
+    return current;
 }
 
 std::vector<double> NeuralNetwork::getGenes() const {
@@ -66,51 +136,103 @@ std::vector<double> NeuralNetwork::getGenes() const {
     
     for (const auto& layer : layers) {
         genes.insert(genes.end(), layer.biases.begin(), layer.biases.end());
-        for (const auto& neuronWeights : layer.weights) {
-            genes.insert(genes.end(), neuronWeights.begin(), neuronWeights.end());
+        for (size_t n = 0; n < layer.neurons; ++n) {
+            for (size_t p = 0; p < layer.inputs; ++p) {
+                genes.push_back(layer.weights[p * layer.neurons + n]);
+            }
         }
     }
     return genes;
 }
 
 void NeuralNetwork::setGenes(const std::vector<double>& genes) {
+    setGenes(genes.data(), genes.size());
+}
+
+void NeuralNetwork::setGenes(const double* genes, size_t count) {
     size_t geneIndex = 0; 
     
     for (auto& layer : this->layers) {
         // set biases
         for (double& bias : layer.biases) {
-            if (geneIndex >= genes.size()) throw std::out_of_range("Gene vector is too small.");
+            if (geneIndex >= count) throw std::out_of_range("Gene vector is too small.");
             bias = genes[geneIndex++];
         }
-        // set weights
-        for (auto& neuronWeights : layer.weights) {
-            for (double& weight : neuronWeights) {
-                if (geneIndex >= genes.size()) throw std::out_of_range("Gene vector is too small.");
-                weight = genes[geneIndex++];
+        // set weights, collecting the nonzero ones row by row
+        size_t nonzero = 0;
+        for (size_t n = 0; n < layer.neurons; ++n) {
+            layer.rowStart[n] = (uint32_t)nonzero;
+            for (size_t p = 0; p < layer.inputs; ++p) {
+                if (geneIndex >= count) throw std::out_of_range("Gene vector is too small.");
+                double weight = genes[geneIndex++];
+                layer.weights[p * layer.neurons + n] = weight;
+                if (weight != 0.0) {
+                    layer.sparseValues[nonzero] = weight;
+                    layer.sparseColumns[nonzero] = (uint32_t)p;
+                    ++nonzero;
+                }
             }
         }
+        layer.rowStart[layer.neurons] = (uint32_t)nonzero;
+        layer.nonzero = nonzero;
     }
 
-    if (geneIndex != genes.size()) {
+    if (geneIndex != count) {
         throw std::runtime_error("Gene vector size did not match the network's structure.");
     }
+    packedCurrent = false;
+    chooseLayerFormats();
 }
 
-// private methods
-void NeuralNetwork::setActivation(ActivationType funcType) {
-    switch (funcType) {
-        case ActivationType::SIGMOID:
-            activation = sigmoid;
-            break;
-        case ActivationType::RELU:
-            activation = relu;
-            break;
-        case ActivationType::TANH:
-            activation = tanh;
-            break;
+void NeuralNetwork::packLayers() {
+    for (Layer& layer : layers) {
+        for (size_t p = 0; p < layer.inputs; ++p) {
+            const double* row = layer.weights.data() + p * layer.neurons;
+            for (size_t n = 0; n < layer.neurons; ++n) {
+                layer.packed[packedWeightIndex(p, n, layer.inputs, layer.neurons)] = row[n];
+            }
+        }
     }
+    packedCurrent = true;
 }
 
+void NeuralNetwork::setSparseDensity(double density) {
+    sparseDensity = density;
+    chooseLayerFormats();
+}
+
+void NeuralNetwork::chooseLayerFormats() {
+    for (Layer& layer : layers) {
+        layer.sparse = (double)layer.nonzero <= sparseDensity * (double)layer.weights.size();
+    }
+}
+
+double NeuralNetwork::getWeightDensity() const {
+    size_t nonzero = 0, total = 0;
+    for (const Layer& layer : layers) {
+        nonzero += layer.nonzero;
+        total += layer.weights.size();
+    }
+    return total > 0 ? (double)nonzero / (double)total : 1.0;
+}
+
+size_t NeuralNetwork::getSparseLayerCount() const {
+    size_t count = 0;
+    for (const Layer& layer : layers) {
+        if (layer.sparse) ++count;
+    }
+    return count;
+}
+
+size_t NeuralNetwork::geneCountFor(const std::vector<size_t>& topology) {
+    size_t count = 0;
+    for (size_t i = 1; i < topology.size(); ++i) {
+        count += topology[i] + topology[i] * topology[i - 1];
+    }
+    return count;
+}
+
+// private methods
 double NeuralNetwork::getRandomDouble() {
     std::uniform_real_distribution<double> dist(-1.0, 1.0);
     return dist(randomEngine);
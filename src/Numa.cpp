@@ -0,0 +1,102 @@
+#include "Numa.hpp"
+#include <fstream>
+#include <sstream>
+#include <algorithm>
+#include <thread>
+#if defined(__linux__)
+#include <sched.h>
+#include <pthread.h>
+#endif
+
+// "0-3,8,10-11" -> {0, 1, 2, 3, 8, 10, 11}
+static std::vector<int> parseCpuList(const std::string& text) {
+    std::vector<int> cpus;
+    std::stringstream stream(text);
+    std::string range;
+    while (std::getline(stream, range, ',')) {
+        if (range.empty() || range == "\n") continue;
+        size_t dash = range.find('-');
+        int first = std::stoi(range.substr(0, dash));
+        int last = dash == std::string::npos ? first : std::stoi(range.substr(dash + 1));
+        for (int cpu = first; cpu <= last; ++cpu) cpus.push_back(cpu);
+    }
+    return cpus;
+}
+
+static std::vector<int> allowedCpus() {
+    std::vector<int> cpus;
+#if defined(__linux__)
+    cpu_set_t set;
+    CPU_ZERO(&set);
+    if (sched_getaffinity(0, sizeof(set), &set) == 0) {
+        for (int cpu = 0; cpu < CPU_SETSIZE; ++cpu) {
+            if (CPU_ISSET(cpu, &set)) cpus.push_back(cpu);
+        }
+    }
+#endif
+    if (cpus.empty()) {
+        // no affinity API: number the hardware threads
+        unsigned count = std::max(1u, std::thread::hardware_concurrency());
+        for (unsigned cpu = 0; cpu < count; ++cpu) cpus.push_back((int)cpu);
+    }
+    return cpus;
+}
+
+size_t NumaTopology::cpuCount() const {
+    size_t count = 0;
+    for (const std::vector<int>& cpus : nodeCpus) count += cpus.size();
+    return count;
+}
+
+NumaTopology NumaTopology::singleNode() {
+    NumaTopology topology;
+    topology.nodeCpus.push_back(allowedCpus());
+    return topology;
+}
+
+NumaTopology NumaTopology::detect() {
+    std::vector<int> allowed = allowedCpus();
+    NumaTopology topology;
+
+    std::ifstream online("/sys/devices/system/node/online");
+    std::string nodes;
+    if (online && std::getline(online, nodes)) {
+        for (int node : parseCpuList(nodes)) {
+            std::ifstream list("/sys/devices/system/node/node" + std::to_string(node) + "/cpulist");
+            std::string text;
+            if (!list || !std::getline(list, text)) continue;
+
+            std::vector<int> cpus;
+            for (int cpu : parseCpuList(text)) {
+                if (std::find(allowed.begin(), allowed.end(), cpu) != allowed.end()) cpus.push_back(cpu);
+            }
+            if (!cpus.empty()) topology.nodeCpus.push_back(cpus);
+        }
+    }
+
+    if (topology.nodeCpus.empty()) return singleNode();
+    return topology;
+}
+
+std::string NumaTopology::describe() const {
+    std::stringstream text;
+    text << nodeCount() << (nodeCount() == 1 ? " node (" : " nodes (");
+    for (size_t n = 0; n < nodeCpus.size(); ++n) {
+        if (n > 0) text << ", ";
+        text << nodeCpus[n].size() << " cpus";
+    }
+    text << ")";
+    return text.str();
+}
+
+bool pinCurrentThread(int cpu) {
+#if defined(__linux__)
+    cpu_set_t set;
+    CPU_ZERO(&set);
+    CPU_SET(cpu, &set);
+    return pthread_setaffinity_np(pthread_self(), sizeof(set), &set) == 0;
+#else
+    (void)cpu;
+    return false;
+#endif
+}
@@ -0,0 +1,73 @@
+#include "Occupancy.hpp"
+#include <cstring>
+
+OccupancyGrid::OccupancyGrid() {
+    clear();
+}
+
+void OccupancyGrid::clear() {
+    std::memset(rows, 0, sizeof(rows));
+    std::memset(cols, 0, sizeof(cols));
+    std::memset(diagonals, 0, sizeof(diagonals));
+    std::memset(antiDiagonals, 0, sizeof(antiDiagonals));
+    std::memset(counts, 0, sizeof(counts));
+}
+
+void OccupancyGrid::add(Point p) {
+    if (!inside(p)) return;
+    if (counts[p.y * MAX_SIZE + p.x]++ == 0) setBits(p, true);
+}
+
+void OccupancyGrid::remove(Point p) {
+    if (!inside(p)) return;
+    if (--counts[p.y * MAX_SIZE + p.x] == 0) setBits(p, false);
+}
+
+bool OccupancyGrid::occupied(Point p) const {
+    return inside(p) && counts[p.y * MAX_SIZE + p.x] > 0;
+}
+
+void OccupancyGrid::setBits(Point p, bool value) {
+    uint64_t xBit = 1ull << p.x;
+    uint64_t yBit = 1ull << p.y;
+    if (value) {
+        rows[p.y] |= xBit;
+        cols[p.x] |= yBit;
+        diagonals[p.x - p.y + MAX_SIZE - 1] |= xBit;
+        antiDiagonals[p.x + p.y] |= xBit;
+    } else {
+        rows[p.y] &= ~xBit;
+        cols[p.x] &= ~yBit;
+        diagonals[p.x - p.y + MAX_SIZE - 1] &= ~xBit;
+        antiDiagonals[p.x + p.y] &= ~xBit;
+    }
+}
+
+// nearest set bit above / below `position`, as a distance; 0 if none
+static int scanUp(uint64_t bits, int position) {
+    if (position >= 63) return 0;
+    bits &= ~0ull << (position + 1);
+    return bits ? __builtin_ctzll(bits) - position : 0;
+}
+
+static int scanDown(uint64_t bits, int position) {
+    if (position <= 0) return 0;
+    bits &= (1ull << position) - 1;
+    return bits ? position - (63 - __builtin_clzll(bits)) : 0;
+}
+
+int OccupancyGrid::distanceTo(Point from, int dx, int dy) const {
+    if (!inside(from)) return 0;
+
+    if (dy == 0) {
+        // along the row, indexed by x
+        return dx > 0 ? scanUp(rows[from.y], from.x) : scanDown(rows[from.y], from.x);
+    }
+    if (dx == 0) {
+        // along the column, indexed by y
+        return dy > 0 ? scanUp(cols[from.x], from.y) : scanDown(cols[from.x], from.y);
+    }
+    // the diagonals are indexed by x, so only the sign of dx matters
+    uint64_t line = dx == dy ? diagonals[from.x - from.y + MAX_SIZE - 1] : antiDiagonals[from.x + from.y];
+    return dx > 0 ? scanUp(line, from.x) : scanDown(line, from.x);
+}
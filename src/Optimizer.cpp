@@ -0,0 +1,36 @@
+#include "Optimizer.hpp"
+#include "GeneticOptimizer.hpp"
+#include "EvolutionStrategy.hpp"
+#include "SeparableCMAES.hpp"
+
+std::unique_ptr<Optimizer> createOptimizer(OptimizerType type) {
+    switch (type) {
+        case OptimizerType::EvolutionStrategy:
+            return std::make_unique<EvolutionStrategy>();
+        case OptimizerType::SeparableCMAES:
+            return std::make_unique<SeparableCMAES>();
+        case OptimizerType::Genetic:
+        default:
+            return std::make_unique<GeneticOptimizer>();
+    }
+}
+
+const char* optimizerName(OptimizerType type) {
+    switch (type) {
+        case OptimizerType::EvolutionStrategy: return "es";
+        case OptimizerType::SeparableCMAES: return "cmaes";
+        case OptimizerType::Genetic:
+        default: return "ga";
+    }
+}
+
+bool parseOptimizerType(const std::string& name, OptimizerType& type) {
+    for (OptimizerType candidate : { OptimizerType::Genetic, OptimizerType::EvolutionStrategy,
+                                     OptimizerType::SeparableCMAES }) {
+        if (name == optimizerName(candidate)) {
+            type = candidate;
+            return true;
+        }
+    }
+    return false;
+}
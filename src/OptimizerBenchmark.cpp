@@ -0,0 +1,98 @@
+#include "OptimizerBenchmark.hpp"
+#include "TrainingRun.hpp"
+#include <iostream>
+#include <fstream>
+#include <thread>
+#include <algorithm>
+
+struct BenchmarkRun {
+    OptimizerType optimizer;
+    size_t repeat;
+    bool reached = false;
+    size_t evaluations = 0;
+    size_t generations = 0;
+    int bestScore = 0;
+    double seconds = 0.0;
+};
+
+static void trainUntilTarget(const BenchmarkOptions& options, const std::vector<size_t>& topology,
+                             ThreadPool& pool, BenchmarkRun& run) {
+    TrainingRun training(options.populationSize, topology, EvalConfig{}, pool, run.optimizer);
+
+    while (run.evaluations < options.maxEvaluations) {
+        GenerationReport report = training.step();
+        run.generations++;
+        run.evaluations += report.evaluations;
+        run.seconds += report.seconds;
+        run.bestScore = std::max(run.bestScore, report.bestScore);
+        if (report.bestScore >= options.targetScore) {
+            run.reached = true;
+            break;
+        }
+    }
+
+    std::cout << "Benchmark: " << optimizerName(run.optimizer) << " #" << run.repeat
+              << (run.reached ? " reached " : " missed ") << "score " << options.targetScore
+              << " after " << run.evaluations << " evaluations" << std::endl;
+}
+
+int runOptimizerBenchmark(const BenchmarkOptions& options) {
+    std::vector<size_t> topology = { options.inputNodes };
+    topology.insert(topology.end(), options.hiddenLayers.begin(), options.hiddenLayers.end());
+    topology.push_back(OUTPUT_NODES);
+
+    std::vector<BenchmarkRun> runs;
+    for (OptimizerType optimizer : options.optimizers) {
+        for (size_t repeat = 0; repeat < options.repeats; ++repeat) {
+            BenchmarkRun run;
+            run.optimizer = optimizer;
+            run.repeat = repeat;
+            runs.push_back(run);
+        }
+    }
+    if (runs.empty()) {
+        std::cerr << "Benchmark: nothing to run" << std::endl;
+        return 1;
+    }
+
+    // same setup as the sweep: one driver thread per run, one shared pool
+    ThreadPool pool(options.threads);
+    std::vector<std::thread> drivers;
+    for (BenchmarkRun& run : runs) {
+        drivers.emplace_back(trainUntilTarget, std::cref(options), std::cref(topology),
+                             std::ref(pool), std::ref(run));
+    }
+    for (auto& driver : drivers) {
+        driver.join();
+    }
+
+    std::ofstream out(options.outputPath);
+    if (!out) {
+        std::cerr << "Benchmark: cannot write " << options.outputPath << std::endl;
+        return 1;
+    }
+    out << "optimizer,repeat,reached,evaluations,generations,best_score,seconds\n";
+    for (const BenchmarkRun& run : runs) {
+        out << optimizerName(run.optimizer) << "," << run.repeat << "," << (run.reached ? 1 : 0) << ","
+            << run.evaluations << "," << run.generations << "," << run.bestScore << "," << run.seconds << "\n";
+    }
+
+    // runs that missed count as the budget, so the median stays an upper bound
+    std::cout << "Evaluations to score " << options.targetScore << " (median of " << options.repeats << "):" << std::endl;
+    for (OptimizerType optimizer : options.optimizers) {
+        std::vector<size_t> evaluations;
+        size_t reached = 0;
+        for (const BenchmarkRun& run : runs) {
+            if (run.optimizer != optimizer) continue;
+            evaluations.push_back(run.reached ? run.evaluations : options.maxEvaluations);
+            if (run.reached) reached++;
+        }
+        std::sort(evaluations.begin(), evaluations.end());
+        std::cout << "  " << optimizerName(optimizer) << ": "
+                  << (evaluations.empty() ? 0 : evaluations[evaluations.size() / 2])
+                  << " (" << reached << "/" << evaluations.size() << " reached)" << std::endl;
+    }
+
+    std::cout << "Benchmark: results written to " << options.outputPath << std::endl;
+    return 0;
+}
@@ -1,46 +1,161 @@
 #include "Population.hpp"
+#include "Random.hpp"
+#include "Trace.hpp"
 #include <random>
 #include <algorithm>
 #include <iostream>
+#include <stdexcept>
 
 static std::mt19937 ga_randomEngine(std::random_device{}());
 
-Population::Population(size_t popSize, const std::vector<size_t>& topology) 
-    : topology(topology), generation(0), bestFitness(0.0) {
-    
-    reset(popSize, topology);
+// keeps the streams of morphed-in genes apart from the initial ones
+const uint64_t MORPH_SEED_SALT = 0x3011F5EEDull;
+
+Population::Population(size_t popSize, const std::vector<size_t>& topology, ThreadPool& pool,
+                       OptimizerType optimizerType, const NetworkActivations& activations, GenePrecision precision,
+                       uint64_t seed)
+    : pool(pool), optimizerType(optimizerType), optimizer(createOptimizer(optimizerType)), activations(activations),
+      precision(precision),
+      topology(topology), popSize(0), geneCount(0), generation(0), bestFitness(0.0),
+      mutationRate(0.05), mutationStrength(0.2) {
+
+    reset(popSize, topology, seed);
 }
 
-void Population::reset(size_t popSize, const std::vector<size_t>& newTopology) {
+void Population::reset(size_t popSize, const std::vector<size_t>& newTopology, uint64_t newSeed) {
+    // evolve() and summarize() read the best row, so there must be one
+    if (popSize < 1) {
+        throw std::invalid_argument("A population needs at least one individual.");
+    }
     this->topology = newTopology;
+    this->popSize = popSize;
+    this->geneCount = NeuralNetwork::geneCountFor(newTopology);
     this->generation = 0;
     this->bestFitness = 0.0;
+    this->seed = newSeed != 0 ? newSeed : ((uint64_t)ga_randomEngine() << 32) | ga_randomEngine();
+
+    // left uninitialized: the parallel fill below and the optimizer's
+    // evolve() write every row from the worker whose shard holds it
+    genes.allocate(popSize, geneCount, precision);
+    offspring.allocate(popSize, geneCount, precision);
+    fitness.assign(popSize, 0.0);
+
+    // same U(-1, 1) initialization as a freshly constructed NeuralNetwork
+    pool.parallelFor(popSize, 0, [this](size_t begin, size_t end, size_t) {
+        std::vector<double> scratch(precision == GenePrecision::Double ? 0 : geneCount);
+        for (size_t i = begin; i < end; ++i) {
+            double* row = genes.writeBuffer(i, scratch.data());
+            fillUniform(streamKey(seed, 0, i), 0, row, geneCount, -1.0, 1.0);
+            genes.commit(i, row);
+        }
+    });
+    optimizer->reset(genes, popSize, geneCount, seed, pool);
+
+    std::cout << "Population Reset! Topology: { ";
+    for(auto n : newTopology) std::cout << n << " ";
+    std::cout << "} Optimizer: " << optimizer->getName();
+    if (precision != GenePrecision::Double) std::cout << " Genes: " << genePrecisionName(precision);
+    std::cout << std::endl;
+}
 
-    population.clear();
-    fitness.clear();
+void Population::morph(const Morph& morph) {
+    std::vector<size_t> newTopology = morphedTopology(topology, morph);
+    size_t newGeneCount = NeuralNetwork::geneCountFor(newTopology);
+
+    // the rows are rewritten into the back buffer, which is then swapped in
+    offspring.allocate(popSize, newGeneCount, precision);
+    pool.parallelFor(popSize, 0, [&](size_t begin, size_t end, size_t) {
+        std::vector<double> source(geneCount);
+        std::vector<double> scratch(precision == GenePrecision::Double ? 0 : newGeneCount);
+        for (size_t i = begin; i < end; ++i) {
+            double* row = offspring.writeBuffer(i, scratch.data());
+            // added neurons draw their incoming weights from their own streams
+            applyMorph(topology, morph, genes.read(i, source.data()), row,
+                       streamKey(seed ^ MORPH_SEED_SALT, generation, i));
+            offspring.commit(i, row);
+        }
+    });
+    genes.swap(offspring);
+    offspring.allocate(popSize, newGeneCount, precision);
 
-    population.reserve(popSize);
-    fitness.resize(popSize, 0.0);
+    topology = newTopology;
+    geneCount = newGeneCount;
+    std::fill(fitness.begin(), fitness.end(), 0.0);
+    optimizer->morph(genes, geneCount, generation, pool);
 
+    std::cout << "Population Morphed! Topology: { ";
+    for (auto n : topology) std::cout << n << " ";
+    std::cout << "} Generation: " << generation << std::endl;
+}
+
+size_t Population::findWeakestNeuron(size_t layer) const {
+    std::vector<double> totals(topology.at(layer), 0.0);
+    std::vector<double> scratch(geneCount);
     for (size_t i = 0; i < popSize; ++i) {
-        population.emplace_back(newTopology, ActivationType::RELU);
+        const double* row = genes.read(i, scratch.data());
+        for (size_t n = 0; n < totals.size(); ++n) {
+            totals[n] += neuronContribution(topology, layer, n, row);
+        }
     }
-    
-    std::cout << "Population Reset! Topology: { ";
-    for(auto n : newTopology) std::cout << n << " ";
-    std::cout << "}" << std::endl;
+    return (size_t)(std::min_element(totals.begin(), totals.end()) - totals.begin());
 }
 
 double Population::getAverageFitness() const {
+    return summarize().average;
+}
+
+FitnessStats Population::summarize() const {
+    // one partial per worker; a worker runs its chunks one after another
+    struct Partial {
+        double total = 0.0;
+        double best = -1.0;
+        size_t bestIndex = 0;
+    };
+    std::vector<Partial> partials(pool.size());
+
+    pool.parallelFor(popSize, 0, [this, &partials](size_t begin, size_t end, size_t worker) {
+        Partial& partial = partials[worker];
+        for (size_t i = begin; i < end; ++i) {
+            partial.total += fitness[i];
+            // ties go to the lowest index, as std::max_element would
+            if (fitness[i] > partial.best || (fitness[i] == partial.best && i < partial.bestIndex)) {
+                partial.best = fitness[i];
+                partial.bestIndex = i;
+            }
+        }
+    });
+
+    FitnessStats stats = { fitness[0], 0.0, 0 };
     double totalFitness = 0.0;
-    for (double fit : fitness) {
-        totalFitness += fit;
+    for (const Partial& partial : partials) {
+        totalFitness += partial.total;
+        if (partial.best > stats.best || (partial.best == stats.best && partial.bestIndex < stats.bestIndex)) {
+            stats.best = partial.best;
+            stats.bestIndex = partial.bestIndex;
+        }
     }
-    return totalFitness / population.size();
+    stats.average = totalFitness / popSize;
+    return stats;
+}
+
+NeuralNetwork Population::getBrain(size_t index) const {
+    NeuralNetwork brain(topology, activations);
+    std::vector<double> scratch(geneCount);
+    brain.setGenes(genes.read(index, scratch.data()), geneCount);
+    return brain;
+}
+
+std::vector<double> Population::getGenes(size_t index) const {
+    std::vector<double> row(geneCount);
+    const double* source = genes.read(index, row.data());
+    if (source != row.data()) std::copy(source, source + geneCount, row.begin());
+    return row;
 }
 
-NeuralNetwork& Population::getBrain(size_t index) {
-    return population[index];
+void Population::setMutation(double rate, double strength) {
+    mutationRate = rate;
+    mutationStrength = strength;
+    optimizer->setMutation(rate, strength);
 }
 
 void Population::setFitness(size_t index, double score) {
@@ -48,78 +163,13 @@ void Population::setFitness(size_t index, double score) {
 }
 
 void Population::evolve() {
-    auto bestIt = std::max_element(fitness.begin(), fitness.end());
-    bestFitness = *bestIt;
-    size_t bestBrainIndex = std::distance(fitness.begin(), bestIt);
-
-    std::vector<NeuralNetwork> newGeneration;
-    newGeneration.reserve(population.size());
-
-    std::vector<double> championGenes = population[bestBrainIndex].getGenes();
-    NeuralNetwork champion(topology, ActivationType::RELU);
-    champion.setGenes(championGenes);
-    newGeneration.push_back(champion);
-
-    for (size_t i = 1; i < population.size(); ++i) {
-        NeuralNetwork& parentA = selectParent();
-        NeuralNetwork& parentB = selectParent();
-        NeuralNetwork child = crossover(parentA, parentB);
-        mutate(child);
-        newGeneration.push_back(child);
-    }
+    TRACE_ZONE("Population::evolve");
+    FitnessStats stats = summarize();
+    bestFitness = stats.best;
+
+    optimizer->evolve(genes, fitness.data(), stats, generation, offspring, pool);
 
-    population = newGeneration;
+    genes.swap(offspring);
     std::fill(fitness.begin(), fitness.end(), 0.0);
     generation++;
 }
-
-NeuralNetwork& Population::selectParent() {
-    const int TOURNAMENT_SIZE = 5; 
-    NeuralNetwork* winner = nullptr;
-    double best_fit = -1.0;
-    std::uniform_int_distribution<size_t> dist(0, population.size() - 1);
-
-    for (int i = 0; i < TOURNAMENT_SIZE; ++i) {
-        size_t index = dist(ga_randomEngine);
-        if (fitness[index] > best_fit) {
-            best_fit = fitness[index];
-            winner = &population[index];
-        }
-    }
-    return *winner;
-}
-
-NeuralNetwork Population::crossover(NeuralNetwork& parentA, NeuralNetwork& parentB) {
-    std::vector<double> genesA = parentA.getGenes();
-    std::vector<double> genesB = parentB.getGenes();
-    size_t geneCount = genesA.size();
-    std::vector<double> childGenes;
-    childGenes.reserve(geneCount);
-    std::uniform_real_distribution<double> coinFlip(0.0, 1.0);
-
-    for (size_t i = 0; i < geneCount; ++i) {
-        if (coinFlip(ga_randomEngine) < 0.5) childGenes.push_back(genesA[i]);
-        else childGenes.push_back(genesB[i]);
-    }
-    
-    NeuralNetwork child(topology, ActivationType::RELU);
-    child.setGenes(childGenes);
-    return child;
-}
-
-void Population::mutate(NeuralNetwork& brain) {
-    const double MUTATION_RATE = 0.05; 
-    const double MUTATION_STRENGTH = 0.2; 
-    std::vector<double> genes = brain.getGenes();
-    std::uniform_real_distribution<double> rateDist(0.0, 1.0);
-    std::normal_distribution<double> amountDist(0.0, MUTATION_STRENGTH);
-
-    for (double& gene : genes) {
-        if (rateDist(ga_randomEngine) < MUTATION_RATE) {
-            gene += amountDist(ga_randomEngine);
-            if (gene > 1.0) gene = 1.0;
-            if (gene < -1.0) gene = -1.0;
-        }
-    }
-    brain.setGenes(genes);
-}
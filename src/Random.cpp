@@ -0,0 +1,54 @@
+#include "Random.hpp"
+#include "Kernels.hpp"
+#include <cmath>
+
+SNAKE_DISPATCH
+void fillUniform(uint64_t key, uint64_t counter, double* out, size_t count, double lo, double hi) {
+    const double scale = (hi - lo) * 0x1.0p-53;
+    for (size_t i = 0; i < count; ++i) {
+        uint64_t word = counterRandom(key, counter + i);
+        out[i] = lo + (double)(word >> 11) * scale;
+    }
+}
+
+SNAKE_DISPATCH
+void fillCoinMasks(uint64_t key, uint64_t counter, uint64_t* masks, size_t count) {
+    for (size_t block = 0; block * RANDOM_BLOCK < count; ++block) {
+        uint64_t word = counterRandom(key, counter + block);
+        size_t begin = block * RANDOM_BLOCK;
+        size_t lanes = count - begin < RANDOM_BLOCK ? count - begin : RANDOM_BLOCK;
+        for (size_t j = 0; j < lanes; ++j) {
+            masks[begin + j] = 0 - ((word >> j) & 1);
+        }
+    }
+}
+
+SNAKE_DISPATCH
+void fillMutationNoise(uint64_t key, uint64_t counter, double* noise, size_t count,
+                       double rate, double strength) {
+    // top 16 bits gate the mutation, the low 48 bits feed four 12-bit uniforms
+    const uint32_t threshold = (uint32_t)(rate * 65536.0);
+    const double scale = strength * std::sqrt(3.0) / 4096.0;
+
+    for (size_t i = 0; i < count; ++i) {
+        uint64_t word = counterRandom(key, counter + i);
+        uint32_t gate = (uint32_t)(word >> 48) < threshold;
+        int32_t sum = (int32_t)(word & 0xFFF) + (int32_t)((word >> 12) & 0xFFF)
+                    + (int32_t)((word >> 24) & 0xFFF) + (int32_t)((word >> 36) & 0xFFF);
+        // four uniforms of mean 2047.5 each, centered on zero
+        double gaussian = ((double)sum - 8190.0) * scale;
+        noise[i] = gaussian * (double)gate;
+    }
+}
+
+SNAKE_DISPATCH
+void fillGaussian(uint64_t key, uint64_t counter, double* out, size_t count, double sigma) {
+    const double scale = sigma * std::sqrt(3.0) / 65536.0;
+    for (size_t i = 0; i < count; ++i) {
+        uint64_t word = counterRandom(key, counter + i);
+        int64_t sum = (int64_t)(word & 0xFFFF) + (int64_t)((word >> 16) & 0xFFFF)
+                    + (int64_t)((word >> 32) & 0xFFFF) + (int64_t)(word >> 48);
+        // four uniforms of mean 32767.5 each, centered on zero
+        out[i] = ((double)sum - 131070.0) * scale;
+    }
+}
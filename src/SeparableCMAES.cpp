@@ -0,0 +1,141 @@
+#include "SeparableCMAES.hpp"
+#include "Random.hpp"
+#include <algorithm>
+#include <cmath>
+
+SeparableCMAES::SeparableCMAES()
+    : popSize(0), geneCount(0), seed(0), initialSigma(0.2), lambda(0), mu(0), muEff(0.0),
+      cSigma(0.0), dSigma(0.0), cC(0.0), c1(0.0), cMu(0.0), chiN(0.0), sigma(0.2), updates(0) {}
+
+void SeparableCMAES::setMutation(double, double strength) {
+    initialSigma = strength;
+    sigma = strength;
+}
+
+void SeparableCMAES::reset(GeneStore& genes, size_t popSize, size_t geneCount, uint64_t seed, ThreadPool& pool) {
+    this->popSize = popSize;
+    // generation 0 of the plain seed already produced the initial genes
+    this->seed = mixBits(seed ^ 0x5EED5EED5EED5EEDull);
+    sigma = initialSigma;
+    restart(genes, geneCount, 0, pool);
+}
+
+void SeparableCMAES::morph(GeneStore& genes, size_t geneCount, size_t generation, ThreadPool& pool) {
+    // keeps the adapted step size; the covariance and paths of the old
+    // genes start over
+    restart(genes, geneCount, generation, pool);
+}
+
+void SeparableCMAES::restart(GeneStore& genes, size_t geneCount, size_t generation, ThreadPool& pool) {
+    this->geneCount = geneCount;
+
+    // default parameters from Hansen's tutorial, with the learning rates of
+    // the covariance scaled by (n + 2) / 3 as in the separable variant
+    double n = (double)geneCount;
+    lambda = popSize > 1 ? popSize - 1 : 1;
+    mu = std::max<size_t>(1, lambda / 2);
+    weights.resize(mu);
+    double weightSum = 0.0;
+    for (size_t i = 0; i < mu; ++i) {
+        weights[i] = std::log((double)mu + 0.5) - std::log((double)i + 1.0);
+        weightSum += weights[i];
+    }
+    double squareSum = 0.0;
+    for (double& w : weights) {
+        w /= weightSum;
+        squareSum += w * w;
+    }
+    muEff = 1.0 / squareSum;
+
+    cSigma = (muEff + 2.0) / (n + muEff + 5.0);
+    dSigma = 1.0 + 2.0 * std::max(0.0, std::sqrt((muEff - 1.0) / (n + 1.0)) - 1.0) + cSigma;
+    cC = (4.0 + muEff / n) / (n + 4.0 + 2.0 * muEff / n);
+    double separable = (n + 2.0) / 3.0;
+    c1 = std::min(1.0, separable * 2.0 / ((n + 1.3) * (n + 1.3) + muEff));
+    cMu = std::min(1.0 - c1, separable * 2.0 * (muEff - 2.0 + 1.0 / muEff) / ((n + 2.0) * (n + 2.0) + muEff));
+    chiN = std::sqrt(n) * (1.0 - 1.0 / (4.0 * n) + 1.0 / (21.0 * n * n));
+
+    scratch.assign(pool.size() * geneCount, 0.0);
+    const double* first = genes.read(0, scratch.data());
+    mean.assign(first, first + geneCount);
+    pathSigma.assign(geneCount, 0.0);
+    pathC.assign(geneCount, 0.0);
+    variance.assign(geneCount, 1.0);
+    deviation.assign(geneCount, 1.0);
+    updates = 0;
+
+    writeCandidates(genes, generation, pool);
+}
+
+void SeparableCMAES::writeCandidates(GeneStore& rows, size_t generation, ThreadPool& pool) {
+    rows.commit(0, mean.data());
+
+    pool.parallelFor(popSize - 1, 0, [&](size_t begin, size_t end, size_t worker) {
+        for (size_t r = begin + 1; r < end + 1; ++r) {
+            double* row = rows.writeBuffer(r, scratch.data() + worker * geneCount);
+            fillGaussian(streamKey(seed, generation, r), 0, row, geneCount, 1.0);
+            for (size_t j = 0; j < geneCount; ++j) {
+                row[j] = mean[j] + sigma * deviation[j] * row[j];
+            }
+            rows.commit(r, row);
+        }
+    });
+}
+
+void SeparableCMAES::evolve(const GeneStore&, const double* fitness, const FitnessStats&,
+                            size_t generation, GeneStore& next, ThreadPool& pool) {
+    if (popSize < 2) {
+        writeCandidates(next, generation + 1, pool);
+        return;
+    }
+
+    order.resize(lambda);
+    for (size_t i = 0; i < lambda; ++i) order[i] = i + 1;
+    std::stable_sort(order.begin(), order.end(), [fitness](size_t a, size_t b) {
+        return fitness[a] > fitness[b];
+    });
+
+    // recombine the mu best z vectors, replaying them from their streams
+    zMean.assign(geneCount, 0.0);
+    rankMu.assign(geneCount, 0.0);
+    pool.parallelFor(geneCount, 0, [&](size_t begin, size_t end, size_t) {
+        double z[RANDOM_BLOCK];
+        for (size_t block = begin; block < end; block += RANDOM_BLOCK) {
+            size_t lanes = std::min(RANDOM_BLOCK, end - block);
+            for (size_t i = 0; i < mu; ++i) {
+                fillGaussian(streamKey(seed, generation, order[i]), block, z, lanes, 1.0);
+                for (size_t j = 0; j < lanes; ++j) {
+                    double y = deviation[block + j] * z[j];
+                    zMean[block + j] += weights[i] * z[j];
+                    rankMu[block + j] += weights[i] * y * y;
+                }
+            }
+        }
+    });
+
+    updates++;
+    double sigmaFactor = std::sqrt(cSigma * (2.0 - cSigma) * muEff);
+    double normSquared = 0.0;
+    for (size_t j = 0; j < geneCount; ++j) {
+        pathSigma[j] = (1.0 - cSigma) * pathSigma[j] + sigmaFactor * zMean[j];
+        normSquared += pathSigma[j] * pathSigma[j];
+    }
+    double norm = std::sqrt(normSquared);
+    double decay = 1.0 - std::pow(1.0 - cSigma, 2.0 * (double)updates);
+    bool stalled = norm / std::sqrt(decay) >= (1.4 + 2.0 / ((double)geneCount + 1.0)) * chiN;
+    double hSigma = stalled ? 0.0 : 1.0;
+
+    double cFactor = std::sqrt(cC * (2.0 - cC) * muEff);
+    for (size_t j = 0; j < geneCount; ++j) {
+        double yMean = deviation[j] * zMean[j];
+        mean[j] += sigma * yMean;
+        pathC[j] = (1.0 - cC) * pathC[j] + hSigma * cFactor * yMean;
+        variance[j] = (1.0 - c1 - cMu) * variance[j]
+                    + c1 * (pathC[j] * pathC[j] + (1.0 - hSigma) * cC * (2.0 - cC) * variance[j])
+                    + cMu * rankMu[j];
+        deviation[j] = std::sqrt(variance[j]);
+    }
+    sigma *= std::exp((cSigma / dSigma) * (norm / chiN - 1.0));
+
+    writeCandidates(next, generation + 1, pool);
+}
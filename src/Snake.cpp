@@ -1,14 +1,27 @@
 #include "Snake.hpp"
+#include "Zobrist.hpp"
 #include <SDL2/SDL.h>
 #include <iostream>
 
 const int CELL_SIZE = 20;
 
 Snake::Snake() {
+    reset();
+}
+
+void Snake::reset() {
+    body.clear();
     body.push_front({25, 25});
     body.push_back({24, 25});
     body.push_back({23, 25});
-    
+
+    occupancy.clear();
+    body_hash = 0;
+    for (size_t i = 0; i < body.size(); ++i) {
+        occupancy.add(body[i]);
+        body_hash ^= segment_key(i);
+    }
+
     direction = RIGHT;
 }
 
@@ -32,7 +45,29 @@ void Snake::update() {
     }
 
     body.push_front(newHead);
+    body_hash ^= segment_key(0);
+    occupancy.add(newHead);
+
+    // the tail goes away and the segment before it becomes the new tail end
+    size_t last = body.size() - 1;
+    body_hash ^= segment_key(last) ^ segment_key(last - 1);
+    occupancy.remove(body.back());
     body.pop_back();
+    body_hash ^= segment_key(last - 1);
+}
+
+uint64_t Snake::segment_key(size_t index) const {
+    int link = LINK_TAIL_END;
+    if (index + 1 < body.size()) {
+        Point from = body[index];
+        Point to = body[index + 1];
+        if (to.y < from.y) link = UP;
+        else if (to.y > from.y) link = DOWN;
+        else if (to.x < from.x) link = LEFT;
+        else if (to.x > from.x) link = RIGHT;
+        else link = LINK_SAME_CELL;
+    }
+    return zobristKey(ZOBRIST_SEGMENT, body[index], link);
 }
 
 void Snake::draw(SDL_Renderer *renderer) {
@@ -46,8 +81,8 @@ void Snake::draw(SDL_Renderer *renderer) {
 
     SDL_SetRenderDrawColor(renderer, 255, 255, 255, 255);
     
-    for (auto it = body.begin() + 1; it != body.end(); ++it) {
-        draw_body_part(renderer, *it);
+    for (size_t i = 1; i < body.size(); ++i) {
+        draw_body_part(renderer, body[i]);
     }
 }
 
@@ -76,19 +111,21 @@ bool Snake::hit_itself() {
 }
 
 void Snake::grow() {
+    body_hash ^= segment_key(body.size() - 1);
     body.push_back(body.back());
+    occupancy.add(body.back());
+    body_hash ^= segment_key(body.size() - 2) ^ segment_key(body.size() - 1);
 }
 
 bool Snake::is_point_on_body(Point p, bool skip_tail = false) {
-    auto start = body.begin() + 1;
-    auto end = body.end();
+    size_t end = body.size();
 
     if (skip_tail && body.size() > 1) {
         --end;
     }
 
-    for (auto it = start; it != end; ++it) {
-        if (*it == p) {
+    for (size_t i = 1; i < end; ++i) {
+        if (body[i] == p) {
             return true;
         }
     }
@@ -0,0 +1,145 @@
+#include "snakesim.h"
+#include "World.hpp"
+#include "ThreadPool.hpp"
+#include <functional>
+#include <memory>
+#include <vector>
+
+// cell size the World works in; the ABI only talks about cells
+const int SIM_CELL_SIZE = 20;
+// the snake starts at (23..25, 25), so the board must contain that
+const uint32_t SIM_MIN_SIZE = 26;
+
+struct SimEnvironment {
+    Snake snake;
+    Food food;
+    World world;
+    uint32_t steps_since_food;
+
+    SimEnvironment(int width, int height)
+        : snake(), food(0, 0), world(snake, food, width * SIM_CELL_SIZE, height * SIM_CELL_SIZE),
+          steps_since_food(0) {}
+};
+
+struct snakesim_envs {
+    std::vector<std::unique_ptr<SimEnvironment>> environments;
+    uint32_t observation_size;
+    uint32_t starvation_steps;
+    std::unique_ptr<ThreadPool> pool;
+};
+
+// runs body(i) for every environment, on the pool if there is one
+static void forEachEnvironment(snakesim_envs* envs, const std::function<void(size_t)>& body) {
+    size_t count = envs->environments.size();
+    if (!envs->pool) {
+        for (size_t i = 0; i < count; ++i) body(i);
+        return;
+    }
+    envs->pool->parallelFor(count, 0, [&body](size_t begin, size_t end, size_t) {
+        for (size_t i = begin; i < end; ++i) body(i);
+    });
+}
+
+uint32_t snakesim_abi_version(void) {
+    return SNAKESIM_ABI_VERSION;
+}
+
+snakesim_envs* snakesim_create(uint32_t count, uint32_t width, uint32_t height,
+                               uint32_t observation_size, uint32_t starvation_steps,
+                               uint32_t threads) {
+    if (count == 0 || width < SIM_MIN_SIZE || height < SIM_MIN_SIZE) return nullptr;
+    if (observation_size != BASIC_INPUT_NODES && observation_size != RAY_INPUT_NODES) return nullptr;
+    if (observation_size == RAY_INPUT_NODES &&
+        (width > (uint32_t)OccupancyGrid::MAX_SIZE || height > (uint32_t)OccupancyGrid::MAX_SIZE)) {
+        return nullptr;
+    }
+
+    try {
+        std::unique_ptr<snakesim_envs> envs(new snakesim_envs());
+        envs->observation_size = observation_size;
+        envs->starvation_steps = starvation_steps;
+        envs->environments.reserve(count);
+        for (uint32_t i = 0; i < count; ++i) {
+            envs->environments.push_back(std::make_unique<SimEnvironment>((int)width, (int)height));
+        }
+        if (threads > 1) {
+            envs->pool = std::make_unique<ThreadPool>(threads);
+        }
+        return envs.release();
+    } catch (...) {
+        return nullptr;
+    }
+}
+
+void snakesim_destroy(snakesim_envs* envs) {
+    delete envs;
+}
+
+uint32_t snakesim_count(const snakesim_envs* envs) {
+    return envs ? (uint32_t)envs->environments.size() : 0;
+}
+
+uint32_t snakesim_observation_size(const snakesim_envs* envs) {
+    return envs ? envs->observation_size : 0;
+}
+
+int snakesim_reset(snakesim_envs* envs, const uint64_t* seeds, double* observations) {
+    if (!envs || !observations) return SNAKESIM_ERROR_ARGUMENT;
+    try {
+        forEachEnvironment(envs, [&](size_t i) {
+            SimEnvironment& env = *envs->environments[i];
+            env.food.seed(seeds ? seeds[i] : (uint64_t)i);
+            env.world.reset();
+            env.steps_since_food = 0;
+            env.world.get_game_state(envs->observation_size, observations + i * envs->observation_size);
+        });
+    } catch (...) {
+        return SNAKESIM_ERROR_INTERNAL;
+    }
+    return 0;
+}
+
+int snakesim_step(snakesim_envs* envs, const int32_t* actions, double* observations,
+                  double* rewards, uint8_t* dones) {
+    if (!envs || !actions || !observations || !rewards || !dones) return SNAKESIM_ERROR_ARGUMENT;
+    try {
+        forEachEnvironment(envs, [&](size_t i) {
+            SimEnvironment& env = *envs->environments[i];
+            int score = env.world.getScore();
+
+            env.world.apply_action(actions[i]);
+            env.world.update();
+
+            double reward = 0.0;
+            bool done = false;
+            if (env.world.snake_died()) {
+                // update() has already restarted the world
+                reward = -1.0;
+                done = true;
+                env.steps_since_food = 0;
+            } else if (env.world.getScore() > score) {
+                reward = 1.0;
+                env.steps_since_food = 0;
+            } else if (envs->starvation_steps > 0 && ++env.steps_since_food > envs->starvation_steps) {
+                env.world.reset();
+                done = true;
+                env.steps_since_food = 0;
+            }
+
+            rewards[i] = reward;
+            dones[i] = done ? 1 : 0;
+            env.world.get_game_state(envs->observation_size, observations + i * envs->observation_size);
+        });
+    } catch (...) {
+        return SNAKESIM_ERROR_INTERNAL;
+    }
+    return 0;
+}
+
+int snakesim_scores(const snakesim_envs* envs, int32_t* scores) {
+    if (!envs || !scores) return SNAKESIM_ERROR_ARGUMENT;
+    for (size_t i = 0; i < envs->environments.size(); ++i) {
+        scores[i] = envs->environments[i]->world.getScore();
+    }
+    return 0;
+}
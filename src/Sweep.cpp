@@ -0,0 +1,200 @@
+#include "Sweep.hpp"
+#include "TrainingRun.hpp"
+#include "World.hpp"
+#include "Random.hpp"
+#include <iostream>
+#include <fstream>
+#include <sstream>
+#include <thread>
+#include <mutex>
+#include <chrono>
+#include <algorithm>
+
+// held-out games the champion is scored on after every generation
+const size_t CHAMPION_GAMES = 20;
+// fixed, so every champion of every run is scored on the same games
+const uint64_t CHAMPION_SEED = 0x5EE9C4A3905EEDull;
+
+struct SweepConfig {
+    std::vector<size_t> topology;
+    size_t popSize;
+    double mutationRate;
+    double mutationStrength;
+};
+
+struct SweepResult {
+    size_t generations = 0;
+    size_t evaluations = 0;
+    double finalBest = 0.0;
+    double finalAverage = 0.0;
+    int bestScore = 0;
+    bool stoppedEarly = false;
+    double seconds = 0.0;
+    // mean score of the last champion on the held-out games
+    double championScore = 0.0;
+    // per threshold: first generation / seconds a champion reached it, -1 if never
+    std::vector<long> thresholdGeneration;
+    std::vector<double> thresholdSeconds;
+};
+
+/**
+ * Best-fitness-so-far curves of all runs, used to stop hopeless ones.
+ */
+class SweepBoard {
+public:
+    SweepBoard(size_t runs, const SweepOptions& options) : curves(runs), options(options) {}
+
+    /**
+     * @brief Records the run's progress and decides whether it should stop.
+     */
+    bool shouldStop(size_t run, double bestSoFar) {
+        std::lock_guard<std::mutex> lock(mutex);
+        size_t generation = curves[run].size();
+        curves[run].push_back(bestSoFar);
+        if (generation + 1 < options.pruneAfter) return false;
+
+        double leader = 0.0;
+        for (size_t other = 0; other < curves.size(); ++other) {
+            if (other != run && curves[other].size() > generation) {
+                leader = std::max(leader, curves[other][generation]);
+            }
+        }
+        return bestSoFar < options.pruneRatio * leader;
+    }
+
+private:
+    std::mutex mutex;
+    std::vector<std::vector<double>> curves;
+    const SweepOptions& options;
+};
+
+static std::string topologyName(const std::vector<size_t>& topology) {
+    std::ostringstream name;
+    for (size_t i = 0; i < topology.size(); ++i) {
+        if (i > 0) name << "-";
+        name << topology[i];
+    }
+    return name.str();
+}
+
+// mean score of one gene row over the held-out games
+static double championScore(EvalContext& context, const std::vector<size_t>& topology, const double* genes,
+                            size_t geneCount) {
+    double score = 0.0;
+    for (size_t k = 0; k < CHAMPION_GAMES; ++k) {
+        score += context.evaluate(topology, genes, geneCount, streamKey(CHAMPION_SEED, 0, k)).score;
+    }
+    return score / CHAMPION_GAMES;
+}
+
+static void trainConfig(const SweepConfig& config, size_t index, const SweepOptions& options,
+                        ThreadPool& pool, SweepBoard& board, SweepResult& result) {
+    TrainingRun run(config.popSize, config.topology, EvalConfig{}, pool);
+    run.getPopulation().setMutation(config.mutationRate, config.mutationStrength);
+    // replays the champion on the driver thread, outside the timed step
+    EvalContext holdOut(EvalConfig{});
+    std::vector<double> scratch(NeuralNetwork::geneCountFor(config.topology));
+
+    result.thresholdGeneration.assign(options.scoreThresholds.size(), -1);
+    result.thresholdSeconds.assign(options.scoreThresholds.size(), -1.0);
+    double bestSoFar = 0.0;
+
+    for (size_t g = 0; g < options.generations; ++g) {
+        GenerationReport report = run.step();
+        result.generations++;
+        result.evaluations += report.evaluations;
+        result.seconds += report.seconds;
+        result.finalBest = report.bestFitness;
+        result.finalAverage = report.averageFitness;
+        result.bestScore = std::max(result.bestScore, report.bestScore);
+        bestSoFar = std::max(bestSoFar, report.bestFitness);
+
+        // the best game of a generation is often luck, so the thresholds go
+        // by what its champion scores on games it was not selected on
+        const double* champion = run.getPopulation().getGeneRow(0, scratch.data());
+        result.championScore = championScore(holdOut, config.topology, champion, scratch.size());
+        for (size_t t = 0; t < options.scoreThresholds.size(); ++t) {
+            if (result.thresholdGeneration[t] < 0 && result.championScore >= options.scoreThresholds[t]) {
+                result.thresholdGeneration[t] = (long)report.generation;
+                result.thresholdSeconds[t] = result.seconds;
+            }
+        }
+
+        if (board.shouldStop(index, bestSoFar)) {
+            result.stoppedEarly = true;
+            break;
+        }
+    }
+
+    std::cout << "Sweep: " << topologyName(config.topology)
+              << " pop " << config.popSize << " mut " << config.mutationRate << " x " << config.mutationStrength
+              << (result.stoppedEarly ? " stopped early" : " finished")
+              << " after " << result.generations << " generations" << std::endl;
+}
+
+int runSweep(const SweepOptions& options) {
+    std::vector<SweepConfig> configs;
+    for (const auto& hidden : options.hiddenLayers) {
+        std::vector<size_t> topology = { options.inputNodes };
+        topology.insert(topology.end(), hidden.begin(), hidden.end());
+        topology.push_back(OUTPUT_NODES);
+        for (size_t popSize : options.populationSizes) {
+            for (double rate : options.mutationRates) {
+                for (double strength : options.mutationStrengths) {
+                    configs.push_back({ topology, popSize, rate, strength });
+                }
+            }
+        }
+    }
+    if (configs.empty()) {
+        std::cerr << "Sweep: the grid is empty" << std::endl;
+        return 1;
+    }
+
+    std::cout << "Sweep: " << configs.size() << " configurations" << std::endl;
+
+    // every configuration trains on its own driver thread; the heavy work is
+    // handed to the shared pool, which serves the runs round-robin
+    ThreadPool pool(options.threads);
+    SweepBoard board(configs.size(), options);
+    std::vector<SweepResult> results(configs.size());
+    std::vector<std::thread> drivers;
+    for (size_t i = 0; i < configs.size(); ++i) {
+        drivers.emplace_back(trainConfig, std::cref(configs[i]), i, std::cref(options),
+                             std::ref(pool), std::ref(board), std::ref(results[i]));
+    }
+    for (auto& driver : drivers) {
+        driver.join();
+    }
+
+    std::ofstream out(options.outputPath);
+    if (!out) {
+        std::cerr << "Sweep: cannot write " << options.outputPath << std::endl;
+        return 1;
+    }
+    out << "topology,population,mutation_rate,mutation_strength,generations,evaluations,final_best,final_average,"
+           "best_score,champion_score,stopped_early,seconds";
+    for (int threshold : options.scoreThresholds) {
+        out << ",gen_to_score_" << threshold << ",seconds_to_score_" << threshold;
+    }
+    out << "\n";
+
+    for (size_t i = 0; i < configs.size(); ++i) {
+        const SweepConfig& config = configs[i];
+        const SweepResult& result = results[i];
+        out << topologyName(config.topology) << "," << config.popSize << "," << config.mutationRate << ","
+            << config.mutationStrength << "," << result.generations << "," << result.evaluations << ","
+            << result.finalBest << "," << result.finalAverage << "," << result.bestScore << ","
+            << result.championScore << "," << (result.stoppedEarly ? 1 : 0) << "," << result.seconds;
+        for (size_t t = 0; t < options.scoreThresholds.size(); ++t) {
+            out << ",";
+            if (result.thresholdGeneration[t] >= 0) out << result.thresholdGeneration[t];
+            out << ",";
+            if (result.thresholdGeneration[t] >= 0) out << result.thresholdSeconds[t];
+        }
+        out << "\n";
+    }
+
+    std::cout << "Sweep: results written to " << options.outputPath << std::endl;
+    return 0;
+}
@@ -0,0 +1,171 @@
+#include "ThreadPool.hpp"
+#include "Trace.hpp"
+#include "Metrics.hpp"
+#include <algorithm>
+#include <iostream>
+#include <string>
+
+const size_t ThreadPool::MAX_NODES;
+
+ThreadPool::ThreadPool(size_t threadCount, bool pinWorkers)
+    : nextJob(0), stolenChunks(0), queued(0), stopping(false), metrics(nullptr) {
+    if (pinWorkers) {
+        NumaTopology topology = NumaTopology::detect();
+        start(threadCount, &topology);
+    } else {
+        start(threadCount, nullptr);
+    }
+}
+
+ThreadPool::ThreadPool(size_t threadCount, const NumaTopology& topology)
+    : nextJob(0), stolenChunks(0), queued(0), stopping(false), metrics(nullptr) {
+    start(threadCount, &topology);
+}
+
+void ThreadPool::start(size_t threadCount, const NumaTopology* topology) {
+    if (threadCount == 0) {
+        threadCount = topology ? topology->cpuCount() : std::max(1u, std::thread::hardware_concurrency());
+    }
+
+    // deal workers to the nodes in turn, so any count uses every node;
+    // beyond MAX_NODES, node n works on shard n % MAX_NODES
+    std::vector<int> cpus(threadCount, -1);
+    workerNode.assign(threadCount, 0);
+    size_t nodes = std::min(topology ? topology->nodeCount() : 1, threadCount);
+    nodeWorkers.assign(std::min(nodes, MAX_NODES), 0);
+    for (size_t i = 0; i < threadCount; ++i) {
+        size_t node = i % nodes;
+        workerNode[i] = node % MAX_NODES;
+        nodeWorkers[workerNode[i]]++;
+        if (topology) {
+            const std::vector<int>& nodeCpus = topology->nodeCpus[node];
+            cpus[i] = nodeCpus[(i / nodes) % nodeCpus.size()];
+        }
+    }
+
+    workers.reserve(threadCount);
+    for (size_t i = 0; i < threadCount; ++i) {
+        workers.emplace_back(&ThreadPool::workerLoop, this, i, cpus[i]);
+    }
+}
+
+ThreadPool::~ThreadPool() {
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        stopping = true;
+    }
+    wakeup.notify_all();
+    for (auto& worker : workers) {
+        worker.join();
+    }
+}
+
+size_t ThreadPool::getStolenChunks() {
+    std::lock_guard<std::mutex> lock(mutex);
+    return stolenChunks;
+}
+
+void ThreadPool::setMetrics(TrainingMetrics* sink) {
+    std::lock_guard<std::mutex> lock(mutex);
+    metrics = sink;
+    if (metrics) metrics->workers.store(workers.size(), std::memory_order_relaxed);
+}
+
+void ThreadPool::parallelFor(size_t count, size_t grain, const Task& task) {
+    if (count == 0) return;
+    if (grain == 0) {
+        // a few chunks per worker keeps the tail short without much locking
+        grain = std::max<size_t>(1, count / (workers.size() * 4));
+    }
+
+    Job job;
+    job.task = &task;
+    job.count = count;
+    job.grain = grain;
+    job.unclaimed = count;
+    job.done = 0;
+    // node n's shard covers its share of the workers, in worker order
+    size_t before = 0;
+    for (size_t n = 0; n < nodeWorkers.size(); ++n) {
+        job.next[n] = count * before / workers.size();
+        before += nodeWorkers[n];
+        job.end[n] = count * before / workers.size();
+    }
+
+    // time spent here is the caller idling at the barrier
+    TRACE_ZONE("ThreadPool::wait");
+    std::unique_lock<std::mutex> lock(mutex);
+    openJobs.push_back(&job);
+    queued += count;
+    if (metrics) metrics->queuedItems.store(queued, std::memory_order_relaxed);
+    wakeup.notify_all();
+    job.finished.wait(lock, [&job] { return job.done == job.count; });
+    lock.unlock();
+
+    if (job.error) std::rethrow_exception(job.error);
+}
+
+void ThreadPool::workerLoop(size_t worker, int cpu) {
+    setTraceThreadName("worker " + std::to_string(worker));
+    if (cpu >= 0 && !pinCurrentThread(cpu) && worker == 0) {
+        std::cerr << "ThreadPool: could not pin workers, they will float" << std::endl;
+    }
+
+    size_t home = workerNode[worker];
+    size_t nodes = nodeWorkers.size();
+    std::unique_lock<std::mutex> lock(mutex);
+    while (true) {
+        wakeup.wait(lock, [this] { return stopping || !openJobs.empty(); });
+        if (openJobs.empty()) return;
+
+        // claim one chunk from the next job in round-robin order: from the
+        // front of our own shard, else from the back of the next shard with work
+        if (nextJob >= openJobs.size()) nextJob = 0;
+        Job* job = openJobs[nextJob];
+        size_t begin, end;
+        if (job->next[home] < job->end[home]) {
+            begin = job->next[home];
+            end = std::min(job->end[home], begin + job->grain);
+            job->next[home] = end;
+        } else {
+            size_t victim = home;
+            for (size_t k = 1; k < nodes; ++k) {
+                victim = (home + k) % nodes;
+                if (job->next[victim] < job->end[victim]) break;
+            }
+            end = job->end[victim];
+            begin = std::max(job->next[victim], end - std::min(end, job->grain));
+            job->end[victim] = begin;
+            stolenChunks++;
+        }
+        job->unclaimed -= end - begin;
+        queued -= end - begin;
+        TrainingMetrics* sink = metrics;
+        if (sink) sink->queuedItems.store(queued, std::memory_order_relaxed);
+        if (job->unclaimed == 0) {
+            openJobs.erase(openJobs.begin() + nextJob);
+        } else {
+            nextJob++;
+        }
+        lock.unlock();
+
+        bool timed = sink && sink->enabled.load(std::memory_order_relaxed);
+        uint64_t started = timed ? metricsClock() : 0;
+        std::exception_ptr error;
+        try {
+            TRACE_ZONE("ThreadPool::chunk");
+            (*job->task)(begin, end, worker);
+        } catch (...) {
+            error = std::current_exception();
+        }
+        if (timed) {
+            sink->busyNanoseconds[worker % TrainingMetrics::MAX_WORKERS].fetch_add(
+                metricsClock() - started, std::memory_order_relaxed);
+        }
+
+        lock.lock();
+        if (error && !job->error) job->error = error;
+        job->done += end - begin;
+        if (job->done == job->count) job->finished.notify_all();
+    }
+}
@@ -0,0 +1,128 @@
+#include "Trace.hpp"
+
+#ifdef SNAKE_TRACING
+
+#include <atomic>
+#include <chrono>
+#include <memory>
+#include <mutex>
+#include <vector>
+#include <fstream>
+#include <iomanip>
+
+#ifndef SNAKE_TRACE_CAPACITY
+#define SNAKE_TRACE_CAPACITY (1 << 16)
+#endif
+
+struct TraceEvent {
+    const char* name;
+    uint64_t start;
+    uint64_t duration;
+};
+
+/**
+ * Single-producer ring: only the owning thread writes events and bumps
+ * `written`; the dumper reads `written` with acquire ordering.
+ */
+struct TraceBuffer {
+    static const size_t CAPACITY = SNAKE_TRACE_CAPACITY;
+    static_assert((CAPACITY & (CAPACITY - 1)) == 0, "trace capacity must be a power of two");
+
+    size_t threadId;
+    std::string threadName;
+    std::atomic<uint64_t> written{0};
+    std::vector<TraceEvent> events = std::vector<TraceEvent>(CAPACITY);
+};
+
+struct TraceRegistry {
+    std::mutex mutex;
+    // buffers outlive their threads so a dump at exit still sees them
+    std::vector<std::unique_ptr<TraceBuffer>> buffers;
+};
+
+static TraceRegistry& registry() {
+    static TraceRegistry instance;
+    return instance;
+}
+
+static const std::chrono::steady_clock::time_point traceEpoch = std::chrono::steady_clock::now();
+
+static uint64_t nowNs() {
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - traceEpoch).count();
+}
+
+static TraceBuffer& threadBuffer() {
+    // registration takes the lock once per thread, recording never does
+    thread_local TraceBuffer* buffer = [] {
+        TraceRegistry& reg = registry();
+        std::lock_guard<std::mutex> lock(reg.mutex);
+        reg.buffers.push_back(std::make_unique<TraceBuffer>());
+        TraceBuffer* created = reg.buffers.back().get();
+        created->threadId = reg.buffers.size();
+        created->threadName = "thread " + std::to_string(created->threadId);
+        return created;
+    }();
+    return *buffer;
+}
+
+TraceZone::TraceZone(const char* name) : name(name), start(nowNs()) {}
+
+TraceZone::~TraceZone() {
+    TraceBuffer& buffer = threadBuffer();
+    uint64_t index = buffer.written.load(std::memory_order_relaxed);
+    buffer.events[index & (TraceBuffer::CAPACITY - 1)] = { name, start, nowNs() - start };
+    buffer.written.store(index + 1, std::memory_order_release);
+}
+
+bool traceCompiledIn() {
+    return true;
+}
+
+void setTraceThreadName(const std::string& name) {
+    TraceBuffer& buffer = threadBuffer();
+    std::lock_guard<std::mutex> lock(registry().mutex);
+    buffer.threadName = name;
+}
+
+bool writeTrace(const std::string& path) {
+    std::ofstream out(path);
+    if (!out) return false;
+
+    TraceRegistry& reg = registry();
+    std::lock_guard<std::mutex> lock(reg.mutex);
+
+    out << std::fixed << std::setprecision(3);
+    out << "{\"displayTimeUnit\":\"ns\",\"traceEvents\":[\n";
+    bool first = true;
+    for (const auto& buffer : reg.buffers) {
+        out << (first ? "" : ",\n")
+            << "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":" << buffer->threadId
+            << ",\"args\":{\"name\":\"" << buffer->threadName << "\"}}";
+        first = false;
+
+        uint64_t written = buffer->written.load(std::memory_order_acquire);
+        uint64_t begin = written > TraceBuffer::CAPACITY ? written - TraceBuffer::CAPACITY : 0;
+        for (uint64_t i = begin; i < written; ++i) {
+            const TraceEvent& event = buffer->events[i & (TraceBuffer::CAPACITY - 1)];
+            // Chrome traces count in microseconds
+            out << ",\n{\"name\":\"" << event.name << "\",\"ph\":\"X\",\"pid\":1,\"tid\":" << buffer->threadId
+                << ",\"ts\":" << event.start / 1000.0 << ",\"dur\":" << event.duration / 1000.0 << "}";
+        }
+    }
+    out << "\n]}\n";
+    return (bool)out;
+}
+
+#else
+
+bool traceCompiledIn() {
+    return false;
+}
+
+void setTraceThreadName(const std::string&) {}
+
+bool writeTrace(const std::string&) {
+    return false;
+}
+
+#endif
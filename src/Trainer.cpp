@@ -1,44 +1,50 @@
 #include "Trainer.hpp"
 #include "NeuralNetwork.hpp"
+#include "Exporter.hpp"
+#include "Trace.hpp"
+#include <algorithm>
 #include <iostream>
-#include <thread>
-#include <future>
-
-double evaluate_brain_fitness(const std::vector<size_t>& topology, const std::vector<double>& genes, int max_steps, int width, int height) {
-    Snake snake;
-    Food food(10, 10);
-    World world(snake, food, width, height); 
-    NeuralNetwork brain(topology, ActivationType::RELU); 
-    brain.setGenes(genes);
-    int steps = 0;
-    int score_at_last_food = 0;
-    int steps_since_last_food = 0;
-    while (!world.snake_hit_wall() && !snake.hit_itself() && steps < max_steps) {
-        world.handle_ai_input(brain);
-        world.update();
-        steps++;
-        steps_since_last_food++;
-        if (world.getScore() > score_at_last_food) {
-            score_at_last_food = world.getScore();
-            steps_since_last_food = 0;
-        }
-        if (steps_since_last_food > 150) break;
-    }
-    return (double)steps + (double)(world.getScore() * 1000.0);
+#include <ctime>
+#include <sys/stat.h>
+
+// visualization speed levels, as multiples of VIS_STEPS_PER_SECOND
+static const double VIS_SPEEDS[] = { 0.25, 0.5, 1.0, 2.0, 5.0, 10.0, 100.0, 1000.0, 10000.0 };
+static const size_t VIS_SPEED_COUNT = sizeof(VIS_SPEEDS) / sizeof(VIS_SPEEDS[0]);
+static const size_t VIS_NORMAL_SPEED = 2;
+// longest frame time that is made up with extra steps; a longer stall
+// (dragging the window, a debugger) just skips ahead
+static const double VIS_MAX_FRAME_SECONDS = 0.25;
+// wall time per frame the simulation may use, so input stays responsive at 10000x
+static const double VIS_STEP_BUDGET_SECONDS = 0.012;
+
+static std::vector<size_t> buildTopology(const TrainerOptions& options) {
+    std::vector<size_t> topology = { options.inputNodes };
+    topology.insert(topology.end(), options.hiddenLayers.begin(), options.hiddenLayers.end());
+    topology.push_back(OUTPUT_NODES);
+    return topology;
 }
 
-const int INPUT_NODES = 11;
-const int DEFAULT_HIDDEN_NODES = 8;
-const int OUTPUT_NODES = 3;
-
-Trainer::Trainer()
+Trainer::Trainer(const TrainerOptions& options)
     : POPULATION_SIZE(500),
-      m_topology{INPUT_NODES, DEFAULT_HIDDEN_NODES, OUTPUT_NODES},
-      m_hiddenNodeCount(8),
+      m_topology(buildTopology(options)),
       m_game(), 
-      m_population(POPULATION_SIZE, m_topology),
-      m_state(TrainerState::Menu)
+      m_pool(0, options.pinThreads),
+      m_run(POPULATION_SIZE, m_topology,
+            EvalConfig{MAX_STEPS_PER_GAME, WINDOW_WIDTH, WINDOW_HEIGHT, options.detectLoops, options.loopScoring,
+                       options.activations, options.episodes, options.aggregate, options.aggregateQuantile,
+                       options.sparseDensity},
+            m_pool, options.optimizer, options.precision),
+      m_state(TrainerState::Menu),
+      m_selectedLayer(m_topology.size() - 2),
+      m_logDir(options.logDir),
+      m_visSpeedIndex(VIS_NORMAL_SPEED),
+      m_visPaused(false),
+      m_visStepOnce(false),
+      m_visAccumulator(0.0),
+      m_visLastTick(0)
 {
+    m_run.setScreening(options.screening);
+    m_run.getPopulation().setPruning(options.pruneThreshold);
     if (!m_game.init("AI Snake Trainer", WINDOW_WIDTH, WINDOW_HEIGHT)) {
         std::cerr << "Game Init Failed" << std::endl;
         exit(-1);
@@ -50,6 +56,8 @@ Trainer::Trainer()
 
     btnPlusNode = { 450, 300, 50, 50 };
 
+    openRunLog();
+
     std::cout << "Trainer Initialized." << std::endl;
 }
 
@@ -82,17 +90,11 @@ void Trainer::handleEvents() {
             }
 
             if (SDL_PointInRect(&mousePoint, &btnMinusNode)) {
-                if (m_hiddenNodeCount > 0) {
-                    m_hiddenNodeCount--;
-                    std::cout << "Nodes Decreased to " << m_hiddenNodeCount << std::endl;
-                    resetTraining();
-                }
+                shrinkNetwork();
             }
 
             if (SDL_PointInRect(&mousePoint, &btnPlusNode)) {
-                m_hiddenNodeCount++;
-                std::cout << "Nodes Increased to " << m_hiddenNodeCount << std::endl;
-                resetTraining();
+                growNetwork();
             }
         }
 
@@ -120,6 +122,45 @@ void Trainer::handleEvents() {
                         startVisualization();
                     }
                     break;
+                case SDLK_e:
+                    exportChampion();
+                    break;
+                case SDLK_l:
+                    if (m_state == TrainerState::Menu) insertHiddenLayer();
+                    break;
+                case SDLK_UP:
+                    if (m_state == TrainerState::Menu && m_selectedLayer > 1) m_selectedLayer--;
+                    break;
+                case SDLK_DOWN:
+                    if (m_state == TrainerState::Menu && m_selectedLayer + 2 < m_topology.size()) m_selectedLayer++;
+                    break;
+                case SDLK_SPACE:
+                    if (m_state == TrainerState::Visualizing) {
+                        m_visPaused = !m_visPaused;
+                        std::cout << (m_visPaused ? "Visualization paused" : "Visualization resumed") << std::endl;
+                    }
+                    break;
+                case SDLK_PERIOD:
+                case SDLK_RIGHT:
+                    if (m_state == TrainerState::Visualizing) {
+                        m_visPaused = true;
+                        m_visStepOnce = true;
+                    }
+                    break;
+                case SDLK_PLUS:
+                case SDLK_EQUALS:
+                case SDLK_KP_PLUS:
+                    if (m_state == TrainerState::Visualizing) changeVisualizationSpeed(1);
+                    break;
+                case SDLK_MINUS:
+                case SDLK_KP_MINUS:
+                    if (m_state == TrainerState::Visualizing) changeVisualizationSpeed(-1);
+                    break;
+                case SDLK_1:
+                    if (m_state == TrainerState::Visualizing) {
+                        changeVisualizationSpeed((int)VIS_NORMAL_SPEED - (int)m_visSpeedIndex);
+                    }
+                    break;
             }
             if (event.key.keysym.sym == SDLK_m) {
                  m_state = TrainerState::Menu;
@@ -136,15 +177,80 @@ void Trainer::handleEvents() {
 }
 
 void Trainer::resetTraining() {
-    m_topology.clear();
-    m_topology.push_back(INPUT_NODES); 
-    if (m_hiddenNodeCount > 0) {
-        m_topology.push_back(m_hiddenNodeCount);
+    m_run.reset(POPULATION_SIZE, m_topology);
+    openRunLog();
+}
+
+// The node buttons edit the selected hidden layer of the running population
+// instead of starting over, see Morphism.hpp.
+void Trainer::growNetwork() {
+    if (m_topology.size() == 2) {
+        // no hidden layer to grow yet
+        insertHiddenLayer();
+        return;
+    }
+    morphTraining({ MorphKind::AddNeuron, m_selectedLayer });
+    std::cout << "Nodes Increased to " << m_topology[m_selectedLayer] << std::endl;
+}
+
+void Trainer::shrinkNetwork() {
+    if (m_topology.size() == 2) return;
+    size_t layer = m_selectedLayer;
+    if (m_topology[layer] > 1) {
+        morphTraining({ MorphKind::RemoveNeuron, layer, m_run.getPopulation().findWeakestNeuron(layer) });
+        std::cout << "Nodes Decreased to " << m_topology[layer] << std::endl;
+        return;
+    }
+    // dropping a whole layer has no function-preserving form, so this
+    // starts over like the old buttons did
+    m_topology.erase(m_topology.begin() + layer);
+    m_selectedLayer = std::max<size_t>(1, std::min(layer, m_topology.size() - 2));
+    std::cout << "Hidden layer removed" << std::endl;
+    resetTraining();
+}
+
+// the new layer goes right after the selected one and becomes the selection
+void Trainer::insertHiddenLayer() {
+    size_t layer = m_topology.size() == 2 ? 1 : m_selectedLayer + 1;
+    morphTraining({ MorphKind::InsertLayer, layer });
+    m_selectedLayer = layer;
+    std::cout << "Hidden layer of " << m_topology[layer] << " nodes added" << std::endl;
+}
+
+void Trainer::morphTraining(const Morph& morph) {
+    m_run.morph(morph);
+    m_topology = m_run.getTopology();
+    // the log's header names the topology, so the grown run gets a new log
+    openRunLog();
+    // the visualized brain still has the old topology
+    if (m_visWorld) startVisualization();
+}
+
+void Trainer::openRunLog() {
+    m_logReader.close();
+    m_run.closeLog();
+
+    mkdir(m_logDir.c_str(), 0755);
+    char stamp[32];
+    std::time_t now = std::time(nullptr);
+    std::strftime(stamp, sizeof(stamp), "%Y%m%d-%H%M%S", std::localtime(&now));
+    static int runCount = 0;
+    m_logPath = m_logDir + "/run-" + stamp + "-" + std::to_string(runCount++) + ".log";
+
+    if (!m_run.openLog(m_logPath) || !m_logReader.open(m_logPath)) {
+        std::cerr << "Could not open generation log " << m_logPath << std::endl;
+        return;
     }
+    std::cout << "Logging generations to " << m_logPath << std::endl;
+}
 
-    m_topology.push_back(OUTPUT_NODES);
-    m_population.reset(POPULATION_SIZE, m_topology);
-    m_fitnessHistory.clear();
+void Trainer::exportChampion() {
+    const std::string path = "champion_policy.hpp";
+    if (exportPolicyHeader(m_run.getPopulation().getBrain(0), path)) {
+        std::cout << "Champion exported to " << path << std::endl;
+    } else {
+        std::cerr << "Could not write " << path << std::endl;
+    }
 }
 
 void Trainer::update() {
@@ -161,6 +267,7 @@ void Trainer::update() {
 }
 
 void Trainer::render() {
+    TRACE_ZONE("Trainer::render");
     m_game.clear(); 
 
     switch (m_state) {
@@ -178,13 +285,26 @@ void Trainer::render() {
             
             SDL_SetRenderDrawColor(r, 255, 255, 255, 255);
             
-            if (m_hiddenNodeCount == 0) {
+            if (m_topology.size() == 2) {
                  SDL_Rect line = { 360, 325, 20, 2 };
                  SDL_RenderFillRect(r, &line);
             } else {
-                for(size_t i=0; i < m_hiddenNodeCount; ++i) {
-                    SDL_Rect nodeRect = { 360 + ((int)i * 10), 310, 5, 30 }; 
-                    SDL_RenderFillRect(r, &nodeRect);
+                // one row of nodes per hidden layer below the buttons, the
+                // selected one (which the buttons edit) in yellow; wide
+                // layers are squeezed to fit the window
+                size_t hiddenLayers = m_topology.size() - 2;
+                int rowHeight = std::min(40, 220 / (int)hiddenLayers);
+                for (size_t l = 1; l <= hiddenLayers; ++l) {
+                    if (l == m_selectedLayer) SDL_SetRenderDrawColor(r, 255, 220, 50, 255);
+                    else SDL_SetRenderDrawColor(r, 255, 255, 255, 255);
+                    int span = (int)std::min<size_t>(m_topology[l] * 10, 760);
+                    double spacing = (double)span / (double)m_topology[l];
+                    int y = 370 + rowHeight * (int)(l - 1);
+                    for (size_t i = 0; i < m_topology[l]; ++i) {
+                        SDL_Rect nodeRect = { 400 - span / 2 + (int)((double)i * spacing), y,
+                                              std::max(1, (int)(spacing / 2.0)), rowHeight * 3 / 4 };
+                        SDL_RenderFillRect(r, &nodeRect);
+                    }
                 }
             }
             break;
@@ -208,52 +328,80 @@ void Trainer::startVisualization() {
     m_visSnake = std::make_unique<Snake>();
     m_visFood  = std::make_unique<Food>(10, 10);
     m_visWorld = std::make_unique<World>(*m_visSnake, *m_visFood, WINDOW_WIDTH, WINDOW_HEIGHT);
+    m_visBrain = std::make_unique<NeuralNetwork>(m_run.getPopulation().getBrain(0));
+    m_visAccumulator = 0.0;
+    m_visLastTick = SDL_GetPerformanceCounter();
 }
 
 void Trainer::stopVisualization() {
     m_visWorld.reset();
     m_visFood.reset();
     m_visSnake.reset();
+    m_visBrain.reset();
 }
 
+// Fixed timestep: wall time since the last frame, times the speed, is
+// banked as simulation steps, and every whole step is played before the
+// frame renders the latest state. The vsync'd present paces the loop, so
+// nothing sleeps here and events are handled every frame at any speed.
 void Trainer::runVisualizationStep() {
     if (!m_visWorld) return;
+
+    Uint64 frequency = SDL_GetPerformanceFrequency();
+    Uint64 now = SDL_GetPerformanceCounter();
+    double elapsed = std::min((double)(now - m_visLastTick) / (double)frequency, VIS_MAX_FRAME_SECONDS);
+    m_visLastTick = now;
+
+    long long steps = 0;
+    if (m_visPaused) {
+        steps = m_visStepOnce ? 1 : 0;
+        m_visStepOnce = false;
+        m_visAccumulator = 0.0;
+    } else {
+        m_visAccumulator += elapsed * VIS_STEPS_PER_SECOND * VIS_SPEEDS[m_visSpeedIndex];
+        steps = (long long)m_visAccumulator;
+        m_visAccumulator -= (double)steps;
+    }
+
+    Uint64 deadline = now + (Uint64)(VIS_STEP_BUDGET_SECONDS * (double)frequency);
+    for (long long s = 0; s < steps; ++s) {
+        advanceVisualization();
+        // the machine cannot keep up with this speed: drop the backlog
+        if ((s & 255) == 255 && SDL_GetPerformanceCounter() > deadline) {
+            m_visAccumulator = 0.0;
+            break;
+        }
+    }
+}
+
+void Trainer::advanceVisualization() {
     if (m_visWorld->snake_hit_wall() || m_visSnake->hit_itself()) {
         startVisualization(); 
         return;
     }
-    NeuralNetwork& bestBrain = m_population.getBrain(0); 
-    m_visWorld->handle_ai_input(bestBrain);
+    m_visWorld->handle_ai_input(*m_visBrain);
     m_visWorld->update();
-    SDL_Delay(1000 / FPS);
 }
 
-void Trainer::runTrainingStep() {
-    std::vector<std::future<double>> futures;
-    futures.reserve(m_population.size());
-
-    for (size_t i = 0; i < m_population.size(); ++i) {
-        std::vector<double> genes = m_population.getBrain(i).getGenes();
-        
-        futures.push_back(
-            std::async(std::launch::async, evaluate_brain_fitness, m_topology, genes, MAX_STEPS_PER_GAME, WINDOW_WIDTH, WINDOW_HEIGHT)
-        );
-    }
-    
-    for (size_t i = 0; i < m_population.size(); ++i) {
-        m_population.setFitness(i, futures[i].get());
-    }
-
-    double avgFitness = m_population.getAverageFitness();
-    m_fitnessHistory.push_back(avgFitness);
+void Trainer::changeVisualizationSpeed(int delta) {
+    int index = std::max(0, std::min((int)VIS_SPEED_COUNT - 1, (int)m_visSpeedIndex + delta));
+    m_visSpeedIndex = (size_t)index;
+    std::cout << "Visualization speed " << VIS_SPEEDS[m_visSpeedIndex] << "x" << std::endl;
+}
 
-    if (m_population.getGeneration() % 1 == 0) {
-         std::cout << "Gen: " << m_population.getGeneration() 
-                  << " | Best: " << (int)m_population.getBestFitness()
-                  << " | Avg: " << avgFitness
-                  << " | Topology: " << m_hiddenNodeCount << " hidden nodes" << std::endl;
+void Trainer::runTrainingStep() {
+    TRACE_ZONE("Trainer::runTrainingStep");
+    GenerationReport report = m_run.step();
+
+    std::cout << "Gen: " << report.generation
+              << " | Best: " << (int)report.bestFitness
+              << " | Avg: " << report.averageFitness
+              << " | Saved: " << report.stepsSaved << " steps"
+              << " | Topology: ";
+    for (size_t l = 0; l < m_topology.size(); ++l) {
+        std::cout << (l > 0 ? "-" : "") << m_topology[l];
     }
-    m_population.evolve();
+    std::cout << std::endl;
 }
 
 void Trainer::renderGraph(SDL_Renderer* renderer, int x, int y, int w, int h) {
@@ -264,27 +412,32 @@ void Trainer::renderGraph(SDL_Renderer* renderer, int x, int y, int w, int h) {
     SDL_SetRenderDrawColor(renderer, 255, 255, 255, 255);
     SDL_RenderDrawRect(renderer, &bg);
 
-    if (m_fitnessHistory.empty()) return;
+    size_t records = m_logReader.refresh();
+    if (records < 2) return;
+
+    // one sample per pixel column at most, so drawing cost and the pages
+    // touched stay bounded however long the run gets
+    size_t numPoints = std::min(records, (size_t)w);
+    auto recordAt = [&](size_t point) -> const GenerationRecord& {
+        return m_logReader[point * (records - 1) / (numPoints - 1)];
+    };
 
     double maxVal = 0.0;
-    for (double f : m_fitnessHistory) {
-        if (f > maxVal) maxVal = f;
+    for (size_t i = 0; i < numPoints; ++i) {
+        if (recordAt(i).average > maxVal) maxVal = recordAt(i).average;
     }
     if (maxVal < 1.0) maxVal = 1.0;
 
     SDL_SetRenderDrawColor(renderer, 0, 255, 0, 255);
-    
-    int numPoints = m_fitnessHistory.size();
-    if (numPoints < 2) return;
 
     double xStep = (double)w / (double)(numPoints - 1);
 
-    for (int i = 0; i < numPoints - 1; ++i) {
+    for (size_t i = 0; i + 1 < numPoints; ++i) {
         int x1 = x + (int)(i * xStep);
         int x2 = x + (int)((i + 1) * xStep);
         
-        int y1 = (y + h) - (int)((m_fitnessHistory[i] / maxVal) * h);
-        int y2 = (y + h) - (int)((m_fitnessHistory[i+1] / maxVal) * h);
+        int y1 = (y + h) - (int)((recordAt(i).average / maxVal) * h);
+        int y2 = (y + h) - (int)((recordAt(i + 1).average / maxVal) * h);
 
         SDL_RenderDrawLine(renderer, x1, y1, x2, y2);
     }
@@ -0,0 +1,290 @@
+#include "TrainingRun.hpp"
+#include "Trace.hpp"
+#include "Random.hpp"
+#include "Metrics.hpp"
+#include <random>
+#include <algorithm>
+#include <chrono>
+#include <climits>
+#include <cmath>
+#include <functional>
+
+// keeps the common seeds apart from the per-individual ones
+const uint64_t COMMON_SEED_SALT = 0xC0330C5EED5ull;
+
+static uint64_t randomSeed() {
+    std::random_device device;
+    return ((uint64_t)device() << 32) | device();
+}
+
+// a given seed is split into one stream for the population and one for the games
+TrainingRun::TrainingRun(size_t popSize, const std::vector<size_t>& topology, const EvalConfig& evalConfig, ThreadPool& pool,
+                         OptimizerType optimizerType, GenePrecision precision, uint64_t seed)
+    : pool(pool), evalConfig(evalConfig), topology(topology),
+      population(popSize, topology, pool, optimizerType, evalConfig.activations, precision,
+                 seed != 0 ? streamKey(seed, 0, 1) : 0),
+      seed(seed != 0 ? streamKey(seed, 0, 0) : randomSeed()) {
+    pool.setMetrics(&trainingMetrics());
+}
+
+void TrainingRun::reset(size_t popSize, const std::vector<size_t>& newTopology) {
+    topology = newTopology;
+    population.reset(popSize, newTopology);
+    seed = randomSeed();
+}
+
+void TrainingRun::morph(const Morph& morph) {
+    population.morph(morph);
+    // the worker contexts rebuild their networks on the next game
+    topology = population.getTopology();
+}
+
+bool TrainingRun::openLog(const std::string& path) {
+    return log.open(path, topology);
+}
+
+void TrainingRun::closeLog() {
+    log.close();
+}
+
+// nearest-rank quantile of an ascending list
+static double quantile(const std::vector<double>& sorted, double q) {
+    size_t index = (size_t)(q * (double)(sorted.size() - 1) + 0.5);
+    return sorted[index];
+}
+
+void TrainingRun::writeLogRecord(const GenerationReport& report, const std::vector<double>& champion,
+                                 double evalSeconds, double evolveSeconds) {
+    sortedFitness.resize(results.size());
+    for (size_t i = 0; i < results.size(); ++i) {
+        sortedFitness[i] = results[i].fitness;
+    }
+    std::sort(sortedFitness.begin(), sortedFitness.end());
+
+    GenerationRecord record = {};
+    record.generation = report.generation;
+    record.evaluations = report.evaluations;
+    record.steps = (uint64_t)report.steps;
+    record.stepsSaved = (uint64_t)report.stepsSaved;
+    record.promoted = report.promoted;
+    record.championHash = hashGenes(champion.data(), champion.size());
+    record.best = report.bestFitness;
+    record.average = report.averageFitness;
+    record.median = quantile(sortedFitness, 0.5);
+    record.p10 = quantile(sortedFitness, 0.1);
+    record.p25 = quantile(sortedFitness, 0.25);
+    record.p75 = quantile(sortedFitness, 0.75);
+    record.p90 = quantile(sortedFitness, 0.9);
+    record.worst = sortedFitness.front();
+    record.evalSeconds = evalSeconds;
+    record.evolveSeconds = evolveSeconds;
+    log.append(record);
+}
+
+void TrainingRun::publishMetrics(const GenerationReport& report) {
+    const auto relaxed = std::memory_order_relaxed;
+    TrainingMetrics& metrics = trainingMetrics();
+    metrics.generation.store(report.generation, relaxed);
+    metrics.generations.fetch_add(1, relaxed);
+    metrics.evaluations.fetch_add(report.evaluations, relaxed);
+    metrics.steps.fetch_add((uint64_t)report.steps, relaxed);
+    metrics.stepsSaved.fetch_add((uint64_t)report.stepsSaved, relaxed);
+    metrics.bestFitness.store(report.bestFitness, relaxed);
+    metrics.averageFitness.store(report.averageFitness, relaxed);
+    metrics.bestScore.store(report.bestScore, relaxed);
+    metrics.generationSeconds.store(report.seconds, relaxed);
+    metrics.stepsPerSecond.store(report.seconds > 0.0 ? (double)report.steps / report.seconds : 0.0, relaxed);
+}
+
+EvalContext& TrainingRun::contextFor(size_t worker) {
+    // a worker runs one chunk at a time, so its context is never shared
+    if (!contexts[worker]) contexts[worker] = std::make_unique<EvalContext>(evalConfig);
+    contexts[worker]->recordTrajectories(trajectoryWriter, worker);
+    return *contexts[worker];
+}
+
+GameResult TrainingRun::play(EvalContext& context, size_t individual, int stepLimit) {
+    TrainingMetrics& metrics = trainingMetrics();
+    uint64_t started = metrics.enabled.load(std::memory_order_relaxed) ? metricsClock() : 0;
+
+    const double* genes = population.getGeneRow(individual, context.geneScratch(population.getGeneCount()));
+    context.setGameTag((uint32_t)population.getGeneration(), (uint32_t)individual);
+    GameResult result;
+    if (commonSeeds.size() > 1) {
+        result = context.evaluateEpisodes(topology, genes, population.getGeneCount(), commonSeeds.data(), stepLimit);
+    } else {
+        uint64_t gameSeed = streamKey(seed, population.getGeneration(), individual);
+        result = context.evaluate(topology, genes, population.getGeneCount(), gameSeed, stepLimit);
+    }
+
+    if (started != 0) metrics.recordEvaluation(metricsClock() - started);
+    return result;
+}
+
+void TrainingRun::playScreening(int stepLimit) {
+    pool.parallelFor(population.size(), 0, [this, stepLimit](size_t begin, size_t end, size_t worker) {
+        EvalContext& context = contextFor(worker);
+        for (size_t i = begin; i < end; ++i) {
+            results[i] = play(context, i, stepLimit);
+        }
+    });
+}
+
+// full games for promotedList[first...], counted on top of the screening steps
+void TrainingRun::playPromoted(size_t first) {
+    pool.parallelFor(promotedList.size() - first, 0, [this, first](size_t begin, size_t end, size_t worker) {
+        EvalContext& context = contextFor(worker);
+        for (size_t k = first + begin; k < first + end; ++k) {
+            size_t i = promotedList[k];
+            GameResult full = play(context, i, INT_MAX);
+            full.steps += results[i].steps;
+            full.stepsSaved += results[i].stepsSaved;
+            results[i] = full;
+        }
+    });
+}
+
+// Adds to promotedList every cut, unpromoted game whose upper confidence bound
+// reaches the elite. Returns how many were added.
+size_t TrainingRun::promoteByConfidence(size_t screened) {
+    // least squares of full fitness on screening fitness over the promoted cut games
+    double n = 0.0, sx = 0.0, sy = 0.0, sxx = 0.0, sxy = 0.0, syy = 0.0;
+    for (size_t k = 0; k < screened; ++k) {
+        size_t i = promotedList[k];
+        if (screenFitness[i] < 0.0) continue;
+        double x = screenFitness[i];
+        double y = results[i].fitness;
+        n += 1.0;
+        sx += x;
+        sy += y;
+        sxx += x * x;
+        sxy += x * y;
+        syy += y * y;
+    }
+    if (n < 2.0) return 0;
+    double varianceX = sxx - sx * sx / n;
+    double slope = varianceX > 0.0 ? (sxy - sx * sy / n) / varianceX : 0.0;
+    double intercept = (sy - slope * sx) / n;
+    double residual = syy - sy * sy / n - slope * (sxy - sx * sy / n);
+    double deviation = std::sqrt(std::max(0.0, residual) / (n - 1.0));
+
+    // fitness of the eliteFraction-th best individual so far
+    sortedFitness.resize(results.size());
+    for (size_t i = 0; i < results.size(); ++i) sortedFitness[i] = results[i].fitness;
+    size_t elite = std::max<size_t>(1, (size_t)std::ceil(screening.eliteFraction * (double)results.size()));
+    elite = std::min(elite, sortedFitness.size());
+    std::nth_element(sortedFitness.begin(), sortedFitness.begin() + (elite - 1), sortedFitness.end(),
+                     std::greater<double>());
+    double threshold = sortedFitness[elite - 1];
+
+    size_t added = 0;
+    for (size_t i = 0; i < results.size(); ++i) {
+        if (promoted[i] || !results[i].truncated) continue;
+        if (intercept + slope * screenFitness[i] + screening.ucb * deviation >= threshold) {
+            promoted[i] = 1;
+            promotedList.push_back(i);
+            ++added;
+        }
+    }
+    return added;
+}
+
+GenerationReport TrainingRun::step() {
+    TRACE_ZONE("TrainingRun::step");
+    auto start = std::chrono::steady_clock::now();
+    size_t popSize = population.size();
+    results.resize(popSize);
+
+    contexts.resize(pool.size());
+    // common random numbers: one set of food seeds for the whole generation
+    size_t episodes = (size_t)std::max(1, evalConfig.episodes);
+    commonSeeds.resize(episodes > 1 ? episodes : 0);
+    for (size_t k = 0; k < commonSeeds.size(); ++k) {
+        commonSeeds[k] = streamKey(seed ^ COMMON_SEED_SALT, population.getGeneration(), k);
+    }
+
+    bool screen = screening.screenSteps > 0 && screening.screenSteps < evalConfig.maxSteps;
+    playScreening(screen ? screening.screenSteps : INT_MAX);
+
+    size_t promotedCount = 0;
+    size_t screenedOut = 0;
+    if (screen) {
+        TRACE_ZONE("TrainingRun::promote");
+        // screening fitness of the cut games, -1 for games that are already exact
+        screenFitness.resize(popSize);
+        ranking.resize(popSize);
+        for (size_t i = 0; i < popSize; ++i) {
+            screenFitness[i] = results[i].truncated ? results[i].fitness : -1.0;
+            ranking[i] = i;
+        }
+
+        size_t top = std::max<size_t>(1, (size_t)std::ceil(screening.promoteFraction * (double)popSize));
+        top = std::min(top, popSize);
+        std::partial_sort(ranking.begin(), ranking.begin() + top, ranking.end(), [this](size_t a, size_t b) {
+            if (results[a].fitness != results[b].fitness) return results[a].fitness > results[b].fitness;
+            return a < b;
+        });
+        promoted.assign(popSize, 0);
+        promotedList.clear();
+        for (size_t k = 0; k < top; ++k) {
+            size_t i = ranking[k];
+            // games that ended within the screening budget are already exact
+            if (results[i].truncated) {
+                promoted[i] = 1;
+                promotedList.push_back(i);
+            }
+        }
+        playPromoted(0);
+
+        size_t screened = promotedList.size();
+        if (screening.ucb > 0.0 && promoteByConfidence(screened) > 0) {
+            playPromoted(screened);
+        }
+
+        promotedCount = promotedList.size();
+        for (const GameResult& result : results) {
+            if (result.truncated) ++screenedOut;
+        }
+    }
+
+    for (size_t i = 0; i < popSize; ++i) {
+        population.setFitness(i, results[i].fitness);
+    }
+
+    GenerationReport report;
+    FitnessStats stats = population.summarize();
+    report.generation = population.getGeneration();
+    report.bestFitness = stats.best;
+    report.averageFitness = stats.average;
+    report.bestScore = 0;
+    report.evaluations = results.size();
+    report.steps = 0;
+    report.stepsSaved = 0;
+    report.promoted = promotedCount;
+    report.screenedOut = screenedOut;
+    for (const GameResult& result : results) {
+        if (result.score > report.bestScore) report.bestScore = result.score;
+        report.steps += result.steps;
+        report.stepsSaved += result.stepsSaved;
+    }
+
+    auto evaluated = std::chrono::steady_clock::now();
+    std::vector<double> champion;
+    bool logging = log.isOpen() && !results.empty();
+    if (logging) {
+        // the log hashes this generation's champion, which evolve() overwrites
+        champion = population.getGenes(stats.bestIndex);
+    }
+
+    population.evolve();
+
+    auto evolved = std::chrono::steady_clock::now();
+    report.seconds = std::chrono::duration<double>(evolved - start).count();
+    publishMetrics(report);
+    if (logging) {
+        writeLogRecord(report, champion,
+                       std::chrono::duration<double>(evaluated - start).count(),
+                       std::chrono::duration<double>(evolved - evaluated).count());
+    }
+    return report;
+}
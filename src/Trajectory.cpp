@@ -0,0 +1,540 @@
+#include "Trajectory.hpp"
+#include "Random.hpp"
+#include "Trace.hpp"
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+#include <iostream>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+static const char TRAJECTORY_MAGIC[8] = { 'S', 'N', 'A', 'K', 'T', 'R', 'A', 'J' };
+static const char FOOTER_MAGIC[8] = { 'T', 'R', 'A', 'J', 'E', 'N', 'D', '1' };
+static const uint32_t CHUNK_MAGIC = 0x4B4E4843; // "CHNK"
+static const uint32_t TRAJECTORY_VERSION = 1;
+// generation, individual, episode, flags, action, step, reward
+static const size_t FIXED_COLUMNS = 7;
+static const size_t FIXED_WIDTHS[FIXED_COLUMNS] = { 4, 4, 2, 1, 1, 4, 4 };
+static const uint64_t SAMPLE_SALT = 0x7A7EC5A3B1E5EEDull;
+
+static std::vector<size_t> columnWidthsFor(size_t inputCount, size_t outputCount) {
+    std::vector<size_t> widths(FIXED_WIDTHS, FIXED_WIDTHS + FIXED_COLUMNS);
+    widths.insert(widths.end(), inputCount + outputCount, sizeof(float));
+    return widths;
+}
+
+// ==== Column codec ====
+//
+// Each column is delta coded (wrapping integer differences of consecutive
+// elements, so repeated values and slowly changing floats become small),
+// split into byte planes (all low bytes, then the next, ...) so the mostly
+// zero high planes form long runs, then run-length coded: a control byte
+// below 128 copies control + 1 literal bytes, from 128 up it repeats the
+// next byte control - 125 times.
+
+static uint32_t loadElement(const uint8_t* data, size_t width) {
+    uint32_t value = 0;
+    std::memcpy(&value, data, width);
+    return value;
+}
+
+static void storeElement(uint8_t* data, size_t width, uint32_t value) {
+    std::memcpy(data, &value, width);
+}
+
+static void encodeRuns(const uint8_t* data, size_t size, std::vector<uint8_t>& out) {
+    size_t i = 0;
+    while (i < size) {
+        size_t run = 1;
+        while (i + run < size && run < 130 && data[i + run] == data[i]) ++run;
+        if (run >= 3) {
+            out.push_back((uint8_t)(run + 125));
+            out.push_back(data[i]);
+            i += run;
+            continue;
+        }
+        // literals up to the next run of three
+        size_t start = i;
+        while (i < size && i - start < 128) {
+            if (i + 2 < size && data[i] == data[i + 1] && data[i] == data[i + 2]) break;
+            ++i;
+        }
+        out.push_back((uint8_t)(i - start - 1));
+        out.insert(out.end(), data + start, data + i);
+    }
+}
+
+static bool decodeRuns(const uint8_t* data, size_t size, uint8_t* out, size_t expected) {
+    size_t written = 0;
+    size_t i = 0;
+    while (i < size) {
+        uint8_t control = data[i++];
+        if (control < 128) {
+            size_t count = (size_t)control + 1;
+            if (i + count > size || written + count > expected) return false;
+            std::memcpy(out + written, data + i, count);
+            i += count;
+            written += count;
+        } else {
+            size_t count = (size_t)control - 125;
+            if (i >= size || written + count > expected) return false;
+            std::memset(out + written, data[i++], count);
+            written += count;
+        }
+    }
+    return written == expected;
+}
+
+static void encodeColumn(const uint8_t* column, size_t rows, size_t width,
+                         std::vector<uint8_t>& scratch, std::vector<uint8_t>& out) {
+    scratch.resize(rows * width);
+    uint32_t previous = 0;
+    for (size_t r = 0; r < rows; ++r) {
+        uint32_t value = loadElement(column + r * width, width);
+        uint32_t delta = value - previous;
+        previous = value;
+        for (size_t b = 0; b < width; ++b) {
+            scratch[b * rows + r] = (uint8_t)(delta >> (8 * b));
+        }
+    }
+    encodeRuns(scratch.data(), scratch.size(), out);
+}
+
+static bool decodeColumn(const uint8_t* data, size_t size, size_t rows, size_t width,
+                         std::vector<uint8_t>& scratch, uint8_t* column) {
+    scratch.resize(rows * width);
+    if (!decodeRuns(data, size, scratch.data(), scratch.size())) return false;
+    uint32_t previous = 0;
+    for (size_t r = 0; r < rows; ++r) {
+        uint32_t delta = 0;
+        for (size_t b = 0; b < width; ++b) {
+            delta |= (uint32_t)scratch[b * rows + r] << (8 * b);
+        }
+        previous += delta;
+        storeElement(column + r * width, width, previous);
+    }
+    return true;
+}
+
+// ==== TrajectoryRing ====
+
+TrajectoryRing::TrajectoryRing(size_t capacity, size_t inputCount, size_t outputCount, bool dropWhenFull)
+    : capacity(capacity), inputCount(inputCount), outputCount(outputCount), dropWhenFull(dropWhenFull),
+      head(0), tail(0), dropped(0), stallNanoseconds(0) {
+    rowBytes = 0;
+    for (size_t width : columnWidthsFor(inputCount, outputCount)) rowBytes += width;
+    storage.resize(capacity * rowBytes);
+}
+
+bool TrajectoryRing::push(const TrajectoryStep& step, const double* inputs, const double* outputs) {
+    size_t position = head.load(std::memory_order_relaxed);
+    if (position - tail.load(std::memory_order_acquire) == capacity) {
+        if (dropWhenFull) {
+            dropped++;
+            return false;
+        }
+        auto start = std::chrono::steady_clock::now();
+        while (position - tail.load(std::memory_order_acquire) == capacity) {
+            std::this_thread::yield();
+        }
+        stallNanoseconds += (uint64_t)std::chrono::duration_cast<std::chrono::nanoseconds>(
+            std::chrono::steady_clock::now() - start).count();
+    }
+
+    // rows are packed column by column in the same order as the file
+    uint8_t* row = storage.data() + (position & (capacity - 1)) * rowBytes;
+    std::memcpy(row, &step.generation, 4);
+    std::memcpy(row + 4, &step.individual, 4);
+    std::memcpy(row + 8, &step.episode, 2);
+    row[10] = step.flags;
+    row[11] = step.action;
+    std::memcpy(row + 12, &step.step, 4);
+    std::memcpy(row + 16, &step.reward, 4);
+    uint8_t* values = row + 20;
+    for (size_t i = 0; i < inputCount; ++i) {
+        float value = (float)inputs[i];
+        std::memcpy(values + i * sizeof(float), &value, sizeof(float));
+    }
+    for (size_t i = 0; i < outputCount; ++i) {
+        float value = (float)outputs[i];
+        std::memcpy(values + (inputCount + i) * sizeof(float), &value, sizeof(float));
+    }
+
+    head.store(position + 1, std::memory_order_release);
+    return true;
+}
+
+// ==== TrajectoryWriter ====
+
+TrajectoryWriter::TrajectoryWriter()
+    : stopping(false), fd(-1), sampleThreshold(0), rowBytes(0), stagedRows(0),
+      fileOffset(0), rowCount(0), rawBytes(0), compressedBytes(0) {}
+
+TrajectoryWriter::~TrajectoryWriter() {
+    close();
+}
+
+bool TrajectoryWriter::open(const std::string& path, size_t inputCount, size_t outputCount, size_t producers,
+                            const TrajectoryOptions& options) {
+    close();
+    fd = ::open(path.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644);
+    if (fd < 0) return false;
+
+    columnWidths = columnWidthsFor(inputCount, outputCount);
+    columnOffsets.clear();
+    rowBytes = 0;
+    for (size_t width : columnWidths) {
+        columnOffsets.push_back(rowBytes);
+        rowBytes += width;
+    }
+
+    double rate = options.sampleRate < 0.0 ? 0.0 : (options.sampleRate > 1.0 ? 1.0 : options.sampleRate);
+    sampleThreshold = rate >= 1.0 ? UINT64_MAX : (uint64_t)(rate * 18446744073709551616.0);
+
+    // a power-of-two ring per producer, at least a thousand rows each
+    size_t perRing = options.bufferBytes / std::max<size_t>(1, producers) / rowBytes;
+    size_t capacity = 1024;
+    while (capacity * 2 <= perRing) capacity *= 2;
+    rings.clear();
+    for (size_t p = 0; p < producers; ++p) {
+        rings.push_back(std::make_unique<TrajectoryRing>(capacity, inputCount, outputCount, options.dropWhenFull));
+    }
+
+    columns.assign(columnWidths.size(), std::vector<uint8_t>());
+    for (size_t c = 0; c < columns.size(); ++c) {
+        columns[c].resize(CHUNK_ROWS * columnWidths[c]);
+    }
+    stagedRows = 0;
+    chunkOffsets.clear();
+    rowCount = 0;
+    rawBytes = 0;
+    compressedBytes = 0;
+
+    TrajectoryFileHeader header = {};
+    std::memcpy(header.magic, TRAJECTORY_MAGIC, sizeof(TRAJECTORY_MAGIC));
+    header.version = TRAJECTORY_VERSION;
+    header.inputCount = (uint32_t)inputCount;
+    header.outputCount = (uint32_t)outputCount;
+    header.columnCount = (uint32_t)columnWidths.size();
+    header.chunkRows = (uint32_t)CHUNK_ROWS;
+    fileOffset = 0;
+    if (!writeAll(&header, sizeof(header))) {
+        ::close(fd);
+        fd = -1;
+        return false;
+    }
+
+    stopping.store(false);
+    writerThread = std::thread(&TrajectoryWriter::run, this);
+    return true;
+}
+
+bool TrajectoryWriter::sampleGame(uint64_t gameSeed) const {
+    return sampleThreshold == UINT64_MAX || counterRandom(SAMPLE_SALT, gameSeed) < sampleThreshold;
+}
+
+void TrajectoryWriter::run() {
+    setTraceThreadName("trajectory writer");
+    while (true) {
+        // read the flag before draining, so rows pushed before close() are seen
+        bool stop = stopping.load(std::memory_order_acquire);
+        size_t drained = 0;
+        for (auto& ring : rings) {
+            drained += drain(*ring);
+        }
+        if (stop && drained == 0) break;
+        if (drained == 0) {
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        }
+    }
+    if (stagedRows > 0) writeChunk();
+}
+
+size_t TrajectoryWriter::drain(TrajectoryRing& ring) {
+    size_t position = ring.tail.load(std::memory_order_relaxed);
+    size_t available = ring.head.load(std::memory_order_acquire) - position;
+    for (size_t k = 0; k < available; ++k) {
+        const uint8_t* row = ring.storage.data() + ((position + k) & (ring.capacity - 1)) * rowBytes;
+        for (size_t c = 0; c < columns.size(); ++c) {
+            std::memcpy(columns[c].data() + stagedRows * columnWidths[c], row + columnOffsets[c], columnWidths[c]);
+        }
+        if (++stagedRows == CHUNK_ROWS) {
+            // hand the slots back before the slow part
+            ring.tail.store(position + k + 1, std::memory_order_release);
+            writeChunk();
+        }
+    }
+    ring.tail.store(position + available, std::memory_order_release);
+    return available;
+}
+
+void TrajectoryWriter::writeChunk() {
+    TRACE_ZONE("TrajectoryWriter::writeChunk");
+    TrajectoryChunkHeader header = { CHUNK_MAGIC, (uint32_t)stagedRows };
+    std::vector<uint32_t> sizes(columns.size());
+    encoded.clear();
+    for (size_t c = 0; c < columns.size(); ++c) {
+        size_t before = encoded.size();
+        encodeColumn(columns[c].data(), stagedRows, columnWidths[c], scratch, encoded);
+        sizes[c] = (uint32_t)(encoded.size() - before);
+    }
+
+    chunkOffsets.push_back(fileOffset);
+    bool written = writeAll(&header, sizeof(header)) && writeAll(sizes.data(), sizes.size() * sizeof(uint32_t))
+                   && writeAll(encoded.data(), encoded.size());
+    if (!written) std::cerr << "Trajectory writer: write failed" << std::endl;
+
+    rowCount += stagedRows;
+    rawBytes += stagedRows * rowBytes;
+    compressedBytes += sizeof(header) + sizes.size() * sizeof(uint32_t) + encoded.size();
+    stagedRows = 0;
+}
+
+bool TrajectoryWriter::writeAll(const void* data, size_t size) {
+    const char* bytes = static_cast<const char*>(data);
+    while (size > 0) {
+        ssize_t written = ::write(fd, bytes, size);
+        if (written <= 0) return false;
+        bytes += written;
+        size -= (size_t)written;
+        fileOffset += (uint64_t)written;
+    }
+    return true;
+}
+
+void TrajectoryWriter::close() {
+    if (!writerThread.joinable()) return;
+    stopping.store(true, std::memory_order_release);
+    writerThread.join();
+
+    TrajectoryFileFooter footer = {};
+    footer.indexOffset = fileOffset;
+    footer.chunkCount = chunkOffsets.size();
+    footer.rowCount = rowCount;
+    std::memcpy(footer.magic, FOOTER_MAGIC, sizeof(FOOTER_MAGIC));
+    writeAll(chunkOffsets.data(), chunkOffsets.size() * sizeof(uint64_t));
+    writeAll(&footer, sizeof(footer));
+    ::close(fd);
+    fd = -1;
+
+    uint64_t dropped = 0;
+    double stallSeconds = 0.0;
+    for (const auto& ring : rings) {
+        dropped += ring->dropped;
+        stallSeconds += (double)ring->stallNanoseconds * 1e-9;
+    }
+    std::cout << "Trajectories: " << rowCount << " rows in " << chunkOffsets.size() << " chunks, "
+              << compressedBytes << " bytes (" << (compressedBytes ? (double)rawBytes / (double)compressedBytes : 0.0)
+              << "x compression), " << dropped << " dropped, " << stallSeconds << " s waiting for the writer"
+              << std::endl;
+    rings.clear();
+    columns.clear();
+}
+
+// ==== TrajectoryReader ====
+
+TrajectoryReader::TrajectoryReader()
+    : fd(-1), map(nullptr), mappedBytes(0), inputCount(0), outputCount(0), columnCount(0), chunkRows(0),
+      rowCount(0) {}
+
+TrajectoryReader::~TrajectoryReader() {
+    close();
+}
+
+bool TrajectoryReader::open(const std::string& path) {
+    close();
+    fd = ::open(path.c_str(), O_RDONLY);
+    if (fd < 0) return false;
+    struct stat info;
+    if (fstat(fd, &info) != 0 || (size_t)info.st_size < sizeof(TrajectoryFileHeader)) {
+        close();
+        return false;
+    }
+    mappedBytes = (size_t)info.st_size;
+    void* mapped = mmap(nullptr, mappedBytes, PROT_READ, MAP_SHARED, fd, 0);
+    if (mapped == MAP_FAILED) {
+        mappedBytes = 0;
+        close();
+        return false;
+    }
+    map = static_cast<const uint8_t*>(mapped);
+
+    TrajectoryFileHeader header;
+    std::memcpy(&header, map, sizeof(header));
+    if (std::memcmp(header.magic, TRAJECTORY_MAGIC, sizeof(TRAJECTORY_MAGIC)) != 0
+        || header.version != TRAJECTORY_VERSION
+        || header.columnCount != FIXED_COLUMNS + header.inputCount + header.outputCount) {
+        close();
+        return false;
+    }
+    inputCount = header.inputCount;
+    outputCount = header.outputCount;
+    columnCount = header.columnCount;
+    chunkRows = header.chunkRows;
+
+    // prefer the index; without one, walk the chunk headers
+    chunks.clear();
+    rowCount = 0;
+    TrajectoryFileFooter footer;
+    bool indexed = false;
+    if (mappedBytes >= sizeof(header) + sizeof(footer)) {
+        std::memcpy(&footer, map + mappedBytes - sizeof(footer), sizeof(footer));
+        const uint64_t indexBytes = mappedBytes - sizeof(header) - sizeof(footer);
+        indexed = std::memcmp(footer.magic, FOOTER_MAGIC, sizeof(FOOTER_MAGIC)) == 0
+                  && footer.chunkCount <= indexBytes / sizeof(uint64_t)
+                  && footer.indexOffset == mappedBytes - sizeof(footer) - footer.chunkCount * sizeof(uint64_t);
+    }
+    if (indexed) {
+        // every indexed chunk must be whole and start where the previous
+        // one ends, the last one ending at the index
+        chunks.resize(footer.chunkCount);
+        std::memcpy(chunks.data(), map + footer.indexOffset, chunks.size() * sizeof(uint64_t));
+        chunks.push_back(footer.indexOffset);
+        uint64_t expected = sizeof(header);
+        for (size_t k = 0; k + 1 < chunks.size(); ++k) {
+            uint32_t rows;
+            if (chunks[k] != expected || chunkEnd(chunks[k], rows) != chunks[k + 1]) {
+                close();
+                return false;
+            }
+            rowCount += rows;
+            expected = chunks[k + 1];
+        }
+        if (expected != footer.indexOffset || rowCount != footer.rowCount) {
+            close();
+            return false;
+        }
+        return true;
+    }
+
+    // an unfinished file: keep the whole chunks up to the first damaged one
+    uint64_t offset = sizeof(header);
+    while (offset < mappedBytes) {
+        uint32_t rows;
+        uint64_t end = chunkEnd(offset, rows);
+        if (end == 0) break;
+        chunks.push_back(offset);
+        rowCount += rows;
+        offset = end;
+    }
+    chunks.push_back(offset);
+    return true;
+}
+
+uint64_t TrajectoryReader::chunkEnd(uint64_t offset, uint32_t& rows) const {
+    const size_t headerBytes = sizeof(TrajectoryChunkHeader) + columnCount * sizeof(uint32_t);
+    if (offset > mappedBytes || mappedBytes - offset < headerBytes) return 0;
+    TrajectoryChunkHeader chunk;
+    std::memcpy(&chunk, map + offset, sizeof(chunk));
+    if (chunk.magic != CHUNK_MAGIC || chunk.rows > chunkRows) return 0;
+    uint64_t end = offset + headerBytes;
+    for (size_t c = 0; c < columnCount; ++c) {
+        uint32_t size;
+        std::memcpy(&size, map + offset + sizeof(chunk) + c * sizeof(uint32_t), sizeof(size));
+        if (mappedBytes - end < size) return 0;
+        end += size;
+    }
+    rows = chunk.rows;
+    return end;
+}
+
+void TrajectoryReader::close() {
+    if (map) {
+        munmap(const_cast<uint8_t*>(map), mappedBytes);
+        map = nullptr;
+        mappedBytes = 0;
+    }
+    if (fd >= 0) {
+        ::close(fd);
+        fd = -1;
+    }
+    chunks.clear();
+}
+
+size_t TrajectoryReader::getChunkBytes(size_t index) const {
+    return (size_t)(chunks[index + 1] - chunks[index]);
+}
+
+bool TrajectoryReader::readChunk(size_t index, TrajectoryChunk& chunk) const {
+    if (index + 1 >= chunks.size()) return false;
+    const uint8_t* base = map + chunks[index];
+    TrajectoryChunkHeader header;
+    std::memcpy(&header, base, sizeof(header));
+    if (header.magic != CHUNK_MAGIC) return false;
+
+    const size_t rows = header.rows;
+    chunk.rows = rows;
+    chunk.generation.resize(rows);
+    chunk.individual.resize(rows);
+    chunk.episode.resize(rows);
+    chunk.flags.resize(rows);
+    chunk.action.resize(rows);
+    chunk.step.resize(rows);
+    chunk.reward.resize(rows);
+    chunk.inputs.resize(rows * inputCount);
+    chunk.outputs.resize(rows * outputCount);
+
+    uint8_t* targets[FIXED_COLUMNS] = {
+        reinterpret_cast<uint8_t*>(chunk.generation.data()), reinterpret_cast<uint8_t*>(chunk.individual.data()),
+        reinterpret_cast<uint8_t*>(chunk.episode.data()), chunk.flags.data(), chunk.action.data(),
+        reinterpret_cast<uint8_t*>(chunk.step.data()), reinterpret_cast<uint8_t*>(chunk.reward.data())
+    };
+
+    const uint8_t* sizes = base + sizeof(header);
+    const uint8_t* data = sizes + columnCount * sizeof(uint32_t);
+    const uint8_t* end = map + chunks[index + 1];
+    std::vector<uint8_t> scratch;
+    for (size_t c = 0; c < columnCount; ++c) {
+        uint32_t size;
+        std::memcpy(&size, sizes + c * sizeof(uint32_t), sizeof(size));
+        if (data + size > end) return false;
+        uint8_t* target;
+        size_t width;
+        if (c < FIXED_COLUMNS) {
+            target = targets[c];
+            width = FIXED_WIDTHS[c];
+        } else if (c < FIXED_COLUMNS + inputCount) {
+            target = reinterpret_cast<uint8_t*>(chunk.inputs.data() + (c - FIXED_COLUMNS) * rows);
+            width = sizeof(float);
+        } else {
+            target = reinterpret_cast<uint8_t*>(chunk.outputs.data() + (c - FIXED_COLUMNS - inputCount) * rows);
+            width = sizeof(float);
+        }
+        if (!decodeColumn(data, size, rows, width, scratch, target)) return false;
+        data += size;
+    }
+    return true;
+}
+
+int summarizeTrajectories(const std::string& path) {
+    TrajectoryReader reader;
+    if (!reader.open(path)) {
+        std::cerr << "Could not open trajectory file " << path << std::endl;
+        return 1;
+    }
+
+    std::cout << "chunk,rows,bytes,generations,mean_reward" << std::endl;
+    TrajectoryChunk chunk;
+    size_t totalBytes = 0;
+    for (size_t k = 0; k < reader.getChunkCount(); ++k) {
+        if (!reader.readChunk(k, chunk)) {
+            std::cerr << "Chunk " << k << " is damaged" << std::endl;
+            return 1;
+        }
+        double reward = 0.0;
+        for (float r : chunk.reward) reward += r;
+        totalBytes += reader.getChunkBytes(k);
+        std::cout << k << ',' << chunk.rows << ',' << reader.getChunkBytes(k) << ','
+                  << chunk.generation.front() << '-' << chunk.generation.back() << ','
+                  << (chunk.rows ? reward / (double)chunk.rows : 0.0) << std::endl;
+    }
+    size_t rowBytes = 0;
+    for (size_t width : columnWidthsFor(reader.getInputCount(), reader.getOutputCount())) rowBytes += width;
+    std::cout << reader.getRowCount() << " rows, " << reader.getInputCount() << " inputs, "
+              << reader.getOutputCount() << " outputs, "
+              << (totalBytes ? (double)(reader.getRowCount() * rowBytes) / (double)totalBytes : 0.0)
+              << "x compression" << std::endl;
+    return 0;
+}
@@ -3,16 +3,22 @@
 #include <algorithm>
 #include <iterator>
 #include <cmath>
+#include <stdexcept>
+#include <climits>
 
 #include "World.hpp"
 #include "Snake.hpp"
 #include "Food.hpp"
+#include "Trace.hpp"
+#include "Zobrist.hpp"
 
 World::World(Snake& snake, Food& food, int width, int height) 
     : snake(snake), food(food), width(width), height(height) {
     
     this->cell_size = 20;
     this->score = 0;
+    this->epoch = 0;
+    this->died = false;
     food.move_randomly(width / cell_size, height / cell_size);
 }
 
@@ -34,9 +40,11 @@ void World::draw_grid(SDL_Renderer *renderer) {
 }
 
 void World::update() {
+    TRACE_ZONE("World::update");
     snake.update();
 
-    if(snake_hit_wall() || snake.hit_itself()) {
+    died = snake_hit_wall() || snake.hit_itself();
+    if(died) {
         reset();
     }
 
@@ -57,6 +65,7 @@ void World::update() {
             }
         } while(onSnake);
         score++;
+        epoch++;
     }
 }
 
@@ -86,14 +95,11 @@ void World::handle_input(SDL_Event& event) {
 }
 
 void World::reset() {
-    this->snake.body.clear();
-    this->snake.body.push_front({25, 25});
-    this->snake.body.push_back({24, 25});
-    this->snake.body.push_back({23, 25});
-    this->snake.direction = RIGHT;
+    this->snake.reset();
     food.move_randomly(width / cell_size, height / cell_size);
 
     this->score = 0;
+    this->epoch++;
 }
 
 bool World::snake_is_eating_food() {
@@ -106,7 +112,15 @@ bool World::snake_hit_wall() {
            head.y < 0 || head.y >= height / cell_size;
 }
 
-std::vector<double> World::get_game_state() {
+void World::get_game_state(size_t input_count, double* inputs) {
+    if (input_count == RAY_INPUT_NODES) {
+        get_ray_state(inputs);
+        return;
+    }
+    if (input_count != BASIC_INPUT_NODES) {
+        throw std::invalid_argument("No sensor layout has this many inputs.");
+    }
+
     Point head = snake.body.front(); // head
     Point tail = snake.body.back(); // tail
     Direction dir = snake.direction; // heading
@@ -137,12 +151,12 @@ std::vector<double> World::get_game_state() {
             break;
     }
 
-    std::vector<double> inputs;
+    size_t k = 0;
 
     // danger detection
-    inputs.push_back(is_danger_at(p_left) ? 1.0 : 0.0);
-    inputs.push_back(is_danger_at(p_straight) ? 1.0 : 0.0);
-    inputs.push_back(is_danger_at(p_right) ? 1.0 : 0.0);
+    inputs[k++] = is_danger_at(p_left) ? 1.0 : 0.0;
+    inputs[k++] = is_danger_at(p_straight) ? 1.0 : 0.0;
+    inputs[k++] = is_danger_at(p_right) ? 1.0 : 0.0;
 
     // food direction
     bool food_left = false;
@@ -157,48 +171,97 @@ std::vector<double> World::get_game_state() {
     // map food direction to relative directions based on current heading
     switch (dir) {
         case UP:
-            inputs.push_back(food_left ? 1.0 : 0.0);  // Food is Left
-            inputs.push_back(food_right ? 1.0 : 0.0); // Food is Right
-            inputs.push_back(food_up ? 1.0 : 0.0);    // Food is Straight
-            inputs.push_back(food_down ? 1.0 : 0.0);  // Food is Back
+            inputs[k++] = food_left ? 1.0 : 0.0;  // Food is Left
+            inputs[k++] = food_right ? 1.0 : 0.0; // Food is Right
+            inputs[k++] = food_up ? 1.0 : 0.0;    // Food is Straight
+            inputs[k++] = food_down ? 1.0 : 0.0;  // Food is Back
             break;
         case DOWN:
-            inputs.push_back(food_right ? 1.0 : 0.0); // Food is Left
-            inputs.push_back(food_left ? 1.0 : 0.0);  // Food is Right
-            inputs.push_back(food_down ? 1.0 : 0.0);  // Food is Straight
-            inputs.push_back(food_up ? 1.0 : 0.0);    // Food is Back
+            inputs[k++] = food_right ? 1.0 : 0.0; // Food is Left
+            inputs[k++] = food_left ? 1.0 : 0.0;  // Food is Right
+            inputs[k++] = food_down ? 1.0 : 0.0;  // Food is Straight
+            inputs[k++] = food_up ? 1.0 : 0.0;    // Food is Back
             break;
         case LEFT:
-            inputs.push_back(food_down ? 1.0 : 0.0);  // Food is Left
-            inputs.push_back(food_up ? 1.0 : 0.0);    // Food is Right
-            inputs.push_back(food_left ? 1.0 : 0.0);  // Food is Straight
-            inputs.push_back(food_right ? 1.0 : 0.0); // Food is Back
+            inputs[k++] = food_down ? 1.0 : 0.0;  // Food is Left
+            inputs[k++] = food_up ? 1.0 : 0.0;    // Food is Right
+            inputs[k++] = food_left ? 1.0 : 0.0;  // Food is Straight
+            inputs[k++] = food_right ? 1.0 : 0.0; // Food is Back
             break;
         case RIGHT:
-            inputs.push_back(food_up ? 1.0 : 0.0);    // Food is Left
-            inputs.push_back(food_down ? 1.0 : 0.0);  // Food is Right
-            inputs.push_back(food_right ? 1.0 : 0.0); // Food is Straight
-            inputs.push_back(food_left ? 1.0 : 0.0);  // Food is Back
+            inputs[k++] = food_up ? 1.0 : 0.0;    // Food is Left
+            inputs[k++] = food_down ? 1.0 : 0.0;  // Food is Right
+            inputs[k++] = food_right ? 1.0 : 0.0; // Food is Straight
+            inputs[k++] = food_left ? 1.0 : 0.0;  // Food is Back
             break;
     }
 
     // tail direction
-    inputs.push_back(tail.x < head.x ? 1.0 : 0.0); // Tail is Left
-    inputs.push_back(tail.x > head.x ? 1.0 : 0.0); // Tail is Right
-    inputs.push_back(tail.y < head.y ? 1.0 : 0.0); // Tail is Up
-    inputs.push_back(tail.y > head.y ? 1.0 : 0.0); // Tail is Down
+    inputs[k++] = tail.x < head.x ? 1.0 : 0.0; // Tail is Left
+    inputs[k++] = tail.x > head.x ? 1.0 : 0.0; // Tail is Right
+    inputs[k++] = tail.y < head.y ? 1.0 : 0.0; // Tail is Up
+    inputs[k++] = tail.y > head.y ? 1.0 : 0.0; // Tail is Down
+}
+
+void World::get_ray_state(double* inputs) {
+    // compass directions clockwise from UP; UP, RIGHT, DOWN, LEFT sit at 0, 2, 4, 6
+    static const int compass[8][2] = {
+        {0, -1}, {1, -1}, {1, 0}, {1, 1}, {0, 1}, {-1, 1}, {-1, 0}, {-1, -1}
+    };
+    int columns = width / cell_size;
+    int rows = height / cell_size;
+    if (columns > OccupancyGrid::MAX_SIZE || rows > OccupancyGrid::MAX_SIZE) {
+        throw std::invalid_argument("Ray sensors support boards of at most 64x64 cells.");
+    }
+
+    Point head = snake.body.front();
+    Point food_pos = food.position;
+    int heading = 0;
+    switch (snake.direction) {
+        case UP:    heading = 0; break;
+        case RIGHT: heading = 2; break;
+        case DOWN:  heading = 4; break;
+        case LEFT:  heading = 6; break;
+    }
+
+    size_t out = 0;
 
-    return inputs; // Final 11 inputs
+    // rays relative to the heading: straight first, then clockwise
+    for (int ray = 0; ray < 8; ++ray) {
+        int dx = compass[(heading + ray) % 8][0];
+        int dy = compass[(heading + ray) % 8][1];
+
+        // steps until the ray leaves the board
+        int wall_x = dx > 0 ? columns - head.x : (dx < 0 ? head.x + 1 : INT_MAX);
+        int wall_y = dy > 0 ? rows - head.y : (dy < 0 ? head.y + 1 : INT_MAX);
+        int wall = std::max(1, std::min(wall_x, wall_y));
+
+        int body = snake.occupancy.distanceTo(head, dx, dy);
+
+        // the food is on the ray if it is a positive multiple of (dx, dy) away
+        int food_dist = 0;
+        int fx = food_pos.x - head.x;
+        int fy = food_pos.y - head.y;
+        int k = dx != 0 ? fx * dx : fy * dy;
+        if (k > 0 && fx == k * dx && fy == k * dy) food_dist = k;
+
+        inputs[out++] = 1.0 / wall;
+        inputs[out++] = body > 0 ? 1.0 / body : 0.0;
+        inputs[out++] = food_dist > 0 ? 1.0 / food_dist : 0.0;
+    }
 }
 
 void World::handle_ai_input(NeuralNetwork& brain) {
-    std::vector<double> inputs = get_game_state();
+    // sized for the largest sensor layout, so no allocation per step
+    double inputs[RAY_INPUT_NODES];
+    get_game_state(brain.getTopology()[0], inputs);
 
-    std::vector<double> outputs = brain.feedForward(inputs);
-
-    auto max_it = std::max_element(outputs.begin(), outputs.end());
-    int decision = std::distance(outputs.begin(), max_it);
+    const double* outputs = brain.feedForward(inputs);
+    const double* max_it = std::max_element(outputs, outputs + brain.getTopology().back());
+    apply_action((int)(max_it - outputs));
+}
 
+void World::apply_action(int decision) {
     Direction current_dir = snake.direction;
     Direction new_dir = current_dir;
 
@@ -236,6 +299,13 @@ bool World::is_danger_at(Point p) {
     return snake.is_point_on_body(p, true); 
 }
 
+uint64_t World::state_hash() const {
+    return snake.body_hash
+         ^ zobristKey(ZOBRIST_HEAD, snake.body.front(), 0)
+         ^ zobristKey(ZOBRIST_DIRECTION, Point{0, 0}, snake.direction)
+         ^ zobristKey(ZOBRIST_FOOD, food.position, 0);
+}
+
 int World::getScore() const {
     return this->score;
 }
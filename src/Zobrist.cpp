@@ -0,0 +1,45 @@
+#include "Zobrist.hpp"
+
+VisitedStates::VisitedStates(size_t capacity) : count(0), epoch(1) {
+    size_t size = 16;
+    while (size < 2 * capacity) size *= 2;
+    slots.assign(size, Slot{ 0, 0 });
+}
+
+void VisitedStates::clear() {
+    count = 0;
+    epoch++;
+    if (epoch == 0) {
+        // the tags wrapped around, so old slots could look current again
+        slots.assign(slots.size(), Slot{ 0, 0 });
+        epoch = 1;
+    }
+}
+
+bool VisitedStates::insert(uint64_t hash) {
+    size_t mask = slots.size() - 1;
+    // the hashes are already uniformly mixed, the low bits index directly
+    for (size_t i = (size_t)hash & mask;; i = (i + 1) & mask) {
+        Slot& slot = slots[i];
+        if (slot.epoch != epoch) {
+            slot.hash = hash;
+            slot.epoch = epoch;
+            if (++count * 2 > slots.size()) grow();
+            return false;
+        }
+        if (slot.hash == hash) return true;
+    }
+}
+
+void VisitedStates::grow() {
+    std::vector<Slot> old;
+    old.swap(slots);
+    slots.assign(old.size() * 2, Slot{ 0, 0 });
+    size_t mask = slots.size() - 1;
+    for (const Slot& slot : old) {
+        if (slot.epoch != epoch) continue;
+        size_t i = (size_t)slot.hash & mask;
+        while (slots[i].epoch == epoch) i = (i + 1) & mask;
+        slots[i] = slot;
+    }
+}
@@ -1,10 +1,87 @@
 #include "Trainer.hpp"
+#include "CommandLine.hpp"
+#include "Sweep.hpp"
+#include "Trace.hpp"
+#include "Headless.hpp"
+#include "OptimizerBenchmark.hpp"
+#include "KernelBenchmark.hpp"
+#include "GenerationLog.hpp"
+#include "Trajectory.hpp"
+#include "Metrics.hpp"
+#include <iostream>
 
-int main(int argc, char* argv[]) {
-    (void)argc; (void)argv; // Suppress unused parameter warnings
+static int run(const CommandLine& commandLine) {
+    if (commandLine.mode == RunMode::Headless) {
+        return runHeadless(commandLine.headless);
+    }
+    if (commandLine.mode == RunMode::Sweep) {
+        return runSweep(commandLine.sweep);
+    }
+    if (commandLine.mode == RunMode::AllocationCheck) {
+        return runAllocationCheck(commandLine.headless);
+    }
+    if (commandLine.mode == RunMode::ScreeningComparison) {
+        return runScreeningComparison(commandLine.headless);
+    }
+    if (commandLine.mode == RunMode::Benchmark) {
+        return runOptimizerBenchmark(commandLine.benchmark);
+    }
+    if (commandLine.mode == RunMode::PrecisionComparison) {
+        return runPrecisionComparison(commandLine.headless);
+    }
+    if (commandLine.mode == RunMode::ScalingReport) {
+        return runScalingReport(commandLine.headless);
+    }
+    if (commandLine.mode == RunMode::SparseBenchmark) {
+        return runSparseBenchmark(commandLine.sparseBenchmark);
+    }
+    if (commandLine.mode == RunMode::LayerBenchmark) {
+        return runLayerBenchmark(commandLine.layerBenchmark);
+    }
+    if (commandLine.mode == RunMode::DiffTest) {
+        return runDiffTest(commandLine.diffTest);
+    }
+    if (commandLine.mode == RunMode::ExportCheck) {
+        return runExportCheck(commandLine.exportCheckDir);
+    }
+    if (commandLine.mode == RunMode::TrajectorySummary) {
+        return summarizeTrajectories(commandLine.trajectoryPath);
+    }
+    if (commandLine.mode == RunMode::TailLog) {
+        return tailGenerationLog(commandLine.tailLogPath);
+    }
 
-    Trainer trainer;
+    Trainer trainer(commandLine.trainer);
     trainer.run();
 
     return 0;
 }
+
+int main(int argc, char* argv[]) {
+    CommandLine commandLine;
+    if (!parseCommandLine(argc, argv, commandLine)) {
+        return 1;
+    }
+
+    if (!commandLine.tracePath.empty() && !traceCompiledIn()) {
+        std::cerr << "Tracing is not compiled in, rebuild with 'make clean && make TRACE=1'" << std::endl;
+    }
+    setTraceThreadName("main");
+
+    MetricsServer metrics;
+    if (!commandLine.metricsSocket.empty()) {
+        if (metrics.start(commandLine.metricsSocket)) {
+            std::cout << "Metrics served on " << commandLine.metricsSocket << std::endl;
+        } else {
+            std::cerr << "Could not serve metrics on " << commandLine.metricsSocket << std::endl;
+        }
+    }
+
+    int status = run(commandLine);
+    metrics.stop();
+
+    if (!commandLine.tracePath.empty() && writeTrace(commandLine.tracePath)) {
+        std::cout << "Trace written to " << commandLine.tracePath << std::endl;
+    }
+    return status;
+}
@@ -0,0 +1,103 @@
+/*
+ * Link check of the simulation library, built and run by 'make difftest'.
+ *
+ * A plain C program against include/snakesim.h and -lsnakesim: it only
+ * links if every symbol the library needs is inside it, and then steps a
+ * few environments on worker threads and checks what comes back.
+ */
+
+#include "snakesim.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+
+#define ENVS 8
+#define STEPS 2000
+#define STARVATION 150
+
+static int fail(const char* what) {
+    printf("snakesim check: %s\n", what);
+    return 1;
+}
+
+/*
+ * A snake circling on four cells never eats or dies, so it must starve on
+ * step STARVATION + 1 of each episode, like a game in the trainer's
+ * evaluator, and not a step earlier.
+ */
+static int check_starvation(void) {
+    snakesim_envs* envs = snakesim_create(1, 40, 30, 11, STARVATION, 1);
+    uint64_t seed = 7;
+    int32_t action = 2;
+    double observation[11];
+    double reward;
+    uint8_t done;
+    const char* problem = NULL;
+    int episode, s;
+
+    if (envs == NULL) return fail("could not create the circling snake");
+    if (snakesim_reset(envs, &seed, observation) != 0) problem = "reset failed";
+    for (episode = 0; episode < 2 && problem == NULL; ++episode) {
+        for (s = 1; s <= STARVATION + 1 && problem == NULL; ++s) {
+            if (snakesim_step(envs, &action, observation, &reward, &done) != 0) {
+                problem = "step failed";
+            } else if (reward != 0.0) {
+                problem = "the circling snake ate or died";
+            } else if (done != (s == STARVATION + 1)) {
+                problem = "starvation ended the episode on the wrong step";
+            }
+        }
+    }
+    snakesim_destroy(envs);
+    return problem == NULL ? 0 : fail(problem);
+}
+
+int main(void) {
+    uint64_t seeds[ENVS];
+    int32_t actions[ENVS];
+    int32_t scores[ENVS];
+    double rewards[ENVS];
+    uint8_t dones[ENVS];
+    double* observations;
+    snakesim_envs* envs;
+    uint32_t size = 24;
+    uint32_t state = 1;
+    long finished = 0;
+    int i, s;
+
+    if (snakesim_abi_version() != SNAKESIM_ABI_VERSION) return fail("ABI version differs from the header");
+    if (snakesim_create(ENVS, 10, 10, size, 150, 2) != NULL) return fail("accepted a board that is too small");
+    if (check_starvation() != 0) return 1;
+
+    envs = snakesim_create(ENVS, 40, 30, size, 150, 2);
+    if (envs == NULL) return fail("could not create the environments");
+    if (snakesim_count(envs) != ENVS || snakesim_observation_size(envs) != size) {
+        return fail("count or observation size differs");
+    }
+    observations = malloc(sizeof(double) * ENVS * size);
+    for (i = 0; i < ENVS; ++i) seeds[i] = 1000 + (uint64_t)i;
+    if (observations == NULL || snakesim_reset(envs, seeds, observations) != 0) return fail("reset failed");
+
+    for (s = 0; s < STEPS; ++s) {
+        for (i = 0; i < ENVS; ++i) {
+            /* mostly straight, a turn now and then */
+            state = state * 1103515245u + 12345u;
+            actions[i] = (state >> 16) % 8 == 0 ? (int32_t)((state >> 20) % 3) : 1;
+        }
+        if (snakesim_step(envs, actions, observations, rewards, dones) != 0) return fail("step failed");
+        if (snakesim_scores(envs, scores) != 0) return fail("scores failed");
+        for (i = 0; i < ENVS; ++i) {
+            if (dones[i] > 1 || scores[i] < 0) return fail("done flag or score out of range");
+            if (rewards[i] != 0.0 && rewards[i] != 1.0 && rewards[i] != -1.0) return fail("reward out of range");
+            finished += dones[i];
+        }
+    }
+    if (snakesim_step(envs, NULL, observations, rewards, dones) != SNAKESIM_ERROR_ARGUMENT) {
+        return fail("accepted missing actions");
+    }
+
+    snakesim_destroy(envs);
+    free(observations);
+    printf("snakesim check: %d environments, %d steps, %ld episodes finished\n", ENVS, STEPS, finished);
+    return 0;
+}